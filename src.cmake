@@ -35,6 +35,7 @@ set(COMMONLIST
     ${COMMON_DIR}/Math.h
     ${COMMON_DIR}/Optional.h
     ${COMMON_DIR}/Platform.h
+    ${COMMON_DIR}/Serialize.cpp
     ${COMMON_DIR}/Serialize.h
     ${COMMON_DIR}/StackTrace.h
     ${COMMON_DIR}/String.cpp
@@ -44,6 +45,8 @@ set(COMMONLIST
     ${COMMON_DIR}/Type.h
     ${COMMON_DIR}/Util.cpp
     ${COMMON_DIR}/Util.h
+    ${COMMON_DIR}/cm/cm_cache.cpp
+    ${COMMON_DIR}/cm/cm_grid.cpp
     ${COMMON_DIR}/cm/cm_load.cpp
     ${COMMON_DIR}/cm/cm_local.h
     ${COMMON_DIR}/cm/cm_patch.cpp
@@ -200,6 +203,12 @@ set(ENGINELIST
     ${ENGINE_DIR}/framework/Rcon.h
     ${ENGINE_DIR}/framework/Network.h
     ${ENGINE_DIR}/framework/Network.cpp
+    ${ENGINE_DIR}/framework/Profiler.cpp
+    ${ENGINE_DIR}/framework/Profiler.h
+    ${ENGINE_DIR}/framework/SyscallStats.cpp
+    ${ENGINE_DIR}/framework/SyscallStats.h
+    ${ENGINE_DIR}/framework/WorkerPool.cpp
+    ${ENGINE_DIR}/framework/WorkerPool.h
     ${ENGINE_DIR}/qcommon/md5.cpp
     ${ENGINE_DIR}/sys/con_common.h
     ${ENGINE_DIR}/sys/con_common.cpp
@@ -220,6 +229,11 @@ endif()
 # Tests runnable for any engine variant
 set(ENGINETESTLIST ${COMMONTESTLIST}
     ${ENGINE_DIR}/framework/CommandSystemTest.cpp
+    ${ENGINE_DIR}/framework/ProfilerTest.cpp
+    ${ENGINE_DIR}/framework/SyscallStatsTest.cpp
+    ${ENGINE_DIR}/framework/WorkerPoolTest.cpp
+    ${COMMON_DIR}/IPC/ChannelTest.cpp
+    ${ENGINE_DIR}/qcommon/msg_test.cpp
 )
 
 set(QCOMMONLIST
@@ -279,6 +279,15 @@ That keyword was added in C++11, all compilers should now support it. */
 	#define CONSTEXPR_FUNCTION_RELAXED
 #endif
 
+/* Only the engine runs game code on several threads, e.g. collision queries,
+shader loading or IPC messages, the VMs are single threaded and should not pay
+for thread local storage. */
+#ifdef BUILD_ENGINE
+	#define ENGINE_THREAD_LOCAL thread_local
+#else
+	#define ENGINE_THREAD_LOCAL
+#endif
+
 // Compiler specificities we can't disable.
 
 #if defined(__MINGW32__) && defined(__i386__)
@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #if defined(BUILD_ENGINE)
 #include "minizip/unzip.h"
+#include "engine/framework/WorkerPool.h"
 #endif
 
 #ifdef BUILD_VM
@@ -52,6 +53,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #else
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <dirent.h>
 #include <unistd.h>
@@ -128,6 +130,8 @@ namespace FS {
 static Cvar::Cvar<bool> fs_legacypaks("fs_legacypaks", "also load pk3s, ignoring version", Cvar::NONE, false);
 static Cvar::Cvar<int> fs_maxSymlinkDepth("fs_maxSymlinkDepth", "max depth of symlinks in zip paks (0 means disabled)", Cvar::NONE, 1);
 static Cvar::Cvar<std::string> fs_pakprefixes("fs_pakprefixes", "prefixes to look for paks to load", 0, "");
+static Cvar::Range<Cvar::Cvar<int>> fs_loadThreads("fs_loadThreads", "number of worker threads reading the file lists of dependency paks, 0 to do it on the main thread", Cvar::NONE, 4, 0, 64);
+static Cvar::Cvar<bool> fs_pakDirectoryCache("fs_pakDirectoryCache", "cache the file lists of dpk files in the homepath", Cvar::NONE, true);
 
 bool UseLegacyPaks()
 {
@@ -1082,6 +1086,358 @@ static std::unordered_set<std::pair<std::string, std::string>, stdStringPairHash
 static std::unordered_map<std::string, std::pair<uint32_t, offset_t>, Str::IHash, Str::IEqual> fileMap;
 
 #ifndef BUILD_VM
+// File list of a zip pak, as found in its central directory. It is kept
+// across ClearPaks and in the homepath, and is only valid as long as the size
+// and modification time of the pak are the same.
+struct PakDirectory {
+	struct Entry {
+		std::string filename;
+		offset_t offset;
+		uint32_t crc;
+	};
+
+	offset_t size;
+	int64_t mtime;
+	std::vector<Entry> entries;
+};
+
+// Parsed directories of zip paks, indexed by path
+static std::unordered_map<std::string, PakDirectory> pakDirectories;
+
+static Sys::WorkerPool pakWorkers("pak loading");
+
+// Bump when the layout of the cache files changes
+static const uint32_t PAK_DIRECTORY_CACHE_VERSION = 1;
+
+static bool StatPak(int fd, offset_t& size, int64_t& mtime)
+{
+	my_stat_t st;
+	if (my_fstat(fd, &st) == -1)
+		return false;
+	size = st.st_size;
+	mtime = st.st_mtime;
+	return true;
+}
+
+static std::string PakDirectoryCachePath(Str::StringRef pakPath)
+{
+	uint32_t hash = crc32(0, reinterpret_cast<const Bytef*>(pakPath.data()), pakPath.size());
+	return Str::Format("cache/pakdirs/%08x.bin", hash);
+}
+
+// Read the cached directory of a pak, dir.size and dir.mtime must be set
+static bool ReadPakDirectoryCache(Str::StringRef pakPath, PakDirectory& dir)
+{
+	if (!fs_pakDirectoryCache.Get() || homePath.empty())
+		return false;
+
+	std::error_code err;
+	File cacheFile = HomePath::OpenRead(PakDirectoryCachePath(pakPath), err);
+	if (err)
+		return false;
+	std::string data = cacheFile.ReadAll(err);
+	if (err)
+		return false;
+
+	size_t pos = 0;
+	auto get = [&data, &pos](void* out, size_t length) {
+		if (data.size() - pos < length)
+			return false;
+		memcpy(out, data.data() + pos, length);
+		pos += length;
+		return true;
+	};
+
+	uint32_t version, pathLength, count;
+	uint64_t size;
+	int64_t mtime;
+	if (!get(&version, sizeof(version)) || version != PAK_DIRECTORY_CACHE_VERSION)
+		return false;
+	if (!get(&size, sizeof(size)) || !get(&mtime, sizeof(mtime)) || size != uint64_t(dir.size) || mtime != dir.mtime)
+		return false;
+	if (!get(&pathLength, sizeof(pathLength)) || data.size() - pos < pathLength)
+		return false;
+	if (data.compare(pos, pathLength, pakPath.data(), pakPath.size()) != 0)
+		return false;
+	pos += pathLength;
+	if (!get(&count, sizeof(count)))
+		return false;
+
+	dir.entries.clear();
+	dir.entries.reserve(std::min<size_t>(count, data.size() / 16));
+	for (uint32_t i = 0; i < count; i++) {
+		PakDirectory::Entry entry;
+		uint32_t nameLength;
+		uint64_t offset;
+		if (!get(&nameLength, sizeof(nameLength)) || data.size() - pos < nameLength)
+			return false;
+		entry.filename.assign(data.data() + pos, nameLength);
+		pos += nameLength;
+		if (!get(&offset, sizeof(offset)) || !get(&entry.crc, sizeof(entry.crc)))
+			return false;
+		entry.offset = offset;
+		dir.entries.push_back(std::move(entry));
+	}
+
+	return pos == data.size();
+}
+
+static void WritePakDirectoryCache(Str::StringRef pakPath, const PakDirectory& dir)
+{
+	if (!fs_pakDirectoryCache.Get() || homePath.empty())
+		return;
+
+	std::string data;
+	auto put = [&data](const void* in, size_t length) {
+		data.append(static_cast<const char*>(in), length);
+	};
+
+	uint32_t version = PAK_DIRECTORY_CACHE_VERSION;
+	uint64_t size = dir.size;
+	uint32_t pathLength = pakPath.size();
+	uint32_t count = dir.entries.size();
+	put(&version, sizeof(version));
+	put(&size, sizeof(size));
+	put(&dir.mtime, sizeof(dir.mtime));
+	put(&pathLength, sizeof(pathLength));
+	put(pakPath.data(), pathLength);
+	put(&count, sizeof(count));
+	for (const PakDirectory::Entry& entry: dir.entries) {
+		uint32_t nameLength = entry.filename.size();
+		uint64_t offset = entry.offset;
+		put(&nameLength, sizeof(nameLength));
+		put(entry.filename.data(), nameLength);
+		put(&offset, sizeof(offset));
+		put(&entry.crc, sizeof(entry.crc));
+	}
+
+	// Write to a temporary file first so that a reader never sees half of it.
+	// Only one thread at a time handles a given pak, so the name is unique.
+	std::error_code err;
+	std::string cachePath = PakDirectoryCachePath(pakPath);
+	std::string tempPath = cachePath + ".tmp";
+	{
+		File cacheFile = HomePath::OpenWrite(tempPath, err);
+		if (err)
+			return;
+		cacheFile.Write(data.data(), data.size(), err);
+		if (err)
+			return;
+		cacheFile.Close(err);
+		if (err)
+			return;
+	}
+	HomePath::MoveFile(cachePath, tempPath, err);
+}
+
+// Get the directory of a zip pak from the homepath cache, or else from the pak
+// itself. Safe to call from worker threads as it doesn't touch pakDirectories.
+static bool LoadPakDirectory(Str::StringRef pakPath, int fd, PakDirectory& dir, std::error_code& err)
+{
+	if (!StatPak(fd, dir.size, dir.mtime)) {
+		SetErrorCodeSystem(err);
+		return false;
+	}
+
+	if (ReadPakDirectoryCache(pakPath, dir)) {
+		ClearErrorCode(err);
+		return true;
+	}
+
+	ZipArchive zipFile = ZipArchive::Open(fd, err);
+	if (err)
+		return false;
+	dir.entries.clear();
+	zipFile.ForEachFile([&dir](Str::StringRef filename, offset_t offset, uint32_t crc) {
+		dir.entries.push_back({filename, offset, crc});
+	}, err);
+	if (err)
+		return false;
+
+	WritePakDirectoryCache(pakPath, dir);
+	return true;
+}
+
+// Find the directory of an open zip pak, reusing the one parsed earlier if the
+// pak didn't change since
+static const PakDirectory* GetPakDirectory(const PakInfo& pak, int fd, std::error_code& err)
+{
+	auto it = pakDirectories.find(pak.path);
+	if (it != pakDirectories.end()) {
+		offset_t size;
+		int64_t mtime;
+		if (StatPak(fd, size, mtime) && size == it->second.size && mtime == it->second.mtime) {
+			ClearErrorCode(err);
+			return &it->second;
+		}
+	}
+
+	PakDirectory dir;
+	if (!LoadPakDirectory(pak.path, fd, dir, err))
+		return nullptr;
+	return &(pakDirectories[pak.path] = std::move(dir));
+}
+
+// Read the directories of the zip paks which are going to be loaded, in
+// parallel. Errors are ignored: they are reported when the pak is loaded.
+static void PrefetchPakDirectories(const std::vector<const PakInfo*>& paks)
+{
+	std::vector<const PakInfo*> zipPaks;
+	for (const PakInfo* pak: paks) {
+		if (pak->type == pakType_t::PAK_ZIP && !pakDirectories.count(pak->path))
+			zipPaks.push_back(pak);
+	}
+
+	if (zipPaks.size() < 2)
+		return;
+
+	std::vector<PakDirectory> dirs(zipPaks.size());
+	std::vector<char> loaded(zipPaks.size());
+	pakWorkers.SetNumThreads(fs_loadThreads.Get());
+	pakWorkers.ParallelFor(zipPaks.size(), [&zipPaks, &dirs, &loaded](int i) {
+		int fd = my_open(zipPaks[i]->path, openMode_t::MODE_READ);
+		if (fd == -1)
+			return;
+		std::error_code err;
+		bool ok = LoadPakDirectory(zipPaks[i]->path, fd, dirs[i], err);
+		close(fd);
+		loaded[i] = ok;
+	});
+
+	for (size_t i = 0; i < zipPaks.size(); i++) {
+		if (loaded[i])
+			pakDirectories[zipPaks[i]->path] = std::move(dirs[i]);
+	}
+}
+
+// Read-only memory mapping of a whole zip pak
+class PakMapping {
+public:
+	PakMapping(const PakMapping&) = delete;
+	PakMapping& operator=(const PakMapping&) = delete;
+
+	~PakMapping()
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(base);
+#else
+		munmap(const_cast<char*>(base), size);
+#endif
+	}
+
+	// Returns null if the pak can't be mapped, for example if it doesn't fit
+	// in the address space
+	static std::shared_ptr<const PakMapping> Map(int fd)
+	{
+		my_stat_t st;
+		if (my_fstat(fd, &st) == -1 || st.st_size <= 0 || uint64_t(st.st_size) > std::numeric_limits<size_t>::max())
+			return nullptr;
+		size_t size = st.st_size;
+
+#ifdef _WIN32
+		HANDLE mapping = CreateFileMappingW(reinterpret_cast<HANDLE>(_get_osfhandle(fd)), nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping)
+			return nullptr;
+		void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+		CloseHandle(mapping);
+		if (!base)
+			return nullptr;
+#else
+		void* base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (base == MAP_FAILED)
+			return nullptr;
+#endif
+
+		return std::shared_ptr<const PakMapping>(new PakMapping(static_cast<const char*>(base), size));
+	}
+
+	const char* const base;
+	const size_t size;
+
+	// Whether the CRC of the stored file at a central directory offset
+	// matched, so that it is only checked once. Guarded by fileViewMutex.
+	mutable std::unordered_map<offset_t, bool> checkedFiles;
+
+private:
+	PakMapping(const char* base, size_t size)
+		: base(base), size(size) {}
+};
+
+// Mappings of the loaded zip paks, indexed like loadedPaks and created on
+// first use, and the files inflated by ReadFileView which are still in use
+static std::mutex fileViewMutex;
+static std::vector<std::shared_ptr<const PakMapping>> pakMappings;
+static std::map<std::pair<uint32_t, offset_t>, std::weak_ptr<const std::string>> inflatedFiles;
+
+static uint32_t ZipShort(const char* p)
+{
+	const byte* b = reinterpret_cast<const byte*>(p);
+	return b[0] | (b[1] << 8);
+}
+
+static uint32_t ZipLong(const char* p)
+{
+	const byte* b = reinterpret_cast<const byte*>(p);
+	return b[0] | (b[1] << 8) | (b[2] << 16) | (uint32_t(b[3]) << 24);
+}
+
+// Find the data of a file that is stored without compression in a mapped zip
+// pak, given the offset of its central directory entry. Returns false if the
+// file has to go through minizip: it is compressed, encrypted, a symlink, in
+// zip64 format, or the pak can't be mapped.
+static bool FindStoredFile(uint32_t pakIndex, offset_t offset, std::shared_ptr<const PakMapping>& mapping, const char*& data, size_t& length)
+{
+	const LoadedPakInfo& pak = loadedPaks[pakIndex];
+	{
+		std::lock_guard<std::mutex> lock(fileViewMutex);
+		if (pakMappings.size() <= pakIndex)
+			pakMappings.resize(loadedPaks.size());
+		if (!pakMappings[pakIndex])
+			pakMappings[pakIndex] = PakMapping::Map(pak.fd);
+		mapping = pakMappings[pakIndex];
+	}
+	if (!mapping)
+		return false;
+
+	// Central directory entry
+	const char* base = mapping->base;
+	if (offset > mapping->size || mapping->size - offset < 46 || ZipLong(base + offset) != 0x02014b50)
+		return false;
+	const char* entry = base + offset;
+	uint32_t flags = ZipShort(entry + 8);
+	uint32_t method = ZipShort(entry + 10);
+	uint32_t crc = ZipLong(entry + 16);
+	uint32_t compressedSize = ZipLong(entry + 20);
+	uint32_t size = ZipLong(entry + 24);
+	uint32_t fileType = ZipLong(entry + 38) >> 16 & 0170000;
+	uint32_t localOffset = ZipLong(entry + 42);
+	if ((flags & 1) || method != 0 || compressedSize != size || size == 0xffffffff || localOffset == 0xffffffff || fileType == 0120000)
+		return false;
+
+	// Local file header, whose name and extra field may differ from the central ones
+	if (mapping->size - 30 < localOffset || ZipLong(base + localOffset) != 0x04034b50)
+		return false;
+	size_t dataOffset = size_t(localOffset) + 30 + ZipShort(base + localOffset + 26) + ZipShort(base + localOffset + 28);
+	if (dataOffset > mapping->size || mapping->size - dataOffset < size)
+		return false;
+
+	data = base + dataOffset;
+	length = size;
+
+	// Same check as the one done by minizip when closing the file, done on
+	// the first read only as it touches every page of the file
+	{
+		std::lock_guard<std::mutex> lock(fileViewMutex);
+		auto it = mapping->checkedFiles.find(offset);
+		if (it != mapping->checkedFiles.end())
+			return it->second;
+	}
+	bool valid = crc32(0, reinterpret_cast<const Bytef*>(data), length) == crc;
+	std::lock_guard<std::mutex> lock(fileViewMutex);
+	mapping->checkedFiles[offset] = valid;
+	return valid;
+}
+
 /* Parse the deleted file list file of a package.
 
 Each line of the file is the pak basename a file must
@@ -1155,6 +1511,7 @@ static void InternalLoadPak(
 // Each line of the dependencies file is a name followed by an optional version
 static void ParseDeps(const PakInfo& parent, Str::StringRef depsData, Str::StringRef prefix, std::error_code& err)
 {
+	std::vector<const PakInfo*> deps;
 	auto lineStart = depsData.begin();
 	int line = 0;
 	while (lineStart != depsData.end()) {
@@ -1179,7 +1536,7 @@ static void ParseDeps(const PakInfo& parent, Str::StringRef depsData, Str::Strin
 		while (lineStart != lineEnd && Str::cisspace(*lineStart))
 			lineStart++;
 
-		// If this is the end of the line, load a package by name
+		// If this is the end of the line, find a package by name
 		if (lineStart == lineEnd) {
 			const PakInfo* pak = FindPak(name);
 			if (!pak) {
@@ -1187,9 +1544,7 @@ static void ParseDeps(const PakInfo& parent, Str::StringRef depsData, Str::Strin
 				SetErrorCodeFilesystem(err, filesystem_error::missing_dependency);
 				return;
 			}
-			InternalLoadPak(*pak, Util::nullopt, prefix, true, err);
-			if (err)
-				return;
+			deps.push_back(pak);
 			lineStart = lineEnd == depsData.end() ? lineEnd : lineEnd + 1;
 			continue;
 		}
@@ -1203,7 +1558,7 @@ static void ParseDeps(const PakInfo& parent, Str::StringRef depsData, Str::Strin
 		while (lineStart != lineEnd && Str::cisspace(*lineStart))
 			lineStart++;
 
-		// If this is the end of the line, load a package with an explicit version
+		// If this is the end of the line, find a package with an explicit version
 		if (lineStart == lineEnd) {
 			const PakInfo* pak = FindPak(name, version);
 			if (!pak) {
@@ -1211,9 +1566,7 @@ static void ParseDeps(const PakInfo& parent, Str::StringRef depsData, Str::Strin
 				SetErrorCodeFilesystem(err, filesystem_error::missing_dependency);
 				return;
 			}
-			InternalLoadPak(*pak, Util::nullopt, prefix, true, err);
-			if (err)
-				return;
+			deps.push_back(pak);
 			lineStart = lineEnd == depsData.end() ? lineEnd : lineEnd + 1;
 			continue;
 		}
@@ -1222,6 +1575,16 @@ static void ParseDeps(const PakInfo& parent, Str::StringRef depsData, Str::Strin
 		fsLogs.Warn("Invalid dependency specification on line %d in %s", line, Path::Build(parent.path, PAK_DEPS_FILE));
 		lineStart = lineEnd == depsData.end() ? lineEnd : lineEnd + 1;
 	}
+
+	// The file lists of the dependencies are read in parallel, but they are
+	// loaded in order since the first pak providing a file wins
+	PrefetchPakDirectories(deps);
+
+	for (const PakInfo* pak: deps) {
+		InternalLoadPak(*pak, Util::nullopt, prefix, true, err);
+		if (err)
+			return;
+	}
 }
 
 /* The code is expected to be only reliable for ignoring deleted files
@@ -1324,51 +1687,56 @@ static void InternalLoadPak(
 			return;
 		}
 
-		// Open zip
-		zipFile = ZipArchive::Open(loadedPak.fd, err);
+		// Get the file list, possibly parsed earlier or cached in the homepath
+		const PakDirectory* dir = GetPakDirectory(pak, loadedPak.fd, err);
 		if (err)
 			return;
 
-		// Get the file list and calculate the checksum of the package (checksum of all file checksums)
+		// Calculate the checksum of the package (checksum of all file checksums)
 		realChecksum = crc32(0, Z_NULL, 0);
-		zipFile.ForEachFile([&pak, &realChecksum, &pathPrefix, &hasDeps, &hasDeleted, &depsOffset, &deletedOffset, &isLegacy](Str::StringRef filename, offset_t offset, uint32_t crc) {
-			// Note that 'return' is effectively 'continue' since we are in a lambda
+		for (const PakDirectory::Entry& entry: dir->entries) {
+			const std::string& filename = entry.filename;
 			if (!Str::IsPrefix(pathPrefix, filename)
 				&& filename != PAK_DELETED_FILE
 				&& filename != PAK_DEPS_FILE)
-				return;
+				continue;
 			if (Str::IsSuffix("/", filename))
-				return;
+				continue;
 			if (!Path::IsValid(filename, false)) {
 				fsLogs.Warn("Invalid filename '%s' in pak '%s'", filename, pak.path);
-				return;
+				continue;
 			}
 
 			// Legacy paks don't have version neither checksum
 			if (!isLegacy) {
-				realChecksum = crc32(*realChecksum, reinterpret_cast<const Bytef*>(&crc), sizeof(crc));
+				realChecksum = crc32(*realChecksum, reinterpret_cast<const Bytef*>(&entry.crc), sizeof(entry.crc));
 			}
 
 			if (!isLegacy && filename == PAK_DELETED_FILE) {
 				hasDeleted = true;
-				deletedOffset = offset;
-				return;
+				deletedOffset = entry.offset;
+				continue;
 			}
 			else if (!isLegacy && filename == PAK_DEPS_FILE) {
 				hasDeps = true;
-				depsOffset = offset;
-				return;
+				depsOffset = entry.offset;
+				continue;
 			}
 
 			if (FileIsDeleted(pak, filename)) {
 				Log::Debug("Ignoring deleted file %s from %s", filename, pak.path);
 			}
 			else {
-				fileMap.emplace(filename, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, offset));
+				fileMap.emplace(filename, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, entry.offset));
 			}
-		}, err);
-		if (err)
-			return;
+		}
+
+		// The zip itself is only needed to read the DELETED and DEPS files
+		if (hasDeleted || (loadDeps && hasDeps)) {
+			zipFile = ZipArchive::Open(loadedPak.fd, err);
+			if (err)
+				return;
+		}
 	} else {
 		ASSERT_UNREACHABLE();
 	}
@@ -1486,6 +1854,12 @@ void ClearPaks()
 	fsLogs.Verbose("^5Unloading all paks");
 	deletedFileSet.clear();
 	fileMap.clear();
+	{
+		// Views that are still in use keep their mappings alive
+		std::lock_guard<std::mutex> lock(fileViewMutex);
+		pakMappings.clear();
+		inflatedFiles.clear();
+	}
 	for (LoadedPakInfo& x: loadedPaks) {
 		if (x.fd != -1)
 			close(x.fd);
@@ -1537,9 +1911,58 @@ std::string ReadFile(Str::StringRef path, std::error_code& err) {
 	ClearErrorCode(err);
 	return content;
 }
+
+FileView ReadFileView(Str::StringRef path, std::error_code& err)
+{
+	auto content = std::make_shared<std::string>(ReadFile(path, err));
+	return FileView(content, content->data(), content->size());
+}
 #endif
 
 #ifdef BUILD_ENGINE
+FileView ReadFileView(Str::StringRef path, std::error_code& err)
+{
+	auto it = fileMap.find(path);
+	if (it != fileMap.end() && loadedPaks[it->second.first].type == pakType_t::PAK_ZIP) {
+		std::shared_ptr<const PakMapping> mapping;
+		const char* data;
+		size_t length;
+		if (FindStoredFile(it->second.first, it->second.second, mapping, data, length)) {
+			ClearErrorCode(err);
+			return FileView(std::move(mapping), data, length);
+		}
+
+		// Share the inflated file with the other views of it that are still alive
+		std::pair<uint32_t, offset_t> key = it->second;
+		{
+			std::lock_guard<std::mutex> lock(fileViewMutex);
+			auto inflated = inflatedFiles.find(key);
+			if (inflated != inflatedFiles.end()) {
+				if (auto content = inflated->second.lock()) {
+					ClearErrorCode(err);
+					return FileView(content, content->data(), content->size());
+				}
+			}
+		}
+
+		auto content = std::make_shared<const std::string>(ReadFile(path, err));
+		if (err)
+			return {};
+
+		std::lock_guard<std::mutex> lock(fileViewMutex);
+		for (auto i = inflatedFiles.begin(); i != inflatedFiles.end();) {
+			i = i->second.expired() ? inflatedFiles.erase(i) : std::next(i);
+		}
+		inflatedFiles[key] = content;
+		return FileView(content, content->data(), content->size());
+	}
+
+	auto content = std::make_shared<const std::string>(ReadFile(path, err));
+	if (err)
+		return {};
+	return FileView(content, content->data(), content->size());
+}
+
 std::string ReadFile(Str::StringRef path, std::error_code& err)
 {
 	auto it = fileMap.find(path);
@@ -1566,6 +1989,15 @@ std::string ReadFile(Str::StringRef path, std::error_code& err)
 		file.Read(&out[0], length, err);
 		return out;
 	} else if (pak.type == pakType_t::PAK_ZIP) {
+		// Copy files stored without compression straight from the mapped pak
+		std::shared_ptr<const PakMapping> mapping;
+		const char* data;
+		size_t dataLength;
+		if (FindStoredFile(it->second.first, it->second.second, mapping, data, dataLength)) {
+			ClearErrorCode(err);
+			return std::string(data, dataLength);
+		}
+
 		// Open zip
 		ZipArchive zipFile = ZipArchive::Open(pak.fd, err);
 		if (err)
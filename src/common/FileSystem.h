@@ -335,6 +335,36 @@ namespace PakPath {
 	// Read an entire file into a string
 	std::string ReadFile(Str::StringRef path, std::error_code& err = throws());
 
+	// Read-only contents of a file. The files stored without compression in
+	// zip paks are not copied: the view points into a memory mapping of the
+	// pak. Copies of a view share the data, which stays valid as long as one
+	// of them exists, even if the pak is unloaded. The data is not null
+	// terminated and has no particular alignment.
+	class FileView {
+	public:
+		FileView()
+			: ptr(nullptr), len(0) {}
+		FileView(std::shared_ptr<const void> owner, const char* ptr, size_t len)
+			: owner(std::move(owner)), ptr(ptr), len(len) {}
+
+		const char* data() const
+		{
+			return ptr;
+		}
+		size_t size() const
+		{
+			return len;
+		}
+
+	private:
+		std::shared_ptr<const void> owner;
+		const char* ptr;
+		size_t len;
+	};
+
+	// Read an entire file, avoiding copies where possible
+	FileView ReadFileView(Str::StringRef path, std::error_code& err = throws());
+
 	// Copy an entire file to another file
 	void CopyFile(Str::StringRef path, const File& dest, std::error_code& err = throws());
 
@@ -39,6 +39,11 @@ namespace {
     {
     protected:
         static void SetUpTestSuite()
+        {
+            LoadTestPaks();
+        }
+
+        static void LoadTestPaks()
         {
             for (const char* name : {"testdata", "testdpk"}) {
                 const PakInfo* pak = FindPak(name, "src");
@@ -50,6 +55,17 @@ namespace {
         }
     };
 
+    // For tests that unload the paks, which are loaded again after each of them
+    class FileSystemUnloadTest : public FileSystemTest
+    {
+    protected:
+        void TearDown() override
+        {
+            PakPath::ClearPaks();
+            LoadTestPaks();
+        }
+    };
+
     TEST_F(FileSystemTest, CaseInsensitiveVFSZip)
     {
         std::string contents = PakPath::ReadFile("Test1.txt");
@@ -62,5 +78,44 @@ namespace {
         ASSERT_EQ(contents, "test2");
     }
 
+    TEST_F(FileSystemUnloadTest, FileViewOfStoredZipFile)
+    {
+        PakPath::FileView view = PakPath::ReadFileView("test2.txt");
+        ASSERT_EQ(std::string(view.data(), view.size()), "test2");
+
+        // Read again, the file was already checked
+        ASSERT_EQ(PakPath::ReadFile("test2.txt"), "test2");
+
+        // Still valid after the pak is unloaded
+        PakPath::ClearPaks();
+        ASSERT_EQ(std::string(view.data(), view.size()), "test2");
+    }
+
+    TEST_F(FileSystemTest, FileViewOfPakDir)
+    {
+        PakPath::FileView view = PakPath::ReadFileView("test1.txt");
+        ASSERT_EQ(std::string(view.data(), view.size()), "test1");
+    }
+
+    TEST_F(FileSystemUnloadTest, ReloadWithCachedDirectory)
+    {
+        // Loading the zip pak wrote its file list to the homepath
+        bool cached = false;
+        for (const std::string& x : HomePath::ListFiles("cache/pakdirs")) {
+            cached |= Str::IsSuffix(".bin", x);
+        }
+        ASSERT_TRUE(cached);
+
+        PakPath::ClearPaks();
+        for (const char* name : {"testdata", "testdpk"}) {
+            const PakInfo* pak = FindPak(name, "src");
+            ASSERT_TRUE(pak);
+            PakPath::LoadPak(*pak);
+        }
+
+        ASSERT_EQ(PakPath::ReadFile("Test1.txt"), "test1");
+        ASSERT_EQ(PakPath::ReadFile("TEST2.TXT"), "test2");
+    }
+
 } // namespace
 } // namespace FS
@@ -75,6 +75,16 @@ namespace IPC {
      * send it in the socket.
      */
 
+    // Messages that went through a channel, each of them woke up the other
+    // side of the socket. A SyncMessage costs a full round trip.
+    struct ChannelStats {
+        uint64_t syncSent = 0;
+        uint64_t asyncSent = 0;
+        uint64_t syncHandled = 0;
+        uint64_t asyncHandled = 0;
+        uint64_t bytesSent = 0;
+    };
+
     #ifdef BUILD_ENGINE
         static const bool TOPLEVEL_MSG_ALLOWED = true;
     #else
@@ -131,6 +141,7 @@ namespace IPC {
     public:
         bool canSendSyncMsg;
         bool canSendAsyncMsg;
+        ChannelStats stats;
     };
 
     namespace detail {
@@ -144,9 +155,11 @@ namespace IPC {
             if (!channel.canSendAsyncMsg)
                 Sys::Drop("Attempting to send a Message in VM toplevel with id: 0x%x", Message::id);
 
+            channel.stats.asyncSent++;
             Util::Writer writer;
             writer.Write<uint32_t>(Message::id);
             writer.WriteArgs(Util::TypeListFromTuple<typename Message::Inputs>(), std::forward<Args>(args)...);
+            channel.stats.bytesSent += writer.GetData().size();
             channel.SendMsg(writer);
         }
         template<typename Func, typename Msg, typename Reply, typename... Args> void SendMsg(Channel& channel, Func&& messageHandler, SyncMessage<Msg, Reply>, Args&&... args)
@@ -157,9 +170,11 @@ namespace IPC {
             if (!channel.canSendSyncMsg)
                 Sys::Drop("Attempting to send a SyncMessage while handling a Message or in VM toplevel with id: 0x%x", Message::id);
 
+            channel.stats.syncSent++;
             Util::Writer writer;
             writer.Write<uint32_t>(Message::id);
             writer.WriteArgs(Util::TypeListFromTuple<typename Message::Inputs>(), std::forward<Args>(args)...);
+            channel.stats.bytesSent += writer.GetData().size();
             channel.SendMsg(writer);
 
             while (true) {
@@ -189,6 +204,7 @@ namespace IPC {
         {
             using Message = Message<Id, MsgArgs...>;
 
+            channel.stats.asyncHandled++;
             typename MapTuple<typename Message::Inputs>::type inputs;
             reader.FillTuple<0>(Util::TypeListFromTuple<typename Message::Inputs>(), inputs);
             reader.CheckEndRead();
@@ -205,6 +221,7 @@ namespace IPC {
         {
             using Message = SyncMessage<Msg, Reply>;
 
+            channel.stats.syncHandled++;
             typename MapTuple<typename Message::Inputs>::type inputs;
             typename Message::Outputs outputs;
             reader.FillTuple<0>(Util::TypeListFromTuple<typename Message::Inputs>(), inputs);
@@ -221,6 +238,7 @@ namespace IPC {
             Util::Writer writer;
             writer.Write<uint32_t>(ID_RETURN);
             writer.WriteTuple(Util::TypeListFromTuple<typename Message::Outputs>(), std::move(outputs));
+            channel.stats.bytesSent += writer.GetData().size();
             channel.SendMsg(writer);
         }
 
@@ -0,0 +1,187 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <gtest/gtest.h>
+
+#include "common/Common.h"
+#include "common/IPC/CommonSyscalls.h"
+#include "engine/client/cg_msgdef.h"
+
+// Count the heap allocations made by the threads that ask for it. Replacing
+// the global operator new only affects the test executables.
+static thread_local bool countAllocations = false;
+static thread_local size_t numAllocations = 0;
+
+void* operator new(size_t size)
+{
+	if (countAllocations) {
+		numAllocations++;
+	}
+	if (void* p = malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	free(p);
+}
+
+namespace IPC {
+namespace {
+
+using WarmedUpMsg = Message<Id<VM::QVM, 0xfffe>>;
+using QuitMsg = Message<Id<VM::QVM, 0xffff>>;
+
+// Plays the engine side of the socket until it gets a QuitMsg, counting the
+// heap allocations it made after the WarmedUpMsg
+static void HandleSyscalls(Channel& channel, int& numRefEntities, size_t& allocations)
+{
+	while (true) {
+		Util::Reader reader = channel.RecvMsg();
+		uint32_t id = reader.Read<uint32_t>();
+		switch (id) {
+		case Render::LerpTagMsg::id:
+			HandleMsg<Render::LerpTagMsg>(channel, std::move(reader), [](const refEntity_t&, const std::string& tagName, int startIndex, orientation_t& tag, int& res) {
+				VectorClear(tag.origin);
+				AxisClear(tag.axis);
+				res = tagName == "tag_weapon" ? startIndex : -1;
+			});
+			break;
+
+		case Render::AddRefEntityToSceneMsg::id:
+			HandleMsg<Render::AddRefEntityToSceneMsg>(channel, std::move(reader), [&](const refEntity_t&) {
+				numRefEntities++;
+			});
+			break;
+
+		case VM::GetCvarMsg::id:
+			HandleMsg<VM::GetCvarMsg>(channel, std::move(reader), [](const std::string& name, std::string& value) {
+				value = name == "cg_fov" ? "90" : "";
+			});
+			break;
+
+		case WarmedUpMsg::id:
+			numAllocations = 0;
+			countAllocations = true;
+			break;
+
+		case QuitMsg::id:
+			countAllocations = false;
+			allocations = numAllocations;
+			return;
+		}
+	}
+}
+
+TEST(ChannelTest, CommonSyscallsReuseMessageBuffers)
+{
+	auto sockets = Socket::CreatePair();
+	Channel vm(std::move(sockets.first));
+	Channel engine(std::move(sockets.second));
+
+	int numRefEntities = 0;
+	size_t engineAllocations = 0;
+	std::thread engineThread(HandleSyscalls, std::ref(engine), std::ref(numRefEntities), std::ref(engineAllocations));
+	auto noSyscall = [](uint32_t, Util::Reader) {};
+
+	refEntity_t entity{};
+	orientation_t tag;
+	int res = 0;
+	std::string value;
+	auto syscalls = [&] {
+		SendMsg<Render::LerpTagMsg>(vm, noSyscall, entity, "tag_weapon", 3, tag, res);
+		SendMsg<Render::AddRefEntityToSceneMsg>(vm, noSyscall, entity);
+		SendMsg<VM::GetCvarMsg>(vm, noSyscall, "cg_fov", value);
+	};
+
+	// Fill the buffer pools of both threads
+	syscalls();
+	SendMsg<WarmedUpMsg>(vm, noSyscall);
+
+	numAllocations = 0;
+	countAllocations = true;
+	for (int i = 0; i < 100; i++) {
+		syscalls();
+	}
+	countAllocations = false;
+	size_t vmAllocations = numAllocations;
+
+	SendMsg<QuitMsg>(vm, noSyscall);
+	engineThread.join();
+
+	EXPECT_EQ(0u, vmAllocations);
+	EXPECT_EQ(0u, engineAllocations);
+	EXPECT_EQ(3, res);
+	EXPECT_EQ("90", value);
+	EXPECT_EQ(101, numRefEntities);
+}
+
+TEST(ChannelTest, ArrayViewBorrowsFromTheMessage)
+{
+	std::vector<float> floats = {1.0f, 2.0f, 3.0f};
+	Util::Writer writer;
+	writer.Write<int>(42);
+	writer.Write<std::vector<float>>(floats);
+
+	Util::Reader reader;
+	reader.GetData() = writer.GetData();
+	EXPECT_EQ(42, reader.Read<int>());
+	Util::ArrayView<float> view = reader.Read<Util::ArrayView<float>>();
+	reader.CheckEndRead();
+
+	ASSERT_EQ(3u, view.size());
+	EXPECT_EQ(reader.GetData().data() + 2 * sizeof(uint32_t), reinterpret_cast<const char*>(view.data()));
+	EXPECT_EQ(floats, std::vector<float>(view.begin(), view.end()));
+}
+
+} // namespace
+} // namespace IPC
@@ -0,0 +1,92 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include "Common.h"
+
+namespace Util {
+
+	// Enough for the writers and readers alive during a few nested syscalls
+	static const size_t MAX_POOLED_BUFFERS = 16;
+
+	// Don't hold on to the memory of exceptionally big messages
+	static const size_t MAX_POOLED_CAPACITY = 1 << 20;
+
+	// Cleared when the pool of the thread is destroyed
+	static ENGINE_THREAD_LOCAL bool messageBufferPoolAlive = true;
+
+	namespace {
+		struct MessageBufferPool {
+			std::vector<std::vector<char>> buffers;
+
+			MessageBufferPool()
+			{
+				buffers.reserve(MAX_POOLED_BUFFERS);
+			}
+			~MessageBufferPool()
+			{
+				// Writers and Readers destroyed after the pool don't give their buffer back
+				messageBufferPoolAlive = false;
+			}
+		};
+	}
+
+	// Only the engine uses messages on several threads
+	static ENGINE_THREAD_LOCAL MessageBufferPool messageBufferPool;
+
+	std::vector<char> AcquireMessageBuffer()
+	{
+		if (!messageBufferPoolAlive) {
+			return {};
+		}
+
+		std::vector<std::vector<char>>& buffers = messageBufferPool.buffers;
+		if (buffers.empty()) {
+			return {};
+		}
+
+		std::vector<char> buffer = std::move(buffers.back());
+		buffers.pop_back();
+		return buffer;
+	}
+
+	void ReleaseMessageBuffer(std::vector<char> buffer)
+	{
+		if (!messageBufferPoolAlive || buffer.capacity() == 0 || buffer.capacity() > MAX_POOLED_CAPACITY) {
+			return;
+		}
+
+		std::vector<std::vector<char>>& buffers = messageBufferPool.buffers;
+		if (buffers.size() < MAX_POOLED_BUFFERS) {
+			buffer.clear();
+			buffers.push_back(std::move(buffer));
+		}
+	}
+
+} // namespace Util
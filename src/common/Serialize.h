@@ -71,9 +71,30 @@ namespace Util {
 	// Trait declaration for the serialization trait.
 	template<typename T, typename = void> struct SerializeTraits {};
 
+	// Writer and Reader take their data buffer from a small pool (per thread in
+	// the engine) and give it back when destroyed, so that sending and handling
+	// messages doesn't allocate once the pool is warm.
+	std::vector<char> AcquireMessageBuffer();
+	void ReleaseMessageBuffer(std::vector<char> buffer);
+
 	// Class to generate messages
 	class Writer {
 	public:
+		Writer()
+			: data(AcquireMessageBuffer()) {}
+		Writer(Writer&& other) = default;
+		Writer& operator=(Writer&& other)
+		{
+			ReleaseMessageBuffer(std::move(data));
+			data = std::move(other.data);
+			handles = std::move(other.handles);
+			return *this;
+		}
+		~Writer()
+		{
+			ReleaseMessageBuffer(std::move(data));
+		}
+
 		void WriteData(const void* p, size_t len)
 		{
 			data.insert(data.end(), static_cast<const char*>(p), static_cast<const char*>(p) + len);
@@ -131,15 +152,24 @@ namespace Util {
 	class Reader {
 	public:
 		Reader()
-			: pos(0), handles_pos(0) {}
+			: data(AcquireMessageBuffer()), pos(0), handles_pos(0) {}
 		Reader(Reader&& other) NOEXCEPT
 			: data(std::move(other.data)), handles(std::move(other.handles)), pos(other.pos), handles_pos(other.handles_pos) {}
 		Reader& operator=(Reader&& other) NOEXCEPT
 		{
-			std::swap(data, other.data);
-			std::swap(handles, other.handles);
-			std::swap(pos, other.pos);
-			std::swap(handles_pos, other.handles_pos);
+			// Give back what the destination held before taking over the source's
+			for (size_t i = handles_pos; i < handles.size(); i++)
+				handles[i].Close();
+			ReleaseMessageBuffer(std::move(data));
+
+			data = std::move(other.data);
+			handles = std::move(other.handles);
+			pos = other.pos;
+			handles_pos = other.handles_pos;
+			other.data.clear();
+			other.handles.clear();
+			other.pos = 0;
+			other.handles_pos = 0;
 			return *this;
 		}
 		~Reader()
@@ -147,6 +177,7 @@ namespace Util {
 			// Close any handles that weren't read
 			for (size_t i = handles_pos; i < handles.size(); i++)
 				handles[i].Close();
+			ReleaseMessageBuffer(std::move(data));
 		}
 
 		void ReadData(void* p, size_t len)
@@ -325,6 +356,66 @@ namespace Util {
 		}
 	};
 
+	// Read-only view of an array of POD values inside a message, serialized like
+	// a std::vector<T> but read without copying. It
+	// only lives as long as the Reader it was read from, so it can be used for
+	// the inputs of a HandleMsg. The array must be aligned in the message, which
+	// is the case when it is only preceded by 4-byte sized fields.
+	template<typename T> class ArrayView {
+	public:
+		ArrayView()
+			: ptr(nullptr), len(0) {}
+		ArrayView(const T* data, size_t size)
+			: ptr(data), len(size) {}
+		ArrayView(const std::vector<T>& vector)
+			: ptr(vector.data()), len(vector.size()) {}
+
+		const T* data() const
+		{
+			return ptr;
+		}
+		size_t size() const
+		{
+			return len;
+		}
+		bool empty() const
+		{
+			return len == 0;
+		}
+		const T* begin() const
+		{
+			return ptr;
+		}
+		const T* end() const
+		{
+			return ptr + len;
+		}
+		const T& operator[](size_t i) const
+		{
+			return ptr[i];
+		}
+
+	private:
+		const T* ptr;
+		size_t len;
+	};
+	template<typename T>
+	struct SerializeTraits<ArrayView<T>, typename std::enable_if<IsPod<T>>::type> {
+		static void Write(Writer& stream, ArrayView<T> value)
+		{
+			stream.WriteSize(value.size());
+			stream.WriteData(value.data(), value.size() * sizeof(T));
+		}
+		static ArrayView<T> Read(Reader& stream)
+		{
+			size_t size = stream.ReadSize<T>();
+			const void* p = stream.ReadInline(size * sizeof(T));
+			if (reinterpret_cast<uintptr_t>(p) % alignof(T) != 0)
+				Sys::Drop("IPC: Misaligned array in message");
+			return {static_cast<const T*>(p), size};
+		}
+	};
+
 	// std::pair
 	template<typename T, typename U>
 	struct SerializeTraits<std::pair<T, U>> {
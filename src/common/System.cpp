@@ -207,11 +207,22 @@ SteadyClock::time_point SleepUntil(SteadyClock::time_point time)
 	return time;
 }
 
+#ifndef BUILD_VM
+static SteadyClock::time_point MillisecondsBase() {
+	static SteadyClock::time_point baseTime = SteadyClock::now();
+	return baseTime;
+}
+
+SteadyClock::time_point MillisecondsTimePoint(int msec) {
+	return MillisecondsBase() + std::chrono::milliseconds(msec);
+}
+#endif
+
 int Milliseconds() {
 #ifdef BUILD_VM
 	return trap_Milliseconds();
 #else
-	static Sys::SteadyClock::time_point baseTime = Sys::SteadyClock::now();
+	SteadyClock::time_point baseTime = MillisecondsBase();
 	return std::chrono::duration_cast<std::chrono::milliseconds>(Sys::SteadyClock::now() - baseTime).count();
 #endif
 }
@@ -77,6 +77,12 @@ void SleepFor(SteadyClock::duration time);
 // Results *within a single module* (engine/cgame/sgame) are monotonic.
 int Milliseconds();
 
+#ifndef BUILD_VM
+// The time at which Milliseconds() starts returning msec, to wait for a
+// frame with a better precision than a millisecond.
+SteadyClock::time_point MillisecondsTimePoint(int msec);
+#endif
+
 // For a DLL this means the thread starting from the VM's entry point, not the real main thread
 bool OnMainThread();
 
@@ -0,0 +1,531 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include "cm_local.h"
+#include "common/FileSystem.h"
+
+/*
+The collision cache keeps in the homepath what CM_LoadMap derives from the
+BSP besides copying its lumps: the facets of the patches and triangle soups,
+with their planes and facet trees, and the point grid. Generating them is
+most of the load time of a map with many curves, and the server and each VM
+that links the collision code do it on every map change. Only the engine
+uses the cache: the VMs can't open files in the homepath directly.
+
+A cache file is only used if it was made from the same BSP, with the same
+options and by a build laying out the cached structures in the same way.
+It is read as a single block, and the surfaces point into it.
+*/
+
+#ifdef BUILD_ENGINE
+static Cvar::Cvar<bool> cm_cache("cm_cache", "Cache the collision data generated for maps in the homepath", Cvar::NONE, true);
+#endif
+
+// Bump when the cached structures or the way they are generated change
+static const uint32_t CM_CACHE_VERSION = 1;
+static const uint32_t CM_CACHE_MAGIC = 0x48434d43; // "CMCH"
+
+// The blocks of a cache file start on this boundary, which CM_Alloc also guarantees
+static const size_t CM_CACHE_ALIGN = 16;
+
+// options the cached data depends on
+static const uint32_t CACHE_TRISOUPS = 1 << 0;
+static const uint32_t CACHE_POINT_GRID = 1 << 1;
+
+struct cCacheHeader_t
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t layout; // hash of the sizes of the cached structures
+	uint32_t options;
+	uint64_t bspHash;
+	uint64_t dataHash; // of everything after the header
+	uint64_t dataSize;
+	int32_t  numSurfaces;
+	int32_t  padding;
+};
+
+struct cCacheSurface_t
+{
+	int32_t type; // -1 for the surfaces without collision
+	int32_t surfaceFlags;
+	int32_t contents;
+	int32_t numPlanes;
+	int32_t numFacets;
+	int32_t numNodes;
+	vec3_t  bounds[ 2 ];
+};
+
+struct cCacheGrid_t
+{
+	vec3_t  origin;
+	float   cellSize;
+	float   invCellSize;
+	int32_t size[ 3 ];
+	int32_t hasCells;
+};
+
+/*
+==================
+CM_CacheHash
+
+FNV-1a over 64 bit words, to tell versions of a file apart
+==================
+*/
+uint64_t CM_CacheHash( const void *data, size_t size )
+{
+	const byte *bytes = static_cast<const byte *>( data );
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	for ( ; size >= sizeof( uint64_t ); size -= sizeof( uint64_t ), bytes += sizeof( uint64_t ) )
+	{
+		uint64_t word;
+		memcpy( &word, bytes, sizeof( word ) );
+		hash = ( hash ^ word ) * 0x100000001b3ull;
+	}
+
+	for ( ; size; size--, bytes++ )
+	{
+		hash = ( hash ^ *bytes ) * 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+#ifdef BUILD_ENGINE
+
+static uint32_t CM_CacheLayout()
+{
+	const uint32_t sizes[] = {
+		sizeof( cCacheHeader_t ), sizeof( cCacheSurface_t ), sizeof( cCacheGrid_t ),
+		sizeof( cPlane_t ), sizeof( cFacet_t ), sizeof( cFacetNode_t ), sizeof( cPointCell_t ),
+	};
+	return uint32_t( CM_CacheHash( sizes, sizeof( sizes ) ) );
+}
+
+static uint32_t CM_CacheOptions()
+{
+	uint32_t options = 0;
+
+	if ( cm.perPolyCollision || cm_forceTriangles.Get() )
+	{
+		options |= CACHE_TRISOUPS;
+	}
+
+	if ( cm_pointGrid.Get() )
+	{
+		options |= CACHE_POINT_GRID;
+	}
+
+	return options;
+}
+
+static std::string CM_CachePath( Str::StringRef name )
+{
+	return Str::Format( "cache/cm/%s.bin", name );
+}
+
+/*
+===============================================================================
+
+READING
+
+===============================================================================
+*/
+
+// Hands out the blocks of a cache file in order
+struct cacheReader_t
+{
+	const byte *data;
+	size_t     size;
+	size_t     pos;
+
+	template<typename T>
+	const T *Get( size_t count )
+	{
+		pos = ( pos + CM_CACHE_ALIGN - 1 ) & ~( CM_CACHE_ALIGN - 1 );
+
+		if ( pos > size || count > ( size - pos ) / sizeof( T ) )
+		{
+			return nullptr;
+		}
+
+		const T *block = reinterpret_cast<const T *>( data + pos );
+		pos += count * sizeof( T );
+		return block;
+	}
+};
+
+static bool CM_ReadCacheData( cacheReader_t &reader, int numSurfaces )
+{
+	const cCacheSurface_t *surfaceInfo = reader.Get<cCacheSurface_t>( numSurfaces );
+
+	if ( !surfaceInfo )
+	{
+		return false;
+	}
+
+	int numCollides = 0;
+
+	for ( int i = 0; i < numSurfaces; i++ )
+	{
+		if ( surfaceInfo[ i ].type >= 0 )
+		{
+			numCollides++;
+		}
+	}
+
+	cm.numSurfaces = numSurfaces;
+	cm.surfaces = ( cSurface_t ** ) CM_Alloc( numSurfaces * sizeof( cm.surfaces[ 0 ] ) );
+	cSurface_t *surfaces = ( cSurface_t * ) CM_Alloc( numCollides * sizeof( cSurface_t ) );
+	cSurfaceCollide_t *collides = ( cSurfaceCollide_t * ) CM_Alloc( numCollides * sizeof( cSurfaceCollide_t ) );
+	cSurface_t *surface = surfaces;
+	cSurfaceCollide_t *sc = collides;
+
+	auto fail = [ & ]
+	{
+		CM_Free( collides );
+		CM_Free( surfaces );
+		CM_Free( cm.surfaces );
+		cm.numSurfaces = 0;
+		cm.surfaces = nullptr;
+		ResetStruct( cm.pointGrid );
+		return false;
+	};
+
+	for ( int i = 0; i < numSurfaces; i++ )
+	{
+		const cCacheSurface_t &info = surfaceInfo[ i ];
+
+		if ( info.type < 0 )
+		{
+			continue;
+		}
+
+		if ( info.numPlanes < 0 || info.numFacets < 0 || info.numNodes < 0 )
+		{
+			return fail();
+		}
+
+		surface->type = mapSurfaceType_t( info.type );
+		surface->surfaceFlags = info.surfaceFlags;
+		surface->contents = info.contents;
+		surface->sc = sc;
+
+		VectorCopy( info.bounds[ 0 ], sc->bounds[ 0 ] );
+		VectorCopy( info.bounds[ 1 ], sc->bounds[ 1 ] );
+		sc->numPlanes = info.numPlanes;
+		sc->numFacets = info.numFacets;
+		sc->numNodes = info.numNodes;
+
+		// the trace code never writes to these
+		sc->planes = const_cast<cPlane_t *>( reader.Get<cPlane_t>( info.numPlanes ) );
+		sc->facets = const_cast<cFacet_t *>( reader.Get<cFacet_t>( info.numFacets ) );
+		sc->nodes = const_cast<cFacetNode_t *>( reader.Get<cFacetNode_t>( info.numNodes ) );
+
+		if ( !sc->planes || !sc->facets || !sc->nodes )
+		{
+			return fail();
+		}
+
+		cm.surfaces[ i ] = surface++;
+		sc++;
+	}
+
+	const cCacheGrid_t *gridInfo = reader.Get<cCacheGrid_t>( 1 );
+
+	if ( !gridInfo )
+	{
+		return fail();
+	}
+
+	if ( gridInfo->hasCells )
+	{
+		cPointGrid_t &grid = cm.pointGrid;
+
+		VectorCopy( gridInfo->origin, grid.origin );
+		grid.cellSize = gridInfo->cellSize;
+		grid.invCellSize = gridInfo->invCellSize;
+
+		int64_t numCells = 1;
+
+		for ( int i = 0; i < 3; i++ )
+		{
+			grid.size[ i ] = gridInfo->size[ i ];
+			numCells *= std::max( 0, grid.size[ i ] );
+		}
+
+		grid.cells = const_cast<cPointCell_t *>( reader.Get<cPointCell_t>( numCells ) );
+
+		if ( !grid.cells )
+		{
+			return fail();
+		}
+	}
+
+	if ( reader.pos != reader.size )
+	{
+		return fail();
+	}
+
+	return true;
+}
+
+/*
+==================
+CM_ReadCache
+
+Loads the surfaces and the point grid of a map from the homepath, if
+a cache made from the same BSP is there
+==================
+*/
+bool CM_ReadCache( Str::StringRef name, uint64_t bspHash )
+{
+	if ( !cm_cache.Get() )
+	{
+		return false;
+	}
+
+	int start = Sys::Milliseconds();
+	std::string path = CM_CachePath( name );
+	std::error_code err;
+	FS::File file = FS::HomePath::OpenRead( path, err );
+
+	if ( err )
+	{
+		return false;
+	}
+
+	cCacheHeader_t header;
+
+	if ( file.Read( &header, sizeof( header ), err ) != sizeof( header ) || err
+	     || header.magic != CM_CACHE_MAGIC || header.version != CM_CACHE_VERSION
+	     || header.layout != CM_CacheLayout() || header.options != CM_CacheOptions()
+	     || header.bspHash != bspHash || header.numSurfaces < 0 )
+	{
+		cmLog.Verbose( "Collision cache %s is out of date", path );
+		return false;
+	}
+
+	FS::offset_t length = file.Length( err );
+
+	if ( err || length < 0 || uint64_t( length ) != sizeof( header ) + header.dataSize )
+	{
+		cmLog.Verbose( "Collision cache %s has the wrong size", path );
+		return false;
+	}
+
+	// The header is read again so that the blocks keep their alignment
+	byte *data = ( byte * ) CM_Alloc( length );
+	file.SeekSet( 0, err );
+
+	if ( err || file.Read( data, length, err ) != size_t( length ) || err
+	     || CM_CacheHash( data + sizeof( header ), header.dataSize ) != header.dataHash )
+	{
+		cmLog.Verbose( "Collision cache %s is corrupt", path );
+		CM_Free( data );
+		return false;
+	}
+
+	cacheReader_t reader{ data, size_t( length ), sizeof( header ) };
+
+	if ( !CM_ReadCacheData( reader, header.numSurfaces ) )
+	{
+		cmLog.Warn( "Collision cache %s is inconsistent", path );
+		CM_Free( data );
+		return false;
+	}
+
+	cmLog.Verbose( "Loaded the collision cache %s in %d ms", path, Sys::Milliseconds() - start );
+	return true;
+}
+
+/*
+===============================================================================
+
+WRITING
+
+===============================================================================
+*/
+
+struct cacheWriter_t
+{
+	std::string data;
+
+	void Put( const void *block, size_t size )
+	{
+		data.resize( ( data.size() + CM_CACHE_ALIGN - 1 ) & ~( CM_CACHE_ALIGN - 1 ), '\0' );
+		data.append( static_cast<const char *>( block ), size );
+	}
+};
+
+/*
+==================
+CM_WriteCache
+
+Saves the surfaces and the point grid of the loaded map to the homepath
+==================
+*/
+void CM_WriteCache( Str::StringRef name, uint64_t bspHash )
+{
+	if ( !cm_cache.Get() )
+	{
+		return;
+	}
+
+	cacheWriter_t writer;
+	cCacheHeader_t header{};
+	writer.Put( &header, sizeof( header ) );
+
+	std::vector<cCacheSurface_t> surfaceInfo( cm.numSurfaces );
+
+	for ( int i = 0; i < cm.numSurfaces; i++ )
+	{
+		const cSurface_t *surface = cm.surfaces[ i ];
+		cCacheSurface_t &info = surfaceInfo[ i ];
+
+		if ( !surface )
+		{
+			info.type = -1;
+			continue;
+		}
+
+		info.type = Util::ordinal( surface->type );
+		info.surfaceFlags = surface->surfaceFlags;
+		info.contents = surface->contents;
+		info.numPlanes = surface->sc->numPlanes;
+		info.numFacets = surface->sc->numFacets;
+		info.numNodes = surface->sc->numNodes;
+		VectorCopy( surface->sc->bounds[ 0 ], info.bounds[ 0 ] );
+		VectorCopy( surface->sc->bounds[ 1 ], info.bounds[ 1 ] );
+	}
+
+	writer.Put( surfaceInfo.data(), surfaceInfo.size() * sizeof( cCacheSurface_t ) );
+
+	for ( int i = 0; i < cm.numSurfaces; i++ )
+	{
+		const cSurfaceCollide_t *sc = cm.surfaces[ i ] ? cm.surfaces[ i ]->sc : nullptr;
+
+		if ( !sc )
+		{
+			continue;
+		}
+
+		// the hash chains only matter while the planes are generated
+		std::vector<cPlane_t> planes( sc->planes, sc->planes + sc->numPlanes );
+
+		for ( cPlane_t &plane : planes )
+		{
+			plane.hashChain = nullptr;
+		}
+
+		writer.Put( planes.data(), planes.size() * sizeof( cPlane_t ) );
+		writer.Put( sc->facets, sc->numFacets * sizeof( cFacet_t ) );
+		writer.Put( sc->nodes, sc->numNodes * sizeof( cFacetNode_t ) );
+	}
+
+	const cPointGrid_t &grid = cm.pointGrid;
+	cCacheGrid_t gridInfo{};
+	gridInfo.hasCells = grid.cells != nullptr;
+
+	if ( grid.cells )
+	{
+		VectorCopy( grid.origin, gridInfo.origin );
+		gridInfo.cellSize = grid.cellSize;
+		gridInfo.invCellSize = grid.invCellSize;
+
+		for ( int i = 0; i < 3; i++ )
+		{
+			gridInfo.size[ i ] = grid.size[ i ];
+		}
+	}
+
+	writer.Put( &gridInfo, sizeof( gridInfo ) );
+
+	if ( grid.cells )
+	{
+		writer.Put( grid.cells, grid.size[ 0 ] * grid.size[ 1 ] * grid.size[ 2 ] * sizeof( cPointCell_t ) );
+	}
+
+	header.magic = CM_CACHE_MAGIC;
+	header.version = CM_CACHE_VERSION;
+	header.layout = CM_CacheLayout();
+	header.options = CM_CacheOptions();
+	header.bspHash = bspHash;
+	header.dataSize = writer.data.size() - sizeof( header );
+	header.dataHash = CM_CacheHash( writer.data.data() + sizeof( header ), header.dataSize );
+	header.numSurfaces = cm.numSurfaces;
+	memcpy( &writer.data[ 0 ], &header, sizeof( header ) );
+
+	// Write to a temporary file first so that a reader never sees half of it.
+	// The sgame and the cgame share a homepath, so they use different names.
+	std::string path = CM_CachePath( name );
+	std::string tempPath = path + "." VM_STRING_PREFIX "tmp";
+	std::error_code err;
+	{
+		FS::File file = FS::HomePath::OpenWrite( tempPath, err );
+
+		if ( !err )
+		{
+			file.Write( writer.data.data(), writer.data.size(), err );
+		}
+
+		if ( !err )
+		{
+			file.Close( err );
+		}
+	}
+
+	if ( !err )
+	{
+		FS::HomePath::MoveFile( path, tempPath, err );
+	}
+
+	if ( err )
+	{
+		cmLog.Verbose( "Could not write the collision cache %s: %s", path, err.message() );
+		return;
+	}
+
+	cmLog.Verbose( "Wrote the collision cache %s (%d bytes)", path, writer.data.size() );
+}
+
+#else // BUILD_ENGINE
+
+bool CM_ReadCache( Str::StringRef, uint64_t )
+{
+	return false;
+}
+
+void CM_WriteCache( Str::StringRef, uint64_t )
+{
+}
+
+#endif // BUILD_ENGINE
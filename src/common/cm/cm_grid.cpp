@@ -0,0 +1,352 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include "cm_local.h"
+
+/*
+The point grid divides the bounds of the world model into coarse cells and
+stores, for each of them, what a point query would find anywhere inside it:
+the deepest node that the whole cell falls into, and the contents if they
+are the same everywhere in the cell (solid, empty, in the void, or inside the
+same set of brushes). Queries in a uniform cell return at once, the others
+start walking the tree from the stored node instead of the root.
+
+Cells are classified with a margin around them, so that rounding in the
+float computations of CM_PointLeafnum_r and CM_PointContents can never send a
+point of the cell somewhere the grid didn't account for. Points outside of
+the grid take the usual path.
+*/
+
+Cvar::Cvar<bool> cm_pointGrid(VM_STRING_PREFIX "cm_pointGrid", "Build a grid at map load to speed up point contents queries", Cvar::NONE, true);
+
+static const float POINT_GRID_MIN_CELL_SIZE = 64.0f;
+static const int POINT_GRID_MAX_CELLS = 1 << 16;
+static const double POINT_GRID_MARGIN = 1.0;
+
+// Above this many leaves, a cell is not worth checking for uniform contents
+static const int POINT_GRID_MAX_CELL_LEAFS = 32;
+
+struct cellBounds_t
+{
+	double mins[ 3 ];
+	double maxs[ 3 ];
+};
+
+// Range of DotProduct( normal, x ) - dist over the box
+static void CM_PlaneDistanceRange( const cellBounds_t &box, const vec3_t normal, float dist, double &dmin, double &dmax )
+{
+	dmin = dmax = -double( dist );
+
+	for ( int i = 0; i < 3; i++ )
+	{
+		double lo = normal[ i ] * box.mins[ i ];
+		double hi = normal[ i ] * box.maxs[ i ];
+
+		dmin += std::min( lo, hi );
+		dmax += std::max( lo, hi );
+	}
+}
+
+// Follows the points of the box down the tree for as long as they all go the same way
+static int CM_CellNode( const cellBounds_t &box )
+{
+	int num = 0;
+
+	while ( num >= 0 )
+	{
+		const cNode_t *node = &cm.nodes[ num ];
+		double dmin, dmax;
+		CM_PlaneDistanceRange( box, node->plane->normal, node->plane->dist, dmin, dmax );
+
+		if ( dmin >= 0 )
+		{
+			num = node->children[ 0 ];
+		}
+		else if ( dmax < 0 )
+		{
+			num = node->children[ 1 ];
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	return num;
+}
+
+// Returns false if there are too many leaves
+static bool CM_CellLeafs( const cellBounds_t &box, int num, std::vector<int> &leafs )
+{
+	while ( num >= 0 )
+	{
+		const cNode_t *node = &cm.nodes[ num ];
+		double dmin, dmax;
+		CM_PlaneDistanceRange( box, node->plane->normal, node->plane->dist, dmin, dmax );
+
+		if ( dmin >= 0 )
+		{
+			num = node->children[ 0 ];
+		}
+		else if ( dmax < 0 )
+		{
+			num = node->children[ 1 ];
+		}
+		else
+		{
+			if ( !CM_CellLeafs( box, node->children[ 0 ], leafs ) )
+			{
+				return false;
+			}
+
+			num = node->children[ 1 ];
+		}
+	}
+
+	if ( int( leafs.size() ) >= POINT_GRID_MAX_CELL_LEAFS )
+	{
+		return false;
+	}
+
+	leafs.push_back( -1 - num );
+	return true;
+}
+
+// Mirrors CM_PointContents for every point of the box at once
+static bool CM_LeafContentsInCell( const cellBounds_t &box, const cLeaf_t &leaf, int &contents )
+{
+	if ( leaf.area == -1 )
+	{
+		contents = CONTENTS_SOLID;
+		return true;
+	}
+
+	contents = 0;
+
+	for ( int i = 0; i < leaf.numLeafBrushes; i++ )
+	{
+		const cbrush_t &b = cm.brushes[ leaf.firstLeafBrush[ i ] ];
+
+		// the same bounds test as CM_BoundsIntersectPoint
+		bool inBounds = true;
+		bool outOfBounds = false;
+
+		for ( int j = 0; j < 3; j++ )
+		{
+			double mins = b.bounds[ 0 ][ j ] - double( SURFACE_CLIP_EPSILON );
+			double maxs = b.bounds[ 1 ][ j ] + double( SURFACE_CLIP_EPSILON );
+
+			inBounds = inBounds && mins < box.mins[ j ] && box.maxs[ j ] < maxs;
+			outOfBounds = outOfBounds || box.maxs[ j ] < mins || maxs < box.mins[ j ];
+		}
+
+		if ( outOfBounds )
+		{
+			continue;
+		}
+
+		bool inside = inBounds;
+		bool outside = false;
+
+		for ( int j = 0; j < b.numsides && !outside; j++ )
+		{
+			const cplane_t *plane = b.sides[ j ].plane;
+			double dmin, dmax;
+			CM_PlaneDistanceRange( box, plane->normal, plane->dist, dmin, dmax );
+
+			inside = inside && dmax < 0;
+			outside = dmin > 0;
+		}
+
+		if ( outside )
+		{
+			continue;
+		}
+
+		if ( !inside )
+		{
+			return false;
+		}
+
+		contents |= b.contents;
+	}
+
+	return true;
+}
+
+static void CM_ClassifyCell( const cellBounds_t &box, cPointCell_t &cell, std::vector<int> &leafs )
+{
+	cell.node = CM_CellNode( box );
+	cell.uniform = false;
+	cell.contents = 0;
+
+	leafs.clear();
+
+	if ( !CM_CellLeafs( box, cell.node, leafs ) )
+	{
+		return;
+	}
+
+	for ( size_t i = 0; i < leafs.size(); i++ )
+	{
+		int contents;
+
+		if ( !CM_LeafContentsInCell( box, cm.leafs[ leafs[ i ] ], contents ) || ( i > 0 && contents != cell.contents ) )
+		{
+			return;
+		}
+
+		cell.contents = contents;
+	}
+
+	cell.uniform = true;
+}
+
+/*
+==================
+CM_BuildPointGrid
+==================
+*/
+void CM_BuildPointGrid()
+{
+	cPointGrid_t &grid = cm.pointGrid;
+	ResetStruct( grid );
+
+	if ( !cm_pointGrid.Get() || !cm.numNodes || !cm.numSubModels )
+	{
+		return;
+	}
+
+	const cmodel_t &world = cm.cmodels[ 0 ];
+	vec3_t extent;
+
+	for ( int i = 0; i < 3; i++ )
+	{
+		grid.origin[ i ] = world.mins[ i ] - 1.0f;
+		extent[ i ] = world.maxs[ i ] + 1.0f - grid.origin[ i ];
+
+		if ( !( extent[ i ] > 0 ) )
+		{
+			return;
+		}
+	}
+
+	grid.cellSize = POINT_GRID_MIN_CELL_SIZE;
+
+	while ( true )
+	{
+		int64_t numCells = 1;
+
+		for ( int i = 0; i < 3; i++ )
+		{
+			grid.size[ i ] = int( ceilf( extent[ i ] / grid.cellSize ) );
+			numCells *= grid.size[ i ];
+		}
+
+		if ( numCells <= POINT_GRID_MAX_CELLS )
+		{
+			break;
+		}
+
+		grid.cellSize *= 2.0f;
+	}
+
+	grid.invCellSize = 1.0f / grid.cellSize;
+
+	int numCells = grid.size[ 0 ] * grid.size[ 1 ] * grid.size[ 2 ];
+	grid.cells = static_cast<cPointCell_t *>( CM_Alloc( numCells * sizeof( cPointCell_t ) ) );
+
+	std::vector<int> leafs;
+	leafs.reserve( POINT_GRID_MAX_CELL_LEAFS );
+	int numUniform = 0;
+	cPointCell_t *cell = grid.cells;
+
+	for ( int z = 0; z < grid.size[ 2 ]; z++ )
+	{
+		for ( int y = 0; y < grid.size[ 1 ]; y++ )
+		{
+			for ( int x = 0; x < grid.size[ 0 ]; x++, cell++ )
+			{
+				const int index[ 3 ] = { x, y, z };
+				cellBounds_t box;
+
+				for ( int i = 0; i < 3; i++ )
+				{
+					box.mins[ i ] = grid.origin[ i ] + double( grid.cellSize ) * index[ i ] - POINT_GRID_MARGIN;
+					box.maxs[ i ] = grid.origin[ i ] + double( grid.cellSize ) * ( index[ i ] + 1 ) + POINT_GRID_MARGIN;
+				}
+
+				CM_ClassifyCell( box, *cell, leafs );
+
+				if ( cell->uniform )
+				{
+					numUniform++;
+				}
+			}
+		}
+	}
+
+	cmLog.Verbose( "Point grid: %dx%dx%d cells of %g units, %d with uniform contents",
+	               grid.size[ 0 ], grid.size[ 1 ], grid.size[ 2 ], grid.cellSize, numUniform );
+}
+
+/*
+==================
+CM_PointGridCell
+
+Returns nullptr if p is outside of the grid
+==================
+*/
+const cPointCell_t *CM_PointGridCell( const vec3_t p )
+{
+	const cPointGrid_t &grid = cm.pointGrid;
+
+	if ( !grid.cells )
+	{
+		return nullptr;
+	}
+
+	int index[ 3 ];
+
+	for ( int i = 0; i < 3; i++ )
+	{
+		float cell = ( p[ i ] - grid.origin[ i ] ) * grid.invCellSize;
+
+		// also rejects NaNs
+		if ( !( cell >= 0 && cell < grid.size[ i ] ) )
+		{
+			return nullptr;
+		}
+
+		index[ i ] = std::min( int( cell ), grid.size[ i ] - 1 );
+	}
+
+	return &grid.cells[ ( index[ 2 ] * grid.size[ 1 ] + index[ 1 ] ) * grid.size[ 0 ] + index[ 0 ] ];
+}
@@ -47,8 +47,8 @@ static const int BOX_PLANES       = 12;
 #define LL( x ) x = LittleLong( x )
 
 clipMap_t cm;
-int       c_pointcontents;
-int       c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces;
+ENGINE_THREAD_LOCAL int c_pointcontents;
+ENGINE_THREAD_LOCAL int c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces, c_facets;
 
 static cmodel_t  box_model;
 static cplane_t  *box_planes;
@@ -70,6 +70,16 @@ void* CM_Alloc( size_t size )
     return alloc;
 }
 
+void CM_Free( void *alloc )
+{
+    auto it = std::find(allocations.begin(), allocations.end(), alloc);
+    if (it != allocations.end())
+    {
+        allocations.erase(it);
+        free(alloc);
+    }
+}
+
 void CM_FreeAll()
 {
     for (auto alloc : allocations)
@@ -300,6 +310,37 @@ static void CMod_LoadBrushes(const byte *const cmod_base, const lump_t *l)
 
 		CM_BoundBrush( out );
 	}
+
+#if defined(DAEMON_USE_ARCH_INTRINSICS_i686_sse)
+	// padding planes are all zeros, the kernels ignore them
+	int numGroups = 0;
+
+	for ( i = 0; i < count; i++ )
+	{
+		numGroups += ( cm.brushes[ i ].numsides + BRUSH_PLANE_GROUP_SIZE - 1 ) / BRUSH_PLANE_GROUP_SIZE;
+	}
+
+	float *groups = ( float * ) CM_Alloc( numGroups * BRUSH_PLANE_GROUP_FLOATS * sizeof( float ) );
+
+	for ( i = 0, out = cm.brushes; i < count; i++, out++ )
+	{
+		out->planeGroups = groups;
+
+		for ( int side = 0; side < out->numsides; side++ )
+		{
+			const cplane_t *plane = out->sides[ side ].plane;
+			float *group = groups + ( side / BRUSH_PLANE_GROUP_SIZE ) * BRUSH_PLANE_GROUP_FLOATS;
+			int lane = side % BRUSH_PLANE_GROUP_SIZE;
+
+			group[ lane ] = plane->normal[ 0 ];
+			group[ BRUSH_PLANE_GROUP_SIZE + lane ] = plane->normal[ 1 ];
+			group[ 2 * BRUSH_PLANE_GROUP_SIZE + lane ] = plane->normal[ 2 ];
+			group[ 3 * BRUSH_PLANE_GROUP_SIZE + lane ] = plane->dist;
+		}
+
+		groups += ( ( out->numsides + BRUSH_PLANE_GROUP_SIZE - 1 ) / BRUSH_PLANE_GROUP_SIZE ) * BRUSH_PLANE_GROUP_FLOATS;
+	}
+#endif
 }
 
 /*
@@ -769,7 +810,7 @@ void CM_LoadMap(Str::StringRef name)
 	std::string mapFile = "maps/" + name + ".bsp";
 
 	std::error_code err;
-	std::string mapData = FS::PakPath::ReadFile(mapFile, err);
+	FS::PakPath::FileView mapData = FS::PakPath::ReadFileView(mapFile, err);
 	if (err) {
 		Sys::Drop("Could not load %s: %s (code: %d)", mapFile.c_str(), err.message(), err.value() );
 	}
@@ -797,7 +838,18 @@ void CM_LoadMap(Str::StringRef name)
 		return;
 	}
 
-	header = * ( dheader_t * ) mapData.data();
+	// The lumps are read in place, which needs the alignment of their
+	// structures; a file stored in a pak may start anywhere
+	std::string alignedData;
+	const char *mapBytes = mapData.data();
+
+	if ( reinterpret_cast<uintptr_t>( mapBytes ) % alignof( int ) )
+	{
+		alignedData.assign( mapBytes, mapData.size() );
+		mapBytes = alignedData.data();
+	}
+
+	header = * ( const dheader_t * ) mapBytes;
 
 	for (unsigned i = 0; i < sizeof( dheader_t ) / 4; i++ )
 	{
@@ -810,7 +862,8 @@ void CM_LoadMap(Str::StringRef name)
 		           name.c_str(), header.version, BSP_VERSION, BSP_VERSION_Q3 );
 	}
 
-	const byte *const cmod_base = reinterpret_cast<const byte*>(mapData.data());
+	const byte *const cmod_base = reinterpret_cast<const byte*>(mapBytes);
+	const uint64_t bspHash = CM_CacheHash( mapBytes, mapData.size() );
 
 	// load into heap
 	CMod_LoadShaders(cmod_base, &header.lumps[LUMP_SHADERS]);
@@ -824,12 +877,25 @@ void CM_LoadMap(Str::StringRef name)
 	CMod_LoadNodes(cmod_base, &header.lumps[LUMP_NODES]);
 	CMod_LoadEntityString(cmod_base, &header.lumps[LUMP_ENTITIES], externalEntities);
 	CMod_LoadVisibility(cmod_base, &header.lumps[LUMP_VISIBILITY]);
-	CMod_LoadSurfaces(cmod_base,
-					  &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS], &header.lumps[LUMP_DRAWINDEXES]);
+
+	// the surfaces depend on the entity string for perPolyCollision
+	cm.cached = CM_ReadCache( name, bspHash );
+
+	if ( !cm.cached )
+	{
+		CMod_LoadSurfaces(cmod_base,
+						  &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS], &header.lumps[LUMP_DRAWINDEXES]);
+	}
 
 	CM_InitBoxHull();
 
 	CM_FloodAreaConnections();
+
+	if ( !cm.cached )
+	{
+		CM_BuildPointGrid();
+		CM_WriteCache( name, bspHash );
+	}
 }
 
 /*
@@ -974,6 +1040,9 @@ CM_TempBoxModel
 To keep everything totally uniform, bounding boxes are turned into small
 BSP trees instead of being compared directly.
 Capsules are handled differently though.
+
+There is a single temporary box, so unlike the other queries this must not
+be used from several threads at once.
 ===================
 */
 clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, bool capsule )
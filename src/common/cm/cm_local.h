@@ -74,13 +74,18 @@ struct cbrushside_t
 	int       surfaceFlags;
 };
 
+// Brush planes are also stored in groups of 4 for the SIMD trace kernels:
+// the x, y and z components of the normals, then the distances
+static const int BRUSH_PLANE_GROUP_SIZE = 4;
+static const int BRUSH_PLANE_GROUP_FLOATS = 4 * BRUSH_PLANE_GROUP_SIZE;
+
 struct cbrush_t
 {
 	int          contents;
 	vec3_t       bounds[ 2 ];
 	int          numsides;
 	cbrushside_t *sides;
-	int          checkcount; // to avoid repeated testings
+	const float  *planeGroups; // nullptr if the SIMD kernels can't be used, as for the temporary box
 };
 
 struct cPlane_t
@@ -127,6 +132,17 @@ struct cFacet_t
 	bool     borderInward[ MAX_FACET_BEVELS ];
 };
 
+// A node of the bounding volume hierarchy over the facets of a surface. The
+// facets of a node are a contiguous range that its two children split, so
+// visiting the children in order visits the facets in their original order.
+struct cFacetNode_t
+{
+	vec3_t bounds[ 2 ]; // the facets can't collide with a trace whose origin stays outside, once expanded by its extents
+	int    firstFacet;
+	int    numFacets;
+	int    firstChild; // the second child follows, 0 for leaves
+};
+
 struct cSurfaceCollide_t
 {
 	vec3_t   bounds[ 2 ];
@@ -135,11 +151,13 @@ struct cSurfaceCollide_t
 
 	int      numFacets;
 	cFacet_t *facets;
+
+	int          numNodes; // 0 if there is no facet tree
+	cFacetNode_t *nodes;
 };
 
 struct cSurface_t
 {
-	int               checkcount; // to avoid repeated testings
 	int               surfaceFlags;
 	int               contents;
 	cSurfaceCollide_t *sc;
@@ -152,6 +170,23 @@ struct cArea_t
 	int floodvalid;
 };
 
+// A cell of the point grid, see cm_grid.cpp
+struct cPointCell_t
+{
+	int  node; // deepest node whose subtree holds the whole cell, negative for a leaf
+	bool uniform; // every point of the cell has the same contents
+	int  contents; // only valid if uniform
+};
+
+struct cPointGrid_t
+{
+	vec3_t       origin;
+	float        cellSize;
+	float        invCellSize;
+	int          size[ 3 ];
+	cPointCell_t *cells; // nullptr if there is no grid
+};
+
 struct clipMap_t
 {
 	int          numShaders;
@@ -197,8 +232,11 @@ struct clipMap_t
 	cSurface_t   **surfaces; // non-patches will be nullptr
 
 	int          floodvalid;
-	int          checkcount; // incremented on each trace
 	bool     perPolyCollision;
+
+	cPointGrid_t pointGrid;
+
+	bool         cached; // the surfaces and the point grid come from the collision cache
 };
 
 // keep 1/8 unit away to keep the position valid before network snapping
@@ -214,9 +252,8 @@ struct clipMap_t
 #define SURFACE_CLIP_EPSILON ( 0.125f )
 
 extern clipMap_t cm;
-extern int       c_pointcontents;
-extern int       c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces;
 extern Cvar::Cvar<bool> cm_forceTriangles;
+extern Cvar::Cvar<bool> cm_pointGrid;
 extern Log::Logger cmLog;
 
 // cm_test.c
@@ -229,6 +266,8 @@ struct sphere_t
 	vec3_t offset;
 };
 
+struct cTraceScratch_t;
+
 struct traceWork_t
 {
 	traceType_t type;
@@ -245,6 +284,7 @@ struct traceWork_t
 	bool    isPoint; // optimized case
 	trace_t     trace; // returned from trace call
 	sphere_t    sphere; // sphere for oriendted capsule collision
+	cTraceScratch_t *scratch; // per thread buffers, including the brushes and surfaces already tested
 };
 
 struct leafList_t
@@ -278,6 +318,7 @@ cSurfaceCollide_t              *CM_GenerateTriangleSoupCollide( int numVertexes,
 
 
 void* CM_Alloc( size_t size );
+void  CM_Free( void *alloc );
 
 // cm_plane.c
 
@@ -300,6 +341,17 @@ void     CM_AddFacetBevels( cFacet_t *facet );
 bool CM_GenerateFacetFor3Points( cFacet_t *facet, const vec3_t p1, const vec3_t p2, const vec3_t p3 );
 bool CM_GenerateFacetFor4Points( cFacet_t *facet, const vec3_t p1, const vec3_t p2, const vec3_t p3, const vec3_t p4 );
 
+void     CM_BuildFacetTree( cSurfaceCollide_t *sc );
+
+
+// cm_grid.cpp
+void                           CM_BuildPointGrid();
+const cPointCell_t             *CM_PointGridCell( const vec3_t p );
+
+// cm_cache.cpp
+uint64_t                       CM_CacheHash( const void *data, size_t size );
+bool                           CM_ReadCache( Str::StringRef name, uint64_t bspHash );
+void                           CM_WriteCache( Str::StringRef name, uint64_t bspHash );
 
 // cm_test.c
 void                           CM_StoreLeafs( leafList_t *ll, int nodenum );
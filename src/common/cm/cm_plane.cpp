@@ -688,3 +688,116 @@ bool CM_GenerateFacetFor3Points( cFacet_t *facet, const vec3_t p1, const vec3_t
 
 	return true;
 }
+
+/*
+=====================
+CM_FacetBounds
+
+Bounds of the facet taken from its axial planes, which CM_AddFacetBevels
+adds. A trace never collides with the facet while its origin stays
+outside of them, once they are pushed out by the extents of the trace.
+A side without an axial plane is left unbounded.
+=====================
+*/
+static void CM_FacetBounds( const cSurfaceCollide_t *sc, const cFacet_t *facet, vec3_t mins, vec3_t maxs )
+{
+	const float infinity = std::numeric_limits<float>::infinity();
+	VectorSet( mins, -infinity, -infinity, -infinity );
+	VectorSet( maxs, infinity, infinity, infinity );
+
+	for ( int j = -1; j < facet->numBorders; j++ )
+	{
+		// -1 is the surface plane
+		plane_t plane = sc->planes[ j < 0 ? facet->surfacePlane : facet->borderPlanes[ j ] ].plane;
+
+		if ( j >= 0 && facet->borderInward[ j ] )
+		{
+			VectorNegate( plane.normal, plane.normal );
+			plane.dist = -plane.dist;
+		}
+
+		for ( int axis = 0; axis < 3; axis++ )
+		{
+			if ( plane.normal[ ( axis + 1 ) % 3 ] != 0 || plane.normal[ ( axis + 2 ) % 3 ] != 0 )
+			{
+				continue;
+			}
+
+			if ( plane.normal[ axis ] == 1 )
+			{
+				maxs[ axis ] = std::min( maxs[ axis ], plane.dist );
+			}
+			else if ( plane.normal[ axis ] == -1 )
+			{
+				mins[ axis ] = std::max( mins[ axis ], -plane.dist );
+			}
+		}
+	}
+}
+
+static const int FACET_TREE_LEAF_SIZE = 4;
+
+static void CM_BuildFacetNode( std::vector<cFacetNode_t> &nodes, int num, const std::vector<std::array<vec3_t, 2>> &facetBounds,
+                               int firstFacet, int numFacets )
+{
+	cFacetNode_t node{};
+	node.firstFacet = firstFacet;
+	node.numFacets = numFacets;
+	ClearBounds( node.bounds[ 0 ], node.bounds[ 1 ] );
+
+	for ( int i = firstFacet; i < firstFacet + numFacets; i++ )
+	{
+		for ( int axis = 0; axis < 3; axis++ )
+		{
+			node.bounds[ 0 ][ axis ] = std::min( node.bounds[ 0 ][ axis ], facetBounds[ i ][ 0 ][ axis ] );
+			node.bounds[ 1 ][ axis ] = std::max( node.bounds[ 1 ][ axis ], facetBounds[ i ][ 1 ][ axis ] );
+		}
+	}
+
+	if ( numFacets <= FACET_TREE_LEAF_SIZE )
+	{
+		nodes[ num ] = node;
+		return;
+	}
+
+	node.firstChild = nodes.size();
+	nodes.resize( nodes.size() + 2 );
+	nodes[ num ] = node;
+
+	// patch facets come row by row and triangle soups are mostly in mesh
+	// order, so splitting the range in halves keeps the nodes compact
+	int half = numFacets / 2;
+	CM_BuildFacetNode( nodes, node.firstChild, facetBounds, firstFacet, half );
+	CM_BuildFacetNode( nodes, node.firstChild + 1, facetBounds, firstFacet + half, numFacets - half );
+}
+
+/*
+=====================
+CM_BuildFacetTree
+=====================
+*/
+void CM_BuildFacetTree( cSurfaceCollide_t *sc )
+{
+	sc->numNodes = 0;
+	sc->nodes = nullptr;
+
+	// the bounds of the whole surface are tested first anyway
+	if ( sc->numFacets <= FACET_TREE_LEAF_SIZE )
+	{
+		return;
+	}
+
+	std::vector<std::array<vec3_t, 2>> facetBounds( sc->numFacets );
+
+	for ( int i = 0; i < sc->numFacets; i++ )
+	{
+		CM_FacetBounds( sc, &sc->facets[ i ], facetBounds[ i ][ 0 ], facetBounds[ i ][ 1 ] );
+	}
+
+	std::vector<cFacetNode_t> nodes( 1 );
+	CM_BuildFacetNode( nodes, 0, facetBounds, 0, sc->numFacets );
+
+	sc->numNodes = nodes.size();
+	sc->nodes = ( cFacetNode_t * ) CM_Alloc( nodes.size() * sizeof( cFacetNode_t ) );
+	std::copy( nodes.begin(), nodes.end(), sc->nodes );
+}
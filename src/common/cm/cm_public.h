@@ -60,6 +60,7 @@ std::string CM_CheckTraceConsistency( const vec3_t start, const vec3_t end, int
 
 float CM_DistanceToModel( const vec3_t loc, clipHandle_t model );
 
+int  CM_NumClusters();
 byte *CM_ClusterPVS( int cluster );
 
 int  CM_PointLeafnum( const vec3_t p );
@@ -79,3 +80,8 @@ int      CM_WriteAreaBits( byte *buffer, int area );
 // cm_marks.c
 int      CM_MarkFragments( int numPoints, const vec3_t *points, const vec3_t projection,
                            int maxPoints, vec3_t pointBuffer, int maxFragments, markFragment_t *fragmentBuffer );
+
+// query statistics, the engine may query the collision model from several
+// threads at once so they are counted per thread
+extern ENGINE_THREAD_LOCAL int c_pointcontents;
+extern ENGINE_THREAD_LOCAL int c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces, c_facets;
@@ -85,7 +85,8 @@ int CM_PointLeafnum( const vec3_t p )
 		return 0;
 	}
 
-	return CM_PointLeafnum_r( p, 0 );
+	const cPointCell_t *cell = CM_PointGridCell( p );
+	return CM_PointLeafnum_r( p, cell ? cell->node : 0 );
 }
 
 /*
@@ -168,8 +169,6 @@ int CM_BoxLeafnums( const vec3_t mins, const vec3_t maxs, int *list, int listsiz
 {
 	leafList_t ll;
 
-	cm.checkcount++;
-
 	VectorCopy( mins, ll.bounds[ 0 ] );
 	VectorCopy( maxs, ll.bounds[ 1 ] );
 	ll.count = 0;
@@ -213,7 +212,14 @@ int CM_PointContents( const vec3_t p, clipHandle_t model )
 	}
 	else
 	{
-		leafnum = CM_PointLeafnum_r( p, 0 );
+		const cPointCell_t *cell = CM_PointGridCell( p );
+
+		if ( cell && cell->uniform )
+		{
+			return cell->contents;
+		}
+
+		leafnum = CM_PointLeafnum_r( p, cell ? cell->node : 0 );
 		leaf = &cm.leafs[ leafnum ];
 	}
 
@@ -307,6 +313,11 @@ PVS
 ===============================================================================
 */
 
+int CM_NumClusters()
+{
+	return cm.numClusters;
+}
+
 byte           *CM_ClusterPVS( int cluster )
 {
 	if ( cluster < 0 || cluster >= cm.numClusters || !cm.vised )
@@ -44,6 +44,60 @@ Maryland 20850 USA.
 static Cvar::Cvar<bool> cm_noCurves(VM_STRING_PREFIX "cm_noCurves",
 	"treat BSP patches as empty space for collision detection", Cvar::CHEAT, false);
 
+struct cTraceScratch_t
+{
+	// a brush or surface was already tested by the current trace if its entry is checkcount
+	unsigned              checkcount = 0;
+	std::vector<unsigned> brushChecks;
+	std::vector<unsigned> surfaceChecks;
+
+	// for CM_TracePointThroughSurfaceCollide
+	std::vector<uint8_t>  frontFacing;
+	std::vector<float>    intersection;
+
+	// for CM_NearbyFacets
+	std::vector<int>      facets;
+};
+
+// the engine may trace from several threads at once
+static ENGINE_THREAD_LOCAL cTraceScratch_t traceScratch;
+
+/*
+================
+CM_BeginTraceChecks
+
+Returns the scratch buffers of this thread, with no brush or surface
+marked as tested
+================
+*/
+static cTraceScratch_t *CM_BeginTraceChecks()
+{
+	cTraceScratch_t *scratch = &traceScratch;
+
+	// the map may have changed since the last trace, entries of the brushes
+	// that are new here start at 0 which is never the current checkcount
+	size_t numBrushes = cm.numBrushes + 1; // and the box brush
+
+	if ( scratch->brushChecks.size() < numBrushes )
+	{
+		scratch->brushChecks.resize( numBrushes );
+	}
+
+	if ( scratch->surfaceChecks.size() < size_t( cm.numSurfaces ) )
+	{
+		scratch->surfaceChecks.resize( cm.numSurfaces );
+	}
+
+	if ( ++scratch->checkcount == 0 )
+	{
+		std::fill( scratch->brushChecks.begin(), scratch->brushChecks.end(), 0 );
+		std::fill( scratch->surfaceChecks.begin(), scratch->surfaceChecks.end(), 0 );
+		scratch->checkcount = 1;
+	}
+
+	return scratch;
+}
+
 /*
 ===============================================================================
 
@@ -150,6 +204,164 @@ float CM_DistanceFromLineSquared( const vec3_t p, const vec3_t lp1, const vec3_t
 	return VectorLengthSquared( t );
 }
 
+#if defined(DAEMON_USE_ARCH_INTRINSICS_i686_sse)
+/*
+===============================================================================
+
+SIMD BRUSH KERNELS
+
+These test 4 planes of a brush at once using its planeGroups. They do the
+same float operations in the same order as the scalar loops, so the results
+are identical.
+
+===============================================================================
+*/
+
+// Bit i is set if side first + i exists
+static int CM_PlaneGroupLanes( int first, int numSides )
+{
+	return ( 1 << std::min( numSides - first, BRUSH_PLANE_GROUP_SIZE ) ) - 1;
+}
+
+// plane->dist - DotProduct( tw->offsets[ plane->signbits ], plane->normal ) for the 4 planes
+static __m128 CM_PlaneGroupPushedDists( const traceWork_t *tw, const float *group )
+{
+	__m128 zero = _mm_setzero_ps();
+	__m128 normal[ 3 ];
+	__m128 offset[ 3 ];
+
+	for ( int i = 0; i < 3; i++ )
+	{
+		normal[ i ] = _mm_loadu_ps( group + i * BRUSH_PLANE_GROUP_SIZE );
+
+		// the sign bit of axis i picks the corner
+		__m128 negative = _mm_cmplt_ps( normal[ i ], zero );
+		offset[ i ] = _mm_or_ps( _mm_and_ps( negative, _mm_set1_ps( tw->offsets[ 1 << i ][ i ] ) ),
+		                         _mm_andnot_ps( negative, _mm_set1_ps( tw->offsets[ 0 ][ i ] ) ) );
+	}
+
+	__m128 dot = _mm_add_ps( _mm_add_ps( _mm_mul_ps( offset[ 0 ], normal[ 0 ] ), _mm_mul_ps( offset[ 1 ], normal[ 1 ] ) ),
+	                         _mm_mul_ps( offset[ 2 ], normal[ 2 ] ) );
+	return _mm_sub_ps( _mm_loadu_ps( group + 3 * BRUSH_PLANE_GROUP_SIZE ), dot );
+}
+
+// DotProduct( p, plane->normal ) - dist for the 4 planes
+static __m128 CM_PlaneGroupDistances( const float *group, const vec3_t p, __m128 dist )
+{
+	__m128 dot = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( p[ 0 ] ), _mm_loadu_ps( group ) ),
+	                                     _mm_mul_ps( _mm_set1_ps( p[ 1 ] ), _mm_loadu_ps( group + BRUSH_PLANE_GROUP_SIZE ) ) ),
+	                         _mm_mul_ps( _mm_set1_ps( p[ 2 ] ), _mm_loadu_ps( group + 2 * BRUSH_PLANE_GROUP_SIZE ) ) );
+	return _mm_sub_ps( dot, dist );
+}
+
+/*
+================
+CM_BoxOutsidePlaneGroups
+
+The box version of the plane loop in CM_TestBoxInBrush
+================
+*/
+static bool CM_BoxOutsidePlaneGroups( const traceWork_t *tw, const cbrush_t *brush, int firstSide )
+{
+	__m128 zero = _mm_setzero_ps();
+
+	for ( int first = firstSide - firstSide % BRUSH_PLANE_GROUP_SIZE; first < brush->numsides; first += BRUSH_PLANE_GROUP_SIZE )
+	{
+		const float *group = brush->planeGroups + ( first / BRUSH_PLANE_GROUP_SIZE ) * BRUSH_PLANE_GROUP_FLOATS;
+		int lanes = CM_PlaneGroupLanes( first, brush->numsides ) & ~( ( 1 << std::max( firstSide - first, 0 ) ) - 1 );
+		__m128 d1 = CM_PlaneGroupDistances( group, tw->start, CM_PlaneGroupPushedDists( tw, group ) );
+
+		// if completely in front of face, no intersection
+		if ( _mm_movemask_ps( _mm_cmpgt_ps( d1, zero ) ) & lanes )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+================
+CM_ClipToPlaneGroups
+
+The box version of the plane loop in CM_TraceThroughBrush, returns false
+if the trace can't intersect the brush
+================
+*/
+static bool CM_ClipToPlaneGroups( const traceWork_t *tw, const cbrush_t *brush, float &enterFrac, float &leaveFrac,
+                                  const cplane_t *&clipplane, const cbrushside_t *&leadside, bool &getout, bool &startout )
+{
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps( 1.0f );
+	__m128 epsilon = _mm_set1_ps( SURFACE_CLIP_EPSILON );
+	int endOut = 0;
+	int startOut = 0;
+
+	for ( int first = 0; first < brush->numsides; first += BRUSH_PLANE_GROUP_SIZE )
+	{
+		const float *group = brush->planeGroups + ( first / BRUSH_PLANE_GROUP_SIZE ) * BRUSH_PLANE_GROUP_FLOATS;
+		int lanes = CM_PlaneGroupLanes( first, brush->numsides );
+		__m128 dist = CM_PlaneGroupPushedDists( tw, group );
+		__m128 d1 = CM_PlaneGroupDistances( group, tw->start, dist );
+		__m128 d2 = CM_PlaneGroupDistances( group, tw->end, dist );
+
+		int d1Out = _mm_movemask_ps( _mm_cmpgt_ps( d1, zero ) ) & lanes;
+		int d2Out = _mm_movemask_ps( _mm_cmpgt_ps( d2, zero ) ) & lanes;
+		endOut |= d2Out;
+		startOut |= d1Out;
+
+		// if completely in front of face, no intersection with the entire brush
+		if ( _mm_movemask_ps( _mm_or_ps( _mm_cmpge_ps( d2, epsilon ), _mm_cmpge_ps( d2, d1 ) ) ) & d1Out )
+		{
+			return false;
+		}
+
+		// if it doesn't cross the plane, the plane isn't relevant
+		int crosses = ~_mm_movemask_ps( _mm_and_ps( _mm_cmple_ps( d1, zero ), _mm_cmple_ps( d2, zero ) ) ) & lanes;
+
+		if ( !crosses )
+		{
+			continue;
+		}
+
+		int enters = _mm_movemask_ps( _mm_cmpgt_ps( d1, d2 ) );
+		__m128 delta = _mm_sub_ps( d1, d2 );
+		alignas( 16 ) float enterFracs[ BRUSH_PLANE_GROUP_SIZE ];
+		alignas( 16 ) float leaveFracs[ BRUSH_PLANE_GROUP_SIZE ];
+		_mm_store_ps( enterFracs, _mm_max_ps( zero, _mm_div_ps( _mm_sub_ps( d1, epsilon ), delta ) ) );
+		_mm_store_ps( leaveFracs, _mm_min_ps( one, _mm_div_ps( _mm_add_ps( d1, epsilon ), delta ) ) );
+
+		// in side order, so that ties pick the same plane as the scalar loop
+		for ( int lane = 0; lane < BRUSH_PLANE_GROUP_SIZE; lane++ )
+		{
+			if ( !( crosses & ( 1 << lane ) ) )
+			{
+				continue;
+			}
+
+			if ( enters & ( 1 << lane ) )
+			{
+				if ( enterFracs[ lane ] > enterFrac )
+				{
+					enterFrac = enterFracs[ lane ];
+					leadside = &brush->sides[ first + lane ];
+					clipplane = leadside->plane;
+				}
+			}
+			else if ( leaveFracs[ lane ] < leaveFrac )
+			{
+				leaveFrac = leaveFracs[ lane ];
+			}
+		}
+	}
+
+	getout = endOut != 0;
+	startout = startOut != 0;
+	return true;
+}
+#endif
+
 /*
 ===============================================================================
 
@@ -222,6 +434,15 @@ static void CM_TestBoxInBrush( traceWork_t *tw, const cbrush_t *brush )
 			}
 		}
 	}
+#if defined(DAEMON_USE_ARCH_INTRINSICS_i686_sse)
+	else if ( brush->planeGroups )
+	{
+		if ( CM_BoxOutsidePlaneGroups( tw, brush, 6 ) )
+		{
+			return;
+		}
+	}
+#endif
 	else
 	{
 		for ( const cbrushside_t *side = firstSide; side < endSide; side++ )
@@ -247,6 +468,81 @@ static void CM_TestBoxInBrush( traceWork_t *tw, const cbrush_t *brush )
 	tw->trace.contents = brush->contents;
 }
 
+/*
+====================
+CM_NearbyFacets
+
+Lists the facets of the surface that the trace may collide with, in order
+====================
+*/
+static const std::vector<int> &CM_NearbyFacets( traceWork_t *tw, const cSurfaceCollide_t *sc )
+{
+	std::vector<int> &facets = tw->scratch->facets;
+	facets.clear();
+
+	if ( !sc->numNodes )
+	{
+		for ( int i = 0; i < sc->numFacets; i++ )
+		{
+			facets.push_back( i );
+		}
+
+		return facets;
+	}
+
+	// the facet planes are pushed out by at most the extents of the trace,
+	// and one more unit covers the clip epsilon
+	vec3_t mins, maxs;
+
+	for ( int i = 0; i < 3; i++ )
+	{
+		float extent;
+
+		if ( tw->type == traceType_t::TT_CAPSULE )
+		{
+			extent = fabsf( tw->sphere.offset[ i ] ) + tw->sphere.radius;
+		}
+		else
+		{
+			extent = std::max( fabsf( tw->size[ 0 ][ i ] ), fabsf( tw->size[ 1 ][ i ] ) );
+		}
+
+		mins[ i ] = std::min( tw->start[ i ], tw->end[ i ] ) - extent - 1.0f;
+		maxs[ i ] = std::max( tw->start[ i ], tw->end[ i ] ) + extent + 1.0f;
+	}
+
+	int stack[ 64 ];
+	int depth = 0;
+	stack[ depth++ ] = 0;
+
+	while ( depth )
+	{
+		const cFacetNode_t *node = &sc->nodes[ stack[ --depth ] ];
+
+		if ( node->bounds[ 0 ][ 0 ] > maxs[ 0 ] || node->bounds[ 0 ][ 1 ] > maxs[ 1 ] || node->bounds[ 0 ][ 2 ] > maxs[ 2 ]
+		     || node->bounds[ 1 ][ 0 ] < mins[ 0 ] || node->bounds[ 1 ][ 1 ] < mins[ 1 ] || node->bounds[ 1 ][ 2 ] < mins[ 2 ] )
+		{
+			continue;
+		}
+
+		if ( !node->firstChild )
+		{
+			for ( int i = node->firstFacet; i < node->firstFacet + node->numFacets; i++ )
+			{
+				facets.push_back( i );
+			}
+
+			continue;
+		}
+
+		// the first child is popped first, so the facets stay in order
+		stack[ depth++ ] = node->firstChild + 1;
+		stack[ depth++ ] = node->firstChild;
+	}
+
+	return facets;
+}
+
 /*
 ====================
 CM_PositionTestInSurfaceCollide
@@ -254,7 +550,7 @@ CM_PositionTestInSurfaceCollide
 */
 static bool CM_PositionTestInSurfaceCollide( traceWork_t *tw, const cSurfaceCollide_t *sc )
 {
-	int      i, j;
+	int      j;
 	float    offset, t;
 	cPlane_t *planes;
 	cFacet_t *facet;
@@ -265,11 +561,11 @@ static bool CM_PositionTestInSurfaceCollide( traceWork_t *tw, const cSurfaceColl
 		return false;
 	}
 
-	//
-	facet = sc->facets;
-
-	for ( i = 0; i < sc->numFacets; i++, facet++ )
+	for ( int facetNum : CM_NearbyFacets( tw, sc ) )
 	{
+		facet = &sc->facets[ facetNum ];
+		c_facets++;
+
 		planes = &sc->planes[ facet->surfacePlane ];
 
 		plane_t plane = planes->plane;
@@ -372,14 +668,15 @@ void CM_TestInLeaf( traceWork_t *tw, const cLeaf_t *leaf )
 	const int *endBrushNum = firstBrushNum + leaf->numLeafBrushes;
 	for ( const int *brushNum = firstBrushNum; brushNum < endBrushNum; brushNum++ )
 	{
-		cbrush_t *b = &cm.brushes[ *brushNum ];
+		const cbrush_t *b = &cm.brushes[ *brushNum ];
+		unsigned &checkcount = tw->scratch->brushChecks[ *brushNum ];
 
-		if ( b->checkcount == cm.checkcount )
+		if ( checkcount == tw->scratch->checkcount )
 		{
 			continue; // already checked this brush in another leaf
 		}
 
-		b->checkcount = cm.checkcount;
+		checkcount = tw->scratch->checkcount;
 
 		if ( !( b->contents & tw->contents ) )
 		{
@@ -404,19 +701,21 @@ void CM_TestInLeaf( traceWork_t *tw, const cLeaf_t *leaf )
 	const int *endSurfaceNum = firstSurfaceNum + leaf->numLeafSurfaces;
 	for ( const int *surfaceNum = firstSurfaceNum; surfaceNum < endSurfaceNum; surfaceNum++ )
 	{
-		cSurface_t *surface = cm.surfaces[ *surfaceNum ];
+		const cSurface_t *surface = cm.surfaces[ *surfaceNum ];
 
 		if ( !surface )
 		{
 			continue;
 		}
 
-		if ( surface->checkcount == cm.checkcount )
+		unsigned &checkcount = tw->scratch->surfaceChecks[ *surfaceNum ];
+
+		if ( checkcount == tw->scratch->checkcount )
 		{
 			continue; // already checked this surface in another leaf
 		}
 
-		surface->checkcount = cm.checkcount;
+		checkcount = tw->scratch->checkcount;
 
 		if ( !( surface->contents & tw->contents ) )
 		{
@@ -633,12 +932,8 @@ void CM_PositionTest( traceWork_t *tw )
 	ll.lastLeaf = 0;
 	ll.overflowed = false;
 
-	cm.checkcount++;
-
 	CM_BoxLeafnums_r( &ll, 0 );
 
-	cm.checkcount++;
-
 	// test the contents of the leafs
 	for ( i = 0; i < ll.count; i++ )
 	{
@@ -668,8 +963,6 @@ CM_TracePointThroughSurfaceCollide
 */
 void CM_TracePointThroughSurfaceCollide( traceWork_t *tw, const cSurfaceCollide_t *sc )
 {
-	static bool frontFacing[ SHADER_MAX_TRIANGLES ];
-	static float    intersection[ SHADER_MAX_TRIANGLES ];
 	float           intersect;
 	const cPlane_t  *planes;
 	const cFacet_t  *facet;
@@ -680,6 +973,15 @@ void CM_TracePointThroughSurfaceCollide( traceWork_t *tw, const cSurfaceCollide_
 		return;
 	}
 
+	std::vector<uint8_t> &frontFacing = tw->scratch->frontFacing;
+	std::vector<float> &intersection = tw->scratch->intersection;
+
+	if ( frontFacing.size() < static_cast<size_t>( sc->numPlanes ) )
+	{
+		frontFacing.resize( sc->numPlanes );
+		intersection.resize( sc->numPlanes );
+	}
+
 	// determine the trace's relationship to all planes
 	planes = sc->planes;
 
@@ -714,8 +1016,11 @@ void CM_TracePointThroughSurfaceCollide( traceWork_t *tw, const cSurfaceCollide_
 	}
 
 	// see if any of the surface planes are intersected
-	for ( i = 0, facet = sc->facets; i < sc->numFacets; i++, facet++ )
+	for ( int facetNum : CM_NearbyFacets( tw, sc ) )
 	{
+		facet = &sc->facets[ facetNum ];
+		c_facets++;
+
 		if ( !frontFacing[ facet->surfacePlane ] )
 		{
 			continue;
@@ -844,7 +1149,7 @@ CM_TraceThroughSurfaceCollide
 */
 void CM_TraceThroughSurfaceCollide( traceWork_t *tw, const cSurfaceCollide_t *sc )
 {
-	int           i, j, hitnum;
+	int           j, hitnum;
 	float         offset, enterFrac, leaveFrac, t;
 	cPlane_t      *planes;
 	cFacet_t      *facet;
@@ -862,8 +1167,11 @@ void CM_TraceThroughSurfaceCollide( traceWork_t *tw, const cSurfaceCollide_t *sc
 	}
 
 	plane_t bestplane = {};
-	for ( i = 0, facet = sc->facets; i < sc->numFacets; i++, facet++ )
+	for ( int facetNum : CM_NearbyFacets( tw, sc ) )
 	{
+		facet = &sc->facets[ facetNum ];
+		c_facets++;
+
 		enterFrac = -1.0f;
 		leaveFrac = 1.0f;
 		hitnum = -1;
@@ -1147,6 +1455,15 @@ void CM_TraceThroughBrush( traceWork_t *tw, const cbrush_t *brush )
 			}
 		}
 	}
+#if defined(DAEMON_USE_ARCH_INTRINSICS_i686_sse)
+	else if ( brush->planeGroups )
+	{
+		if ( !CM_ClipToPlaneGroups( tw, brush, enterFrac, leaveFrac, clipplane, leadside, getout, startout ) )
+		{
+			return;
+		}
+	}
+#endif
 	else
 	{
 		//
@@ -1271,14 +1588,15 @@ void CM_TraceThroughLeaf( traceWork_t *tw, const cLeaf_t *leaf )
 	const int *endBrushNum = firstBrushNum + leaf->numLeafBrushes;
 	for ( const int *brushNum = firstBrushNum; brushNum < endBrushNum; brushNum++ )
 	{
-		cbrush_t *b = &cm.brushes[ *brushNum ];
+		const cbrush_t *b = &cm.brushes[ *brushNum ];
+		unsigned &checkcount = tw->scratch->brushChecks[ *brushNum ];
 
-		if ( b->checkcount == cm.checkcount )
+		if ( checkcount == tw->scratch->checkcount )
 		{
 			continue; // already checked this brush in another leaf
 		}
 
-		b->checkcount = cm.checkcount;
+		checkcount = tw->scratch->checkcount;
 
 		if ( !( b->contents & tw->contents ) )
 		{
@@ -1314,19 +1632,21 @@ void CM_TraceThroughLeaf( traceWork_t *tw, const cLeaf_t *leaf )
 	const int *endSurfaceNum = firstSurfaceNum + leaf->numLeafSurfaces;
 	for ( const int *surfaceNum = firstSurfaceNum; surfaceNum < endSurfaceNum; surfaceNum++ )
 	{
-		cSurface_t *surface = cm.surfaces[ *surfaceNum ];
+		const cSurface_t *surface = cm.surfaces[ *surfaceNum ];
 
 		if ( !surface )
 		{
 			continue;
 		}
 
-		if ( surface->checkcount == cm.checkcount )
+		unsigned &checkcount = tw->scratch->surfaceChecks[ *surfaceNum ];
+
+		if ( checkcount == tw->scratch->checkcount )
 		{
 			continue; // already checked this surface in another leaf
 		}
 
-		surface->checkcount = cm.checkcount;
+		checkcount = tw->scratch->checkcount;
 
 		if ( !( surface->contents & tw->contents ) )
 		{
@@ -1851,12 +2171,11 @@ static void CM_Trace( trace_t *results, const vec3_t start, const vec3_t end, co
 
 	cmod = CM_ClipHandleToModel( model );
 
-	cm.checkcount++; // for multi-check avoidance
-
 	c_traces++; // for statistics, may be zeroed
 
 	// fill in a default trace
 	traceWork_t tw{};
+	tw.scratch = CM_BeginTraceChecks(); // for multi-check avoidance
 	tw.trace.fraction = 1; // assume it goes the entire distance until shown otherwise
 	VectorCopy( origin, tw.modelOrigin );
 	tw.type = type;
@@ -31,7 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
-#include "cm_public.h"
+#include "cm_local.h"
 #include "common/FileSystem.h"
 
 namespace {
@@ -61,6 +61,22 @@ protected:
     {
         CM_ClearMap();
     }
+
+    // Runs f with the given parts of the map zeroed, which turns off the
+    // acceleration structures they hold to compare with the code without them
+    template<typename T, typename F>
+    static void Without(const std::vector<T*>& values, F f)
+    {
+        std::vector<T> saved;
+        for (T* value : values) {
+            saved.push_back(*value);
+            *value = T();
+        }
+        f();
+        for (size_t i = 0; i < values.size(); i++) {
+            *values[i] = saved[i];
+        }
+    }
 };
 
 // There is non-intersecting brush with fraction exactly 0 and an intersecting at the start brush
@@ -184,4 +200,480 @@ TEST_F(TraceTest, BoxHitPatch)
     EXPECT_NEAR(tr.plane.dist, 362.105, PATCH_PLANE_DIST_ATOL);
 }
 
+TEST_F(TraceTest, ConcurrentTracesMatchSerial)
+{
+    vec3_t worldMins, worldMaxs;
+    CM_ModelBounds(CM_InlineModel(0), worldMins, worldMaxs);
+    std::mt19937 rng(15);
+    auto coord = [&](int axis) {
+        return std::uniform_real_distribution<float>(worldMins[axis], worldMaxs[axis])(rng);
+    };
+
+    // a mix of long and short, point and box traces
+    struct Query {
+        vec3_t start, end, mins, maxs;
+        trace_t tr;
+        int contents;
+    };
+    std::vector<Query> queries(4000);
+    for (size_t i = 0; i < queries.size(); i++) {
+        Query& q = queries[i];
+        float size = i % 2 ? 0.0f : 16.0f;
+        for (int axis = 0; axis < 3; axis++) {
+            q.start[axis] = coord(axis);
+            q.end[axis] = i % 4 < 2 ? coord(axis) : q.start[axis] + std::uniform_real_distribution<float>(-64, 64)(rng);
+            q.mins[axis] = -size;
+            q.maxs[axis] = size;
+        }
+        CM_BoxTrace(&q.tr, q.start, q.end, q.mins, q.maxs, CM_InlineModel(0), contentmask, skipmask, traceType_t::TT_AABB);
+        q.contents = CM_PointContents(q.end, CM_InlineModel(0));
+    }
+
+    std::atomic<int> mismatches(0);
+    auto run = [&](size_t first) {
+        for (size_t i = first; i < queries.size(); i += 4) {
+            const Query& q = queries[i];
+            trace_t tr;
+            CM_BoxTrace(&tr, q.start, q.end, q.mins, q.maxs, CM_InlineModel(0), contentmask, skipmask, traceType_t::TT_AABB);
+            if (tr.fraction != q.tr.fraction || tr.startsolid != q.tr.startsolid || tr.allsolid != q.tr.allsolid
+                    || !VectorCompare(tr.endpos, q.tr.endpos) || !VectorCompare(tr.plane.normal, q.tr.plane.normal)
+                    || CM_PointContents(q.end, CM_InlineModel(0)) != q.contents) {
+                mismatches++;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t first = 0; first < 4; first++) {
+        threads.emplace_back(run, first);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(0, mismatches.load());
+}
+
+class BrushKernelTest : public TraceTest
+{
+protected:
+    struct TraceArgs {
+        vec3_t start, end, mins, maxs;
+    };
+
+    // What a game frame asks for: player moves with a ground check under
+    // each position, and long point traces for shots and visibility
+    static std::vector<TraceArgs> GameTraces(int count)
+    {
+        vec3_t worldMins, worldMaxs;
+        CM_ModelBounds(CM_InlineModel(0), worldMins, worldMaxs);
+        std::mt19937 rng(16);
+        auto uniform = [&](float min, float max) {
+            return std::uniform_real_distribution<float>(min, max)(rng);
+        };
+
+        std::vector<TraceArgs> traces(count);
+        vec3_t position;
+        for (int i = 0; i < count; i++) {
+            TraceArgs& t = traces[i];
+            if (i % 50 == 0) {
+                for (int axis = 0; axis < 3; axis++) {
+                    position[axis] = uniform(worldMins[axis], worldMaxs[axis]);
+                }
+            }
+            switch (i % 3) {
+            case 0: // move
+                VectorSet(t.mins, -15, -15, -24);
+                VectorSet(t.maxs, 15, 15, 32);
+                VectorCopy(position, t.start);
+                VectorSet(t.end, position[0] + uniform(-40, 40), position[1] + uniform(-40, 40), position[2] + uniform(-8, 8));
+                VectorCopy(t.end, position);
+                break;
+            case 1: // ground
+                VectorSet(t.mins, -15, -15, -24);
+                VectorSet(t.maxs, 15, 15, 32);
+                VectorCopy(position, t.start);
+                VectorSet(t.end, position[0], position[1], position[2] - 0.25f);
+                break;
+            case 2: // shot
+                VectorClear(t.mins);
+                VectorClear(t.maxs);
+                VectorCopy(position, t.start);
+                for (int axis = 0; axis < 3; axis++) {
+                    t.end[axis] = uniform(worldMins[axis], worldMaxs[axis]);
+                }
+                break;
+            }
+        }
+        return traces;
+    }
+
+    // Without them, only the scalar kernels are used
+    static std::vector<const float**> PlaneGroups()
+    {
+        std::vector<const float**> groups;
+        for (int i = 0; i < cm.numBrushes; i++) {
+            groups.push_back(&cm.brushes[i].planeGroups);
+        }
+        return groups;
+    }
+};
+
+TEST_F(BrushKernelTest, SameResultsAsScalar)
+{
+    std::vector<TraceArgs> traces = GameTraces(30000);
+    std::vector<trace_t> results(traces.size());
+    for (size_t i = 0; i < traces.size(); i++) {
+        const TraceArgs& t = traces[i];
+        CM_BoxTrace(&results[i], t.start, t.end, t.mins, t.maxs, CM_InlineModel(0), contentmask, skipmask, traceType_t::TT_AABB);
+        ASSERT_EQ(CM_CheckTraceConsistency(t.start, t.end, contentmask, skipmask, results[i]), "") << "trace " << i;
+    }
+
+    Without(PlaneGroups(), [&] {
+        for (size_t i = 0; i < traces.size(); i++) {
+            const TraceArgs& t = traces[i];
+            trace_t tr;
+            CM_BoxTrace(&tr, t.start, t.end, t.mins, t.maxs, CM_InlineModel(0), contentmask, skipmask, traceType_t::TT_AABB);
+            ASSERT_EQ(tr.fraction, results[i].fraction) << "trace " << i;
+            ASSERT_EQ(tr.startsolid, results[i].startsolid) << "trace " << i;
+            ASSERT_EQ(tr.allsolid, results[i].allsolid) << "trace " << i;
+            ASSERT_EQ(tr.contents, results[i].contents) << "trace " << i;
+            ASSERT_EQ(tr.surfaceFlags, results[i].surfaceFlags) << "trace " << i;
+            ASSERT_EQ(tr.plane.dist, results[i].plane.dist) << "trace " << i;
+            ASSERT_TRUE(VectorCompare(tr.plane.normal, results[i].plane.normal)) << "trace " << i;
+            ASSERT_TRUE(VectorCompare(tr.endpos, results[i].endpos)) << "trace " << i;
+        }
+    });
+}
+
+TEST_F(BrushKernelTest, DISABLED_TraceBenchmark)
+{
+    std::vector<TraceArgs> traces = GameTraces(30000);
+    const int rounds = 10;
+    auto time = [&](const char* name) {
+        float fractions = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (const TraceArgs& t : traces) {
+                trace_t tr;
+                CM_BoxTrace(&tr, t.start, t.end, t.mins, t.maxs, CM_InlineModel(0), contentmask, skipmask, traceType_t::TT_AABB);
+                fractions += tr.fraction;
+            }
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        Log::Notice("%s: %.1f ns/trace (fractions %g)", name, double(ns) / rounds / traces.size(), fractions);
+    };
+
+    time("simd");
+    Without(PlaneGroups(), [&] { time("scalar"); });
+}
+
+class FacetTreeTest : public TraceTest
+{
+protected:
+    struct TraceArgs {
+        vec3_t start, end, mins, maxs;
+    };
+
+    // Box, point and position tests around a surface
+    static void AddSurfaceTraces(std::vector<TraceArgs>& traces, const cSurfaceCollide_t* sc, int count, std::mt19937& rng)
+    {
+        auto uniform = [&](float min, float max) {
+            return std::uniform_real_distribution<float>(min, max)(rng);
+        };
+        for (int n = 0; n < count; n++) {
+            TraceArgs t;
+            for (int axis = 0; axis < 3; axis++) {
+                t.start[axis] = uniform(sc->bounds[0][axis] - 32, sc->bounds[1][axis] + 32);
+                t.end[axis] = n % 4 == 3 ? t.start[axis] : t.start[axis] + uniform(-48, 48);
+            }
+            float size = n % 2 ? 0.0f : uniform(1, 24);
+            VectorSet(t.mins, -size, -size, -size);
+            VectorSet(t.maxs, size, size, size * 1.5f);
+            traces.push_back(t);
+        }
+    }
+
+    // Without trees, every facet is tested
+    static std::vector<int*> FacetTrees()
+    {
+        std::vector<int*> numNodes;
+        for (int i = 0; i < cm.numSurfaces; i++) {
+            if (cm.surfaces[i] && cm.surfaces[i]->sc) {
+                numNodes.push_back(&cm.surfaces[i]->sc->numNodes);
+            }
+        }
+        return numNodes;
+    }
+
+    // Checks that the trees don't change any result, and returns the
+    // number of facets tested per trace with and without them
+    static std::pair<double, double> CompareWithAllFacets(const std::vector<TraceArgs>& traces)
+    {
+        auto run = [&](std::vector<trace_t>& results) {
+            c_facets = 0;
+            for (const TraceArgs& t : traces) {
+                for (traceType_t type : {traceType_t::TT_AABB, traceType_t::TT_CAPSULE}) {
+                    trace_t tr;
+                    CM_BoxTrace(&tr, t.start, t.end, t.mins, t.maxs, CM_InlineModel(0), contentmask, skipmask, type);
+                    results.push_back(tr);
+                }
+            }
+            return double(c_facets) / results.size();
+        };
+
+        std::vector<trace_t> results, allFacetResults;
+        double facets = run(results);
+        double allFacets = 0;
+        Without(FacetTrees(), [&] { allFacets = run(allFacetResults); });
+
+        for (size_t i = 0; i < results.size(); i++) {
+            const trace_t& tr = results[i];
+            const trace_t& expected = allFacetResults[i];
+            EXPECT_EQ(tr.fraction, expected.fraction) << "trace " << i;
+            EXPECT_EQ(tr.startsolid, expected.startsolid) << "trace " << i;
+            EXPECT_EQ(tr.allsolid, expected.allsolid) << "trace " << i;
+            EXPECT_EQ(tr.contents, expected.contents) << "trace " << i;
+            EXPECT_EQ(tr.plane.dist, expected.plane.dist) << "trace " << i;
+            EXPECT_TRUE(VectorCompare(tr.plane.normal, expected.plane.normal)) << "trace " << i;
+        }
+        return {facets, allFacets};
+    }
+};
+
+TEST_F(FacetTreeTest, SameResultsAsAllFacets)
+{
+    std::mt19937 rng(17);
+    std::vector<TraceArgs> traces;
+    for (int i = 0; i < cm.numSurfaces; i++) {
+        if (cm.surfaces[i] && cm.surfaces[i]->sc) {
+            AddSurfaceTraces(traces, cm.surfaces[i]->sc, 200, rng);
+        }
+    }
+    ASSERT_FALSE(traces.empty());
+
+    auto facets = CompareWithAllFacets(traces);
+    EXPECT_LE(facets.first, facets.second);
+}
+
+// The test map only has small patches, so this swaps one of them for a
+// hilly terrain patch of a few thousand facets
+TEST_F(FacetTreeTest, TerrainPatch)
+{
+    cSurface_t* patch = nullptr;
+    for (int i = 0; i < cm.numSurfaces && !patch; i++) {
+        if (cm.surfaces[i] && cm.surfaces[i]->type == mapSurfaceType_t::MST_PATCH && cm.surfaces[i]->sc) {
+            patch = cm.surfaces[i];
+        }
+    }
+    ASSERT_NE(nullptr, patch);
+
+    const int size = 33;
+    vec3_t center;
+    VectorAdd(patch->sc->bounds[0], patch->sc->bounds[1], center);
+    VectorScale(center, 0.5f, center);
+    std::vector<std::array<float, 3>> points(size * size);
+    for (int row = 0; row < size; row++) {
+        for (int column = 0; column < size; column++) {
+            std::array<float, 3>& p = points[row * size + column];
+            p[0] = center[0] + (column - size / 2) * 32.0f;
+            p[1] = center[1] + (row - size / 2) * 32.0f;
+            p[2] = center[2] + 48.0f * sinf(column * 0.7f) * cosf(row * 0.5f);
+        }
+    }
+
+    // Put the map's patch back even when an assertion returns early
+    struct RestorePatch {
+        cSurface_t* patch;
+        cSurfaceCollide_t* original;
+        ~RestorePatch() { patch->sc = original; }
+    } restore{patch, patch->sc};
+    patch->sc = CM_GeneratePatchCollide(size, size, reinterpret_cast<const vec3_t*>(points.data()));
+    ASSERT_GT(patch->sc->numNodes, 0);
+
+    std::mt19937 rng(17);
+    std::vector<TraceArgs> traces;
+    AddSurfaceTraces(traces, restore.original, 2000, rng);
+    auto facets = CompareWithAllFacets(traces);
+    EXPECT_LT(facets.first, facets.second);
+}
+
+class PointContentsTest : public TraceTest
+{
+protected:
+    // Random points in and a little around the world, some of them on exact
+    // grid and integer coordinates where boundaries are likely to be
+    static std::vector<std::array<float, 3>> RandomPoints(int count)
+    {
+        vec3_t mins, maxs;
+        CM_ModelBounds(CM_InlineModel(0), mins, maxs);
+        std::mt19937 rng(14);
+        std::vector<std::array<float, 3>> points(count);
+        for (int i = 0; i < count; i++) {
+            for (int j = 0; j < 3; j++) {
+                float x = std::uniform_real_distribution<float>(mins[j] - 64, maxs[j] + 64)(rng);
+                switch (i % 3) {
+                case 1:
+                    x = roundf(x);
+                    break;
+                case 2:
+                    x = roundf(x / 64) * 64;
+                    break;
+                }
+                points[i][j] = x;
+            }
+        }
+        return points;
+    }
+
+    // Without the grid, points go down the tree
+    static std::vector<cPointGrid_t*> Grid()
+    {
+        return {&cm.pointGrid};
+    }
+};
+
+TEST_F(PointContentsTest, GridMatchesTree)
+{
+    ASSERT_NE(nullptr, cm.pointGrid.cells);
+
+    std::vector<std::array<float, 3>> points = RandomPoints(200000);
+    std::vector<int> contents, leafs;
+    for (const auto& p : points) {
+        contents.push_back(CM_PointContents(p.data(), 0));
+        leafs.push_back(CM_PointLeafnum(p.data()));
+    }
+
+    Without(Grid(), [&] {
+        for (size_t i = 0; i < points.size(); i++) {
+            const float* p = points[i].data();
+            ASSERT_EQ(CM_PointContents(p, 0), contents[i]) << p[0] << " " << p[1] << " " << p[2];
+            ASSERT_EQ(CM_PointLeafnum(p), leafs[i]) << p[0] << " " << p[1] << " " << p[2];
+        }
+    });
+}
+
+TEST_F(PointContentsTest, DISABLED_Benchmark)
+{
+    std::vector<std::array<float, 3>> points = RandomPoints(100000);
+    const int rounds = 20;
+    auto time = [&](const char* name) {
+        int contents = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (const auto& p : points) {
+                contents |= CM_PointContents(p.data(), 0);
+            }
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        Log::Notice("%s: %.1f ns/query (contents %x)", name, double(ns) / rounds / points.size(), contents);
+    };
+
+    time("grid");
+    Without(Grid(), [&] { time("tree"); });
+}
+
+constexpr const char cacheTestMap[] = "plat23_1.13.4";
+
+class CacheTest : public TraceTest
+{
+protected:
+    static std::string CachePath()
+    {
+        return Str::Format("cache/cm/%s.bin", cacheTestMap);
+    }
+
+    static void LoadMap(bool useCache)
+    {
+        Cvar::SetValue("cm_cache", useCache ? "1" : "0");
+        CM_LoadMap(cacheTestMap);
+        Cvar::SetValue("cm_cache", "1");
+    }
+
+    // Results of traces around each surface and of point queries, which
+    // depend on everything the cache holds
+    static std::vector<float> Queries()
+    {
+        std::mt19937 rng(18);
+        auto uniform = [&](float min, float max) {
+            return std::uniform_real_distribution<float>(min, max)(rng);
+        };
+        std::vector<float> results;
+        for (int i = 0; i < cm.numSurfaces; i++) {
+            const cSurface_t* surface = cm.surfaces[i];
+            if (!surface) {
+                continue;
+            }
+            for (int n = 0; n < 20; n++) {
+                vec3_t start, end;
+                for (int axis = 0; axis < 3; axis++) {
+                    start[axis] = uniform(surface->sc->bounds[0][axis] - 32, surface->sc->bounds[1][axis] + 32);
+                    end[axis] = start[axis] + uniform(-48, 48);
+                }
+                float size = n % 2 ? 0.0f : uniform(1, 24);
+                vec3_t mins{ -size, -size, -size };
+                vec3_t maxs{ size, size, size };
+                trace_t tr;
+                CM_BoxTrace(&tr, start, end, mins, maxs, CM_InlineModel(0), contentmask, skipmask, traceType_t::TT_AABB);
+                results.insert(results.end(), { tr.fraction, float(tr.allsolid), float(tr.contents), float(tr.surfaceFlags),
+                                                tr.plane.normal[0], tr.plane.normal[1], tr.plane.normal[2], tr.plane.dist });
+                results.push_back(float(CM_PointContents(start, 0)));
+            }
+        }
+        return results;
+    }
+};
+
+TEST_F(CacheTest, SameResultsAsGenerated)
+{
+    LoadMap(false);
+    EXPECT_FALSE(cm.cached);
+    std::vector<float> expected = Queries();
+    ASSERT_FALSE(expected.empty());
+
+    std::error_code err;
+    FS::HomePath::DeleteFile(CachePath(), err);
+    LoadMap(true);
+    EXPECT_FALSE(cm.cached);
+    ASSERT_TRUE(FS::HomePath::FileExists(CachePath()));
+
+    LoadMap(true);
+    EXPECT_TRUE(cm.cached);
+    EXPECT_NE(nullptr, cm.pointGrid.cells);
+    EXPECT_EQ(expected, Queries());
+}
+
+TEST_F(CacheTest, RebuildsCorruptCache)
+{
+    LoadMap(true);
+    std::vector<float> expected = Queries();
+
+    std::string data = FS::HomePath::OpenRead(CachePath()).ReadAll();
+    ASSERT_GT(data.size(), 1000u);
+    data[data.size() / 2] ^= 1;
+    FS::File file = FS::HomePath::OpenWrite(CachePath());
+    file.Write(data.data(), data.size());
+    file.Close();
+
+    LoadMap(true);
+    EXPECT_FALSE(cm.cached);
+    EXPECT_EQ(expected, Queries());
+
+    LoadMap(true);
+    EXPECT_TRUE(cm.cached);
+    EXPECT_EQ(expected, Queries());
+}
+
+TEST_F(CacheTest, DISABLED_LoadBenchmark)
+{
+    const int rounds = 20;
+    for (bool useCache : {false, true}) {
+        LoadMap(useCache);
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            LoadMap(useCache);
+        }
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        Log::Notice("%s: %.2f ms/load", useCache ? "cached" : "generated", us / 1000.0 / rounds);
+    }
+}
+
 } // namespace
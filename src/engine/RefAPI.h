@@ -189,7 +189,7 @@ struct refexport_t {
 	void ( *SetAltShaderTokens ) ( const char* );
 
 	void ( *GetTextureSize )( int textureID, int* width, int* height );
-	void ( *Add2dPolysIndexed )( polyVert_t* polys, int numverts, int* indexes, int numindexes, int trans_x, int trans_y, qhandle_t shader );
+	void ( *Add2dPolysIndexed )( const polyVert_t* polys, int numverts, const int* indexes, int numindexes, int trans_x, int trans_y, qhandle_t shader );
 	qhandle_t( *GenerateTexture )( const byte* pic, int width, int height );
 	const char* ( *ShaderNameFromHandle )( qhandle_t shader );
 	void ( *SendBotDebugDrawCommands )( std::vector<char> commands );
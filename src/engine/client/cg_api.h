@@ -63,6 +63,23 @@ struct ipcSnapshot_t
 	OpaquePlayerState ps;
 };
 
+// The cgame creates a ring of SNAPSHOT_RING_SLOTS of these in shared memory,
+// the engine writes the snapshots requested by the cgame in it and the cgame
+// reads them in place. Snapshot n goes in slot n & ( SNAPSHOT_RING_SLOTS - 1 ).
+#define SNAPSHOT_RING_SLOTS 4
+
+struct sharedSnapshot_t
+{
+	int               messageNum; // the snapshot in this slot
+	int               snapFlags;
+	int               ping;
+	int               serverTime;
+	byte              areamask[ MAX_MAP_AREA_BYTES ];
+	OpaquePlayerState ps;
+	int               numEntities;
+	entityState_t     entities[ MAX_GENTITIES ];
+};
+
 struct cgClientState_t
 {
 	connstate_t connState;
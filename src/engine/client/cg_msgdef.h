@@ -227,6 +227,11 @@ enum cgameImport_t
   CG_LAN_RESETPINGS,
   CG_LAN_SERVERSTATUS,
   CG_LAN_RESETSERVERSTATUS,
+
+  // Added at the end so that the IDs of the calls above stay the same
+  // for older gamelogic
+  CG_LOCATESNAPSHOTRING,
+  CG_GETSHAREDSNAPSHOT,
 };
 
 // All Miscs
@@ -262,6 +267,13 @@ using GetSnapshotMsg = IPC::SyncMessage<
 	IPC::Message<IPC::Id<VM::QVM, CG_GETSNAPSHOT>, int>,
 	IPC::Reply<bool, ipcSnapshot_t>
 >;
+// The shared memory ring of sharedSnapshot_t, created by the cgame
+using LocateSnapshotRingMsg = IPC::Message<IPC::Id<VM::QVM, CG_LOCATESNAPSHOTRING>, IPC::SharedMemory>;
+// Writes a snapshot in the ring, only its server commands are serialized
+using GetSharedSnapshotMsg = IPC::SyncMessage<
+	IPC::Message<IPC::Id<VM::QVM, CG_GETSHAREDSNAPSHOT>, int>,
+	IPC::Reply<bool, std::vector<std::string>>
+>;
 using GetCurrentCmdNumberMsg = IPC::SyncMessage<
 	IPC::Message<IPC::Id<VM::QVM, CG_GETCURRENTCMDNUMBER>>,
 	IPC::Reply<int>
@@ -408,8 +420,8 @@ namespace Render {
 	using ScissorSetMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_SCISSOR_SET>, int, int, int, int>;
 	using ClearSceneMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_CLEARSCENE>>;
 	using AddRefEntityToSceneMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_ADDREFENTITYTOSCENE>, refEntity_t>;
-	using AddPolyToSceneMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_ADDPOLYTOSCENE>, int, std::vector<polyVert_t>>;
-	using AddPolysToSceneMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_ADDPOLYSTOSCENE>, int, std::vector<polyVert_t>, int, int>;
+	using AddPolyToSceneMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_ADDPOLYTOSCENE>, int, Util::ArrayView<polyVert_t>>;
+	using AddPolysToSceneMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_ADDPOLYSTOSCENE>, int, Util::ArrayView<polyVert_t>, int, int>;
 	using AddLightToSceneMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_ADDLIGHTTOSCENE>, std::array<float, 3>, float, float, float, float, float, int, int>;
 	using AddAdditiveLightToSceneMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_ADDADDITIVELIGHTTOSCENE>, std::array<float, 3>, float, float, float, float>;
 	using SetColorMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_SETCOLOR>, Color::Color>;
@@ -421,7 +433,7 @@ namespace Render {
 	using UnregisterVisTestMsg = IPC::Message<IPC::Id<VM::QVM, CG_UNREGISTERVISTEST>, int>;
 	using SetColorGradingMsg = IPC::Message<IPC::Id<VM::QVM, CG_SETCOLORGRADING>, int, int>;
 	using RenderSceneMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_RENDERSCENE>, refdef_t>;
-	using Add2dPolysIndexedMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_ADD2DPOLYSINDEXED>, std::vector<polyVert_t>, int, std::vector<int>, int, int, int, qhandle_t>;
+	using Add2dPolysIndexedMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_ADD2DPOLYSINDEXED>, Util::ArrayView<polyVert_t>, int, Util::ArrayView<int>, int, int, int, qhandle_t>;
 	using SetMatrixTransformMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_SETMATRIXTRANSFORM>, std::array<float, 16>>;
 	using ResetMatrixTransformMsg = IPC::Message<IPC::Id<VM::QVM, CG_R_RESETMATRIXTRANSFORM>>;
 }
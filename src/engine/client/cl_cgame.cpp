@@ -278,10 +278,12 @@ void CL_FillServerCommands(std::vector<std::string>& commands, int start, int en
 
 /*
 ====================
-CL_GetSnapshot
+CL_FindSnapshot
+
+Returns null if the snapshot is not available anymore
 ====================
 */
-bool CL_GetSnapshot( int snapshotNumber, ipcSnapshot_t *snapshot )
+static clSnapshot_t *CL_FindSnapshot( int snapshotNumber )
 {
 	clSnapshot_t *clSnap;
 
@@ -293,13 +295,30 @@ bool CL_GetSnapshot( int snapshotNumber, ipcSnapshot_t *snapshot )
 	// if the frame has fallen out of the circular buffer, we can't return it
 	if ( cl.snap.messageNum - snapshotNumber >= PACKET_BACKUP )
 	{
-		return false;
+		return nullptr;
 	}
 
 	// if the frame is not valid, we can't return it
 	clSnap = &cl.snapshots[ snapshotNumber & PACKET_MASK ];
 
 	if ( !clSnap->valid )
+	{
+		return nullptr;
+	}
+
+	return clSnap;
+}
+
+/*
+====================
+CL_GetSnapshot
+====================
+*/
+bool CL_GetSnapshot( int snapshotNumber, ipcSnapshot_t *snapshot )
+{
+	clSnapshot_t *clSnap = CL_FindSnapshot( snapshotNumber );
+
+	if ( !clSnap )
 	{
 		return false;
 	}
@@ -318,6 +337,44 @@ bool CL_GetSnapshot( int snapshotNumber, ipcSnapshot_t *snapshot )
 	return true;
 }
 
+/*
+====================
+CL_GetSharedSnapshot
+
+Like CL_GetSnapshot, but writes the snapshot in its slot of the ring
+shared with the cgame
+====================
+*/
+bool CL_GetSharedSnapshot( int snapshotNumber, sharedSnapshot_t *ring, std::vector<std::string> &serverCommands )
+{
+	clSnapshot_t *clSnap = CL_FindSnapshot( snapshotNumber );
+
+	if ( !clSnap )
+	{
+		return false;
+	}
+
+	if ( clSnap->entities.size() > MAX_GENTITIES )
+	{
+		Sys::Drop( "CL_GetSharedSnapshot: too many entities" );
+	}
+
+	sharedSnapshot_t *shared = &ring[ snapshotNumber & ( SNAPSHOT_RING_SLOTS - 1 ) ];
+	shared->messageNum = snapshotNumber;
+	shared->snapFlags = clSnap->snapFlags;
+	shared->ping = clSnap->ping;
+	shared->serverTime = clSnap->serverTime;
+	memcpy( shared->areamask, clSnap->areamask, sizeof( shared->areamask ) );
+	shared->ps = clSnap->ps;
+	shared->numEntities = clSnap->entities.size();
+	std::copy( clSnap->entities.begin(), clSnap->entities.end(), shared->entities );
+
+	CL_FillServerCommands(serverCommands, clc.lastExecutedServerCommand + 1, clSnap->serverCommandNum);
+	clc.lastExecutedServerCommand = clSnap->serverCommandNum;
+
+	return true;
+}
+
 /*
 ====================
 CL_ShutdownCGame
@@ -958,6 +1015,7 @@ void  CL_OnTeamChanged( int newTeam )
 
 CGameVM::CGameVM(): VM::VMBase("cgame", Cvar::CHEAT), services(nullptr), cmdBuffer("client")
 {
+	cmdBuffer.SetSyscallStats(&syscallStats);
 }
 
 void CGameVM::Start()
@@ -998,11 +1056,14 @@ void CGameVM::CGameShutdown()
 	}
 	this->Free();
 	services = nullptr;
+	cmdBuffer.Close();
+	snapshotRing.Close();
 }
 
 void CGameVM::CGameDrawActiveFrame(int serverTime,  bool demoPlayback)
 {
 	this->SendMsg<CGameDrawActiveFrameMsg>(serverTime, demoPlayback);
+	this->CountIPCFrame();
 }
 
 bool CGameVM::CGameKeyDownEvent(Keyboard::Key key, bool repeat)
@@ -1092,6 +1153,11 @@ void CGameVM::Syscall(uint32_t id, Util::Reader reader, IPC::Channel& channel)
 	}
 }
 
+int CGameVM::ConsumeCommandBuffer()
+{
+	return this->cmdBuffer.Consume();
+}
+
 void CGameVM::QVMSyscall(int syscallNum, Util::Reader& reader, IPC::Channel& channel)
 {
 	switch (syscallNum) {
@@ -1170,6 +1236,24 @@ void CGameVM::QVMSyscall(int syscallNum, Util::Reader& reader, IPC::Channel& cha
 			});
 			break;
 
+		case CG_LOCATESNAPSHOTRING:
+			IPC::HandleMsg<LocateSnapshotRingMsg>(channel, std::move(reader), [this] (IPC::SharedMemory shm) {
+				if (shm.GetSize() < sizeof(sharedSnapshot_t) * SNAPSHOT_RING_SLOTS) {
+					Sys::Drop("CG_LOCATESNAPSHOTRING: Shared memory region too small");
+				}
+				snapshotRing = std::move(shm);
+			});
+			break;
+
+		case CG_GETSHAREDSNAPSHOT:
+			IPC::HandleMsg<GetSharedSnapshotMsg>(channel, std::move(reader), [this] (int number, bool& res, std::vector<std::string>& commands) {
+				if (!snapshotRing) {
+					Sys::Drop("CG_GETSHAREDSNAPSHOT: the snapshot ring was not located");
+				}
+				res = CL_GetSharedSnapshot(number, static_cast<sharedSnapshot_t*>(snapshotRing.GetBase()), commands);
+			});
+			break;
+
 		case CG_GETCURRENTCMDNUMBER:
 			IPC::HandleMsg<GetCurrentCmdNumberMsg>(channel, std::move(reader), [this] (int& number) {
 				number = CL_GetCurrentCmdNumber();
@@ -1540,22 +1624,6 @@ void CGameVM::QVMSyscall(int syscallNum, Util::Reader& reader, IPC::Channel& cha
 	}
 }
 
-//TODO move somewhere else
-template<typename Func, typename Id, typename... MsgArgs> void HandleMsg(IPC::Message<Id, MsgArgs...>, Util::Reader reader, Func&& func)
-{
-    using Message = IPC::Message<Id, MsgArgs...>;
-
-    typename IPC::detail::MapTuple<typename Message::Inputs>::type inputs;
-    reader.FillTuple<0>(Util::TypeListFromTuple<typename Message::Inputs>(), inputs);
-
-    Util::apply(std::forward<Func>(func), std::move(inputs));
-}
-
-template<typename Msg, typename Func> void HandleMsg(Util::Reader reader, Func&& func)
-{
-    HandleMsg(Msg(), std::move(reader), std::forward<Func>(func));
-}
-
 CGameVM::CmdBuffer::CmdBuffer(std::string name): IPC::CommandBufferHost(name) {
 }
 
@@ -1677,13 +1745,13 @@ void CGameVM::CmdBuffer::HandleCommandBufferSyscall(int major, int minor, Util::
                 break;
 
             case CG_R_ADDPOLYTOSCENE:
-                HandleMsg<Render::AddPolyToSceneMsg>(std::move(reader), [this] (int shader, const std::vector<polyVert_t>& verts) {
+                HandleMsg<Render::AddPolyToSceneMsg>(std::move(reader), [this] (int shader, Util::ArrayView<polyVert_t> verts) {
                     re.AddPolyToScene(shader, verts.size(), verts.data());
                 });
                 break;
 
             case CG_R_ADDPOLYSTOSCENE:
-                HandleMsg<Render::AddPolysToSceneMsg>(std::move(reader), [this] (int shader, const std::vector<polyVert_t>& verts, int numVerts, int numPolys) {
+                HandleMsg<Render::AddPolysToSceneMsg>(std::move(reader), [this] (int shader, Util::ArrayView<polyVert_t> verts, int numVerts, int numPolys) {
                     re.AddPolysToScene(shader, numVerts, verts.data(), numPolys);
                 });
                 break;
@@ -1755,7 +1823,7 @@ void CGameVM::CmdBuffer::HandleCommandBufferSyscall(int major, int minor, Util::
 				break;
 
 			case CG_R_ADD2DPOLYSINDEXED:
-				HandleMsg<Render::Add2dPolysIndexedMsg>(std::move(reader), [this] (std::vector<polyVert_t> polys, int numPolys, std::vector<int> indicies, int numIndicies, int trans_x, int trans_y, qhandle_t shader) {
+				HandleMsg<Render::Add2dPolysIndexedMsg>(std::move(reader), [this] (Util::ArrayView<polyVert_t> polys, int numPolys, Util::ArrayView<int> indicies, int numIndicies, int trans_x, int trans_y, qhandle_t shader) {
 					re.Add2dPolysIndexed(polys.data(), numPolys, indicies.data(), numIndicies, trans_x, trans_y, shader);
 				});
                 break;
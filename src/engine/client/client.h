@@ -356,6 +356,7 @@ public:
 
 private:
 	virtual void Syscall(uint32_t id, Util::Reader reader, IPC::Channel& channel) override final;
+	virtual int ConsumeCommandBuffer() override final;
 	void QVMSyscall(int syscallNum, Util::Reader& reader, IPC::Channel& channel);
 
 	std::unique_ptr<VM::CommonVMServices> services;
@@ -367,6 +368,9 @@ private:
     };
 
     CmdBuffer cmdBuffer;
+
+    // Where the snapshots are written for the cgame, see sharedSnapshot_t
+    IPC::SharedMemory snapshotRing;
 };
 
 extern CGameVM                cgvm;
@@ -53,10 +53,11 @@ class TestApplication : public ApplicationT
     static void RecursiveDelete(const std::string& dir)
     {
         std::vector<std::string> files;
-        // TODO: does this recurse in the right order?
         for (const std::string& s : FS::RawPath::ListFilesRecursive(dir)) {
             files.push_back(FS::Path::Build(dir, s));
         }
+        // Directories are listed before their contents
+        std::reverse(files.begin(), files.end());
         files.push_back(dir + '/');
         for (const std::string& s : files) {
             if (s.back() == '/') {
@@ -100,7 +101,8 @@ public:
     void Frame() override
     {
         Log::Notice("Running unit tests. You can set Googletest flags via the cvar `testing.flags`."
-                    " Try `-set testing.flags --help`.");
+                    " Try `-set testing.flags --help`. Benchmarks are disabled tests, run them with"
+                    " `-set testing.flags \"--gtest_also_run_disabled_tests --gtest_filter=*Benchmark*\"`.");
         std::string flagBuf("programname " + gtestFlags.Get() + " ");
         std::vector<char*> argv;
         for (size_t start = 0; start != flagBuf.npos; ) {
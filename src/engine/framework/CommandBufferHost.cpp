@@ -29,10 +29,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "CommandBufferHost.h"
+#include "Profiler.h"
 
 namespace IPC {
 
-    CommandBufferHost::CommandBufferHost(std::string name): name(name), logs(name + ".commandBufferHost") {
+    CommandBufferHost::CommandBufferHost(std::string name): name(name), zoneName(name + " buffered syscall"), logs(name + ".commandBufferHost") {
     }
 
     void CommandBufferHost::Syscall(int index, Util::Reader& reader, IPC::Channel& channel) {
@@ -53,6 +54,10 @@ namespace IPC {
         }
     }
 
+    void CommandBufferHost::SetSyscallStats(VM::SyscallStats* stats) {
+        syscallStats = stats;
+    }
+
     void CommandBufferHost::Init(IPC::SharedMemory mem) {
         shm = std::move(mem);
         buffer.Init(shm.GetBase(), shm.GetSize());
@@ -60,10 +65,22 @@ namespace IPC {
         logs.Debug("Received buffers of size %i for %s", buffer.GetSize(), name);
     }
 
-    void CommandBufferHost::Consume() {
+    void CommandBufferHost::Close() {
+        shm.Close();
+    }
+
+    int CommandBufferHost::Consume() {
+        if (!shm) {
+            return 0;
+        }
+
         buffer.LoadWriterData();
+        if (buffer.GetMaxReadLength() == 0) {
+            return 0;
+        }
         logs.Debug("Consuming up to %i data from buffer for %s", buffer.GetMaxReadLength(), name);
         bool consuming = true;
+        int consumed = 0;
         //TODO set fixed bound too
 
         while(consuming) {
@@ -72,12 +89,21 @@ namespace IPC {
 
             if (consuming) {
                 uint32_t id = reader.Read<uint32_t>();
+                Profiler::Zone zone(zoneName.c_str(), id);
                 int major = id >> 16;
                 int minor = id & 0xffff;
+                size_t bytesIn = reader.GetData().size();
+                auto start = Sys::SteadyClock::now();
                 this->HandleCommandBufferSyscall(major, minor, reader);
+                if (syscallStats) {
+                    syscallStats->Add(id, bytesIn, 0, Sys::SteadyClock::now() - start);
+                }
+                consumed++;
             }
             //TODO add more logic to stop consuming (e.g. when the socket is ready)
         }
+
+        return consumed;
     }
 
     bool CommandBufferHost::ConsumeOne(Util::Reader& reader) {
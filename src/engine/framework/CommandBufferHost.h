@@ -33,6 +33,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "common/IPC/CommandBuffer.h"
 #include "common/Serialize.h"
+#include "framework/SyscallStats.h"
 
 namespace IPC {
 
@@ -44,8 +45,35 @@ namespace IPC {
             void Syscall(int index, Util::Reader& reader, IPC::Channel& channel);
             void Close();
 
+            // Handles everything the VM wrote in the buffer so far, returns the
+            // number of messages handled. The VM doesn't need to flush before a
+            // message sent on the socket as the VM calls this before handling it.
+            int Consume();
+
+            // Where the messages handled are counted, if anywhere
+            void SetSyscallStats(VM::SyscallStats* stats);
+
+        protected:
+            // Same as IPC::HandleMsg for messages read from the command buffer
+            template<typename Msg, typename Func> static void HandleMsg(Util::Reader reader, Func&& func)
+            {
+                HandleMsg(Msg(), std::move(reader), std::forward<Func>(func));
+            }
+
         private:
+            template<typename Func, typename Id, typename... MsgArgs> static void HandleMsg(IPC::Message<Id, MsgArgs...>, Util::Reader reader, Func&& func)
+            {
+                using Message = IPC::Message<Id, MsgArgs...>;
+
+                typename IPC::detail::MapTuple<typename Message::Inputs>::type inputs;
+                reader.FillTuple<0>(Util::TypeListFromTuple<typename Message::Inputs>(), inputs);
+
+                Util::apply(std::forward<Func>(func), std::move(inputs));
+            }
+
             std::string name;
+            std::string zoneName; // of the messages in the profiler
+            VM::SyscallStats* syscallStats = nullptr;
             Log::Logger logs;
             IPC::CommandBuffer buffer;
             IPC::SharedMemory shm;
@@ -54,7 +82,6 @@ namespace IPC {
 
             void Init(IPC::SharedMemory mem);
 
-            void Consume();
             bool ConsumeOne(Util::Reader& reader);
     };
 }
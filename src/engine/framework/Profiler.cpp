@@ -0,0 +1,271 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include "Profiler.h"
+#include "common/FileSystem.h"
+#include "framework/CommandSystem.h"
+
+namespace Profiler {
+
+namespace {
+
+struct Event {
+	const char* name;
+	uint32_t id;
+	int64_t start;
+	int64_t end;
+};
+
+// Written by its thread only. The ring is allocated by the first zone the
+// thread records, so that threads which are only named cost no memory. The
+// writer publishes each event by bumping written, so a reader knows which ones
+// it may have seen half overwritten.
+struct ThreadBuffer {
+	int thread;
+	std::string name;
+	std::atomic<Event*> ring{nullptr};
+	std::atomic<uint64_t> written{0};
+	std::atomic<bool> exited{false};
+
+	ThreadBuffer() = default;
+	ThreadBuffer(const ThreadBuffer&) = delete;
+	ThreadBuffer& operator=(const ThreadBuffer&) = delete;
+
+	~ThreadBuffer()
+	{
+		delete[] ring.load();
+	}
+};
+
+// Marks the buffer of a thread when the thread exits
+struct ThreadBufferRef {
+	std::shared_ptr<ThreadBuffer> buffer;
+
+	~ThreadBufferRef()
+	{
+		if (buffer) {
+			buffer->exited = true;
+		}
+	}
+};
+
+// Buffers stay alive after their thread exits, so its zones still get written,
+// until a trace including them is written or the profiler is started again
+std::mutex buffersMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+int numThreads = 0;
+thread_local ThreadBufferRef threadBuffer;
+
+std::atomic<int64_t> startTime(0);
+
+ThreadBuffer& GetThreadBuffer()
+{
+	if (!threadBuffer.buffer) {
+		auto buffer = std::make_shared<ThreadBuffer>();
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		buffer->thread = numThreads++;
+		buffers.push_back(buffer);
+		threadBuffer.buffer = std::move(buffer);
+	}
+	return *threadBuffer.buffer;
+}
+
+// Must be called with buffersMutex held
+void DropExitedThreads()
+{
+	buffers.erase(std::remove_if(buffers.begin(), buffers.end(), [](const std::shared_ptr<ThreadBuffer>& buffer) {
+		return buffer->exited.load();
+	}), buffers.end());
+}
+
+void AppendJSONString(std::string& out, Str::StringRef s)
+{
+	out += '"';
+	for (char c : s) {
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			out += Str::Format("\\u%04x", c);
+		} else {
+			out += c;
+		}
+	}
+	out += '"';
+}
+
+} // namespace
+
+namespace detail {
+
+std::atomic<bool> recording(false);
+
+int64_t Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Sys::SteadyClock::now().time_since_epoch()).count();
+}
+
+void Record(const char* name, uint32_t id, int64_t start, int64_t end)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	Event* ring = buffer.ring.load(std::memory_order_relaxed);
+	if (!ring) {
+		ring = new Event[RING_SIZE];
+		buffer.ring.store(ring, std::memory_order_release);
+	}
+	uint64_t index = buffer.written.load(std::memory_order_relaxed);
+	ring[index % RING_SIZE] = {name, id, start, end};
+	buffer.written.store(index + 1, std::memory_order_release);
+}
+
+} // namespace detail
+
+void Start()
+{
+	NameThread("main");
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		DropExitedThreads();
+	}
+	startTime = detail::Now();
+	detail::recording = true;
+}
+
+void Stop()
+{
+	detail::recording = false;
+}
+
+void NameThread(std::string name)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	buffer.name = std::move(name);
+}
+
+std::string TraceJSON()
+{
+	std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	bool first = true;
+	auto beginEvent = [&] {
+		out += first ? "\n" : ",\n";
+		first = false;
+	};
+
+	int64_t start = startTime;
+	std::vector<Event> events;
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	for (const auto& buffer : buffers) {
+		// Copy the ring, then drop what may have been overwritten meanwhile
+		uint64_t end = buffer->written.load(std::memory_order_acquire);
+		const Event* ring = buffer->ring.load(std::memory_order_acquire);
+		if (!ring) {
+			continue;
+		}
+		uint64_t begin = end > RING_SIZE ? end - RING_SIZE : 0;
+		events.clear();
+		for (uint64_t i = begin; i < end; i++) {
+			events.push_back(ring[i % RING_SIZE]);
+		}
+		uint64_t written = buffer->written.load(std::memory_order_acquire);
+		// the writer may also be halfway through the next slot
+		size_t overwritten = written + 1 > begin + RING_SIZE ? written + 1 - begin - RING_SIZE : 0;
+		if (overwritten >= events.size()) {
+			continue;
+		}
+
+		beginEvent();
+		out += Str::Format("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":", buffer->thread);
+		AppendJSONString(out, buffer->name.empty() ? Str::Format("thread %d", buffer->thread) : buffer->name);
+		out += "}}";
+
+		for (size_t i = overwritten; i < events.size(); i++) {
+			const Event& event = events[i];
+			if (event.start < start) {
+				continue;
+			}
+			beginEvent();
+			out += "{\"name\":";
+			if (event.id == NO_ID) {
+				AppendJSONString(out, event.name);
+			} else {
+				AppendJSONString(out, Str::Format("%s %d:%d", event.name, event.id >> 16, event.id & 0xffff));
+			}
+			out += Str::Format(",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				buffer->thread, (event.start - start) / 1000.0, (event.end - event.start) / 1000.0);
+		}
+	}
+	DropExitedThreads();
+	out += "\n]}\n";
+	return out;
+}
+
+class ProfileCmd : public Cmd::StaticCmd {
+public:
+	ProfileCmd() : StaticCmd("profile", Cmd::BASE, "record where the engine spends its time") {}
+
+	void Run(const Cmd::Args& args) const override
+	{
+		std::string action = args.Argc() > 1 ? args.Argv(1) : "";
+		if (action == "start" && args.Argc() == 2) {
+			Start();
+			Print("Profiling, the last %d zones of each thread are kept", RING_SIZE);
+		} else if (action == "stop" && args.Argc() == 2) {
+			Stop();
+		} else if (action == "dump" && args.Argc() <= 3) {
+			std::string path = args.Argc() == 3 ? args.Argv(2) : "profile.json";
+			std::string json = TraceJSON();
+			try {
+				FS::File file = FS::HomePath::OpenWrite(path);
+				file.Write(json.data(), json.size());
+				file.Close();
+			} catch (std::system_error& err) {
+				Print("Could not write %s: %s", path, err.what());
+				return;
+			}
+			Print("Wrote the profile to %s, open it with chrome://tracing or ui.perfetto.dev", path);
+		} else {
+			PrintUsage(args, "start | stop | dump [file]");
+		}
+	}
+
+	Cmd::CompletionResult Complete(int argNum, const Cmd::Args& args, Str::StringRef prefix) const override
+	{
+		if (argNum == 1) {
+			return Cmd::FilterCompletion(prefix, {{"start", ""}, {"stop", ""}, {"dump", ""}});
+		} else if (argNum == 2 && args.Argv(1) == "dump") {
+			return FS::HomePath::CompleteFilename(prefix, "", ".json", true, false);
+		}
+		return {};
+	}
+};
+static ProfileCmd profileCmdRegistration;
+
+} // namespace Profiler
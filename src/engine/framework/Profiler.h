@@ -0,0 +1,106 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#ifndef FRAMEWORK_PROFILER_H_
+#define FRAMEWORK_PROFILER_H_
+
+#include "common/Common.h"
+
+namespace Profiler {
+
+/*
+ * Records when the engine enters and leaves instrumented blocks, so that a
+ * frame can be looked at in a trace viewer (chrome://tracing, Perfetto).
+ *
+ * Each thread writes the zones it leaves into a ring buffer of its own without
+ * taking any lock, so only about the last RING_SIZE zones of every thread are
+ * kept.
+ * While the profiler is stopped, a zone costs a relaxed atomic load.
+ *
+ * The "profile" command starts and stops the recording and writes the zones
+ * in the Chrome trace event format.
+ */
+
+// Zones kept per thread
+static const size_t RING_SIZE = 1 << 16;
+
+// For zones that don't belong to a syscall
+static const uint32_t NO_ID = 0xffffffff;
+
+namespace detail {
+	extern std::atomic<bool> recording;
+	int64_t Now();
+	void Record(const char* name, uint32_t id, int64_t start, int64_t end);
+}
+
+inline bool IsRecording()
+{
+	return detail::recording.load(std::memory_order_relaxed);
+}
+
+// Discards what was recorded so far and records until Stop
+void Start();
+void Stop();
+
+// Shown in the trace instead of a number
+void NameThread(std::string name);
+
+// The zones recorded since Start, as Chrome trace event JSON
+std::string TraceJSON();
+
+/*
+ * Records the time between its construction and its destruction. The name must
+ * stay valid until the trace is written, it is usually a string literal. The id
+ * of a syscall is shown in the trace as major:minor after the name.
+ */
+class Zone {
+public:
+	explicit Zone(const char* name, uint32_t id = NO_ID)
+		: name(name), id(id), start(IsRecording() ? detail::Now() : -1) {}
+
+	~Zone()
+	{
+		if (start >= 0) {
+			detail::Record(name, id, start, detail::Now());
+		}
+	}
+
+	Zone(const Zone&) = delete;
+	Zone& operator=(const Zone&) = delete;
+
+private:
+	const char* name;
+	uint32_t id;
+	int64_t start;
+};
+
+} // namespace Profiler
+
+#endif // FRAMEWORK_PROFILER_H_
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "Profiler.h"
+
+namespace Profiler {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+static int Count(const std::string& json, const std::string& zone)
+{
+    std::string pattern = "\"name\":\"" + zone + "\"";
+    int count = 0;
+    for (size_t pos = json.find(pattern); pos != std::string::npos; pos = json.find(pattern, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+TEST(Profiler, RecordsZonesWhileStarted)
+{
+    { Zone zone("before"); }
+    Start();
+    {
+        Zone outer("outer");
+        Zone syscall("sgame syscall", 0x10002);
+    }
+    Stop();
+    { Zone zone("after"); }
+
+    std::string json = TraceJSON();
+    EXPECT_THAT(json, HasSubstr("\"traceEvents\":["));
+    EXPECT_EQ(1, Count(json, "outer"));
+    EXPECT_EQ(1, Count(json, "sgame syscall 1:2"));
+    EXPECT_EQ(0, Count(json, "before"));
+    EXPECT_EQ(0, Count(json, "after"));
+}
+
+TEST(Profiler, StartDiscardsOlderZones)
+{
+    Start();
+    { Zone zone("first"); }
+    Start();
+    { Zone zone("second"); }
+    Stop();
+
+    std::string json = TraceJSON();
+    EXPECT_EQ(0, Count(json, "first"));
+    EXPECT_EQ(1, Count(json, "second"));
+}
+
+TEST(Profiler, KeepsTheLastZonesOfEachThread)
+{
+    Start();
+    for (int i = 0; i < 10; i++) {
+        Zone zone("old");
+    }
+    for (size_t i = 0; i < RING_SIZE; i++) {
+        Zone zone("new");
+    }
+    std::thread helper([] {
+        NameThread("helper");
+        Zone zone("work");
+    });
+    helper.join();
+    Stop();
+
+    std::string json = TraceJSON();
+    EXPECT_EQ(0, Count(json, "old"));
+    // the oldest slot might have been in the middle of being overwritten
+    EXPECT_EQ(int(RING_SIZE) - 1, Count(json, "new"));
+    EXPECT_EQ(1, Count(json, "work"));
+    EXPECT_THAT(json, HasSubstr("\"args\":{\"name\":\"helper\"}"));
+    EXPECT_THAT(json, Not(HasSubstr(",\n]")));
+}
+
+} // namespace
+} // namespace Profiler
@@ -0,0 +1,97 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include "SyscallStats.h"
+
+namespace VM {
+
+uint64_t SyscallStats::Entry::PercentileNs(double fraction) const
+{
+	uint64_t wanted = std::max<uint64_t>(1, uint64_t(ceil(count * fraction)));
+	uint64_t seen = 0;
+	for (int bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+		seen += histogram[bucket];
+		if (seen >= wanted) {
+			return std::min(maxNs, (uint64_t(2) << bucket) - 1);
+		}
+	}
+	return maxNs;
+}
+
+void SyscallStats::Add(uint32_t id, size_t bytesIn, size_t bytesOut, std::chrono::nanoseconds time)
+{
+	Entry& entry = entries[id];
+	uint64_t ns = std::max<int64_t>(0, time.count());
+	int bucket = ns ? std::min(NUM_BUCKETS - 1, std::ilogb(double(ns))) : 0;
+
+	entry.id = id;
+	entry.count++;
+	entry.bytesIn += bytesIn;
+	entry.bytesOut += bytesOut;
+	entry.totalNs += ns;
+	entry.maxNs = std::max(entry.maxNs, ns);
+	entry.histogram[bucket]++;
+}
+
+void SyscallStats::Reset()
+{
+	entries.clear();
+}
+
+std::vector<SyscallStats::Entry> SyscallStats::Top(size_t n, Order order) const
+{
+	auto key = [order](const Entry& entry) {
+		switch (order) {
+		case Order::COUNT:
+			return entry.count;
+		case Order::BYTES_IN:
+			return entry.bytesIn;
+		case Order::BYTES_OUT:
+			return entry.bytesOut;
+		case Order::TIME:
+		default:
+			return entry.totalNs;
+		}
+	};
+
+	std::vector<Entry> top;
+	top.reserve(entries.size());
+	for (const auto& pair : entries) {
+		top.push_back(pair.second);
+	}
+	n = std::min(n, top.size());
+	std::partial_sort(top.begin(), top.begin() + n, top.end(), [&key](const Entry& a, const Entry& b) {
+		return key(a) != key(b) ? key(a) > key(b) : a.id < b.id;
+	});
+	top.resize(n);
+	return top;
+}
+
+} // namespace VM
@@ -0,0 +1,80 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#ifndef FRAMEWORK_SYSCALL_STATS_H_
+#define FRAMEWORK_SYSCALL_STATS_H_
+
+#include "common/Common.h"
+
+namespace VM {
+
+/*
+ * Counts the syscalls a VM makes, per message id, along with the bytes they
+ * carry and the time the engine takes to handle them. Handler times are also
+ * kept in a histogram with a bucket per power of two nanoseconds, to estimate
+ * percentiles.
+ */
+class SyscallStats {
+public:
+	static const int NUM_BUCKETS = 32;
+
+	struct Entry {
+		uint32_t id = 0;
+		uint64_t count = 0;
+		uint64_t bytesIn = 0; // the messages themselves
+		uint64_t bytesOut = 0; // what was sent back to the VM while handling them
+		uint64_t totalNs = 0;
+		uint64_t maxNs = 0;
+		std::array<uint32_t, NUM_BUCKETS> histogram{};
+
+		// Upper bound of the handler time of that fraction of the calls
+		uint64_t PercentileNs(double fraction) const;
+	};
+
+	enum class Order {
+		COUNT,
+		TIME,
+		BYTES_IN,
+		BYTES_OUT,
+	};
+
+	void Add(uint32_t id, size_t bytesIn, size_t bytesOut, std::chrono::nanoseconds time);
+	void Reset();
+
+	// The n first messages in that order, the largest first
+	std::vector<Entry> Top(size_t n, Order order) const;
+
+private:
+	std::unordered_map<uint32_t, Entry> entries;
+};
+
+} // namespace VM
+
+#endif // FRAMEWORK_SYSCALL_STATS_H_
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "SyscallStats.h"
+
+namespace VM {
+namespace {
+
+using std::chrono::nanoseconds;
+
+TEST(SyscallStats, TopSortsByTheGivenOrder)
+{
+    SyscallStats stats;
+    for (int i = 0; i < 10; i++) {
+        stats.Add(0x10001, 8, 0, nanoseconds(100));
+    }
+    stats.Add(0x20005, 4000, 12, nanoseconds(50000));
+    stats.Add(0x30002, 16, 900, nanoseconds(10));
+
+    std::vector<SyscallStats::Entry> top = stats.Top(2, SyscallStats::Order::TIME);
+    ASSERT_EQ(2u, top.size());
+    EXPECT_EQ(0x20005u, top[0].id);
+    EXPECT_EQ(0x10001u, top[1].id);
+    EXPECT_EQ(10u, top[1].count);
+    EXPECT_EQ(80u, top[1].bytesIn);
+    EXPECT_EQ(1000u, top[1].totalNs);
+
+    EXPECT_EQ(0x10001u, stats.Top(1, SyscallStats::Order::COUNT)[0].id);
+    EXPECT_EQ(0x20005u, stats.Top(1, SyscallStats::Order::BYTES_IN)[0].id);
+    EXPECT_EQ(0x30002u, stats.Top(1, SyscallStats::Order::BYTES_OUT)[0].id);
+    EXPECT_EQ(3u, stats.Top(10, SyscallStats::Order::TIME).size());
+
+    stats.Reset();
+    EXPECT_TRUE(stats.Top(10, SyscallStats::Order::TIME).empty());
+}
+
+TEST(SyscallStats, PercentilesBoundTheHandlerTimes)
+{
+    SyscallStats stats;
+    for (int i = 0; i < 98; i++) {
+        stats.Add(1, 0, 0, nanoseconds(300));
+    }
+    stats.Add(1, 0, 0, nanoseconds(5000));
+    stats.Add(1, 0, 0, nanoseconds(70000));
+
+    SyscallStats::Entry entry = stats.Top(1, SyscallStats::Order::TIME)[0];
+    EXPECT_THAT(entry.PercentileNs(0.5), ::testing::AllOf(::testing::Ge(300u), ::testing::Lt(600u)));
+    EXPECT_THAT(entry.PercentileNs(0.99), ::testing::AllOf(::testing::Ge(5000u), ::testing::Lt(10000u)));
+    EXPECT_EQ(70000u, entry.PercentileNs(1.0));
+    EXPECT_EQ(70000u, entry.maxNs);
+}
+
+} // namespace
+} // namespace VM
@@ -558,6 +558,102 @@ void VMBase::LogMessage(bool vmToEngine, bool start, int id)
 	}
 }
 
+void VMBase::CountIPCFrame()
+{
+	const IPC::ChannelStats& now = rootChannel.stats;
+	IPC::ChannelStats& last = ipcStats.lastFrame;
+	uint64_t roundTrips = (now.syncSent - last.syncSent) + (now.syncHandled - last.syncHandled);
+
+	ipcStats.frames++;
+	ipcStats.total.syncSent += now.syncSent - last.syncSent;
+	ipcStats.total.asyncSent += now.asyncSent - last.asyncSent;
+	ipcStats.total.syncHandled += now.syncHandled - last.syncHandled;
+	ipcStats.total.asyncHandled += now.asyncHandled - last.asyncHandled;
+	ipcStats.totalBuffered += ipcStats.buffered;
+	ipcStats.maxRoundTrips = std::max(ipcStats.maxRoundTrips, roundTrips);
+
+	ipcStats.buffered = 0;
+	last = now;
+}
+
+void VMBase::PrintIPCStats(const Cmd::Args& args)
+{
+	if (args.Argc() > 1) {
+		if (args.Argv(1) != "reset") {
+			Log::Notice("Usage: %s [reset]", args.Argv(0));
+			return;
+		}
+		IPC::ChannelStats lastFrame = rootChannel.stats;
+		ipcStats = {};
+		ipcStats.lastFrame = lastFrame;
+		return;
+	}
+
+	if (ipcStats.frames == 0) {
+		Log::Notice("No %s frame was counted.", name);
+		return;
+	}
+
+	const IPC::ChannelStats& total = ipcStats.total;
+	double frames = ipcStats.frames;
+	Log::Notice("%s IPC messages per frame over %llu frames:", name, static_cast<unsigned long long>(ipcStats.frames));
+	Log::Notice("  round trips: %.2f (%.2f engine->VM, %.2f VM->engine, max %llu)",
+		(total.syncSent + total.syncHandled) / frames, total.syncSent / frames, total.syncHandled / frames,
+		static_cast<unsigned long long>(ipcStats.maxRoundTrips));
+	Log::Notice("  one-way: %.2f engine->VM, %.2f VM->engine", total.asyncSent / frames, total.asyncHandled / frames);
+	Log::Notice("  from the command buffer: %.2f", ipcStats.totalBuffered / frames);
+}
+
+void VMBase::PrintSyscallStats(const Cmd::Args& args)
+{
+	static const std::pair<const char*, SyscallStats::Order> orders[] = {
+		{"time", SyscallStats::Order::TIME},
+		{"count", SyscallStats::Order::COUNT},
+		{"in", SyscallStats::Order::BYTES_IN},
+		{"out", SyscallStats::Order::BYTES_OUT},
+	};
+
+	if (args.Argc() == 2 && args.Argv(1) == "reset") {
+		syscallStats.Reset();
+		return;
+	}
+
+	int n = 10;
+	const std::pair<const char*, SyscallStats::Order>* order = &orders[0];
+	bool valid = args.Argc() <= 3;
+	if (valid && args.Argc() > 1) {
+		valid = Str::ParseInt(n, args.Argv(1)) && n > 0;
+	}
+	if (valid && args.Argc() > 2) {
+		order = std::find_if(std::begin(orders), std::end(orders), [&args](const std::pair<const char*, SyscallStats::Order>& o) {
+			return args.Argv(2) == o.first;
+		});
+		valid = order != std::end(orders);
+	}
+	if (!valid) {
+		Log::Notice("Usage: %s [<count> [time | count | in | out]] | reset", args.Argv(0));
+		return;
+	}
+
+	std::vector<SyscallStats::Entry> top = syscallStats.Top(n, order->second);
+	if (top.empty()) {
+		Log::Notice("No %s syscall was counted.", name);
+		return;
+	}
+
+	double frames = std::max<uint64_t>(1, ipcStats.frames);
+	Log::Notice("%s syscalls by %s, per frame over %llu frames:", name, order->first, static_cast<unsigned long long>(ipcStats.frames));
+	Log::Notice("  %-9s %9s %9s %9s %9s %9s %9s %9s", "id", "calls", "µs", "in", "out", "p50 ns", "p99 ns", "max ns");
+	for (const SyscallStats::Entry& entry : top) {
+		Log::Notice("  %-9s %9.2f %9.1f %9.0f %9.0f %9llu %9llu %9llu",
+			Str::Format("%d:%d", entry.id >> 16, entry.id & 0xffff),
+			entry.count / frames, entry.totalNs / 1000.0 / frames, entry.bytesIn / frames, entry.bytesOut / frames,
+			static_cast<unsigned long long>(entry.PercentileNs(0.5)),
+			static_cast<unsigned long long>(entry.PercentileNs(0.99)),
+			static_cast<unsigned long long>(entry.maxNs));
+	}
+}
+
 void VMBase::Free()
 {
 	if (syscallLogFile) {
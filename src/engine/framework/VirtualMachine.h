@@ -3,6 +3,8 @@
 #include <common/FileSystem.h>
 #include "common/Common.h"
 #include "common/IPC/Channel.h"
+#include "framework/Profiler.h"
+#include "framework/SyscallStats.h"
 
 namespace VM {
 
@@ -80,7 +82,12 @@ struct VMParams {
 class VMBase {
 public:
 	VMBase(std::string name_, int vmTypeCvarFlags)
-		: processHandle(Sys::INVALID_HANDLE), name(name_), type(TYPE_NACL), params(name_, vmTypeCvarFlags) {}
+		: processHandle(Sys::INVALID_HANDLE), name(name_), callZoneName(name_ + " call"), syscallZoneName(name_ + " syscall"),
+		  type(TYPE_NACL), params(name_, vmTypeCvarFlags),
+		  ipcStatsCmd("vm." + name_ + ".ipcStats", Cmd::BASE, "show the number of IPC messages per frame for " + name_,
+		              [this](const Cmd::Args& args) { PrintIPCStats(args); }),
+		  syscallStatsCmd("vm." + name_ + ".syscallStats", Cmd::BASE, "show the syscalls of " + name_ + " that cost the most",
+		              [this](const Cmd::Args& args) { PrintSyscallStats(args); }) {}
 
 	// Create the VM for the named module. This will automatically free any existing VM.
 	void Create();
@@ -101,12 +108,21 @@ public:
 	template<typename Msg, typename... Args> void SendMsg(Args&&... args)
 	{
 		// Marking lambda as mutable to work around a bug in gcc 4.6
+		Profiler::Zone zone(callZoneName.c_str(), Msg::id);
 		LogMessage(false, true, Msg::id);
 		IPC::SendMsg<Msg>(rootChannel, [this](uint32_t id, Util::Reader reader) mutable {
+			// What the VM buffered was written before this message
+			ipcStats.buffered += ConsumeCommandBuffer();
+			Profiler::Zone syscallZone(syscallZoneName.c_str(), id);
 			LogMessage(true, true, id);
+			size_t bytesIn = reader.GetData().size();
+			uint64_t bytesSent = rootChannel.stats.bytesSent;
+			auto start = Sys::SteadyClock::now();
 			Syscall(id, std::move(reader), rootChannel);
+			syscallStats.Add(id, bytesIn, rootChannel.stats.bytesSent - bytesSent, Sys::SteadyClock::now() - start);
 			LogMessage(true, false, id);
 		}, std::forward<Args>(args)...);
+		ipcStats.buffered += ConsumeCommandBuffer();
 		LogMessage(false, false, Msg::id);
 	}
 
@@ -125,6 +141,20 @@ protected:
 	// System call handler
 	virtual void Syscall(uint32_t id, Util::Reader reader, IPC::Channel& channel) = 0;
 
+	// Handles the messages the VM wrote in its command buffer, if it has one,
+	// returns how many there were.
+	virtual int ConsumeCommandBuffer()
+	{
+		return 0;
+	}
+
+	// Marks the end of a VM frame for vm.<name>.ipcStats
+	void CountIPCFrame();
+
+	// For vm.<name>.syscallStats, the time of a syscall includes the calls
+	// its handler makes back into the VM
+	SyscallStats syscallStats;
+
 private:
 	void FreeInProcessVM();
 
@@ -139,6 +169,10 @@ private:
 
 	std::string name;
 
+	// Names of the profiler zones of the messages sent to and received from the VM
+	std::string callZoneName;
+	std::string syscallZoneName;
+
 	vmType_t type;
 
 	VMParams params;
@@ -147,6 +181,22 @@ private:
 	FS::File syscallLogFile;
 
 	void LogMessage(bool vmToEngine, bool start, int id);
+
+	// Messages exchanged with the VM, totals over ipcStats.frames frames
+	struct IPCStats {
+		uint64_t frames = 0;
+		IPC::ChannelStats total;
+		uint64_t buffered = 0;
+		uint64_t totalBuffered = 0;
+		uint64_t maxRoundTrips = 0;
+		IPC::ChannelStats lastFrame; // the channel counters at the end of the last frame
+	};
+	IPCStats ipcStats;
+	Cmd::LambdaCmd ipcStatsCmd;
+	Cmd::LambdaCmd syscallStatsCmd;
+
+	void PrintIPCStats(const Cmd::Args& args);
+	void PrintSyscallStats(const Cmd::Args& args);
 };
 
 } // namespace VM
\ No newline at end of file
@@ -0,0 +1,171 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include "WorkerPool.h"
+#include "Profiler.h"
+
+namespace Sys {
+
+static Log::Logger workerLog("common.workerPool");
+
+WorkerPool::WorkerPool(std::string name)
+	: name(std::move(name)), nextJob(0)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+	Resize(0);
+}
+
+void WorkerPool::SetNumThreads(int numThreads)
+{
+	wantedThreads = std::max(0, numThreads);
+}
+
+int WorkerPool::GetNumThreads() const
+{
+	return wantedThreads;
+}
+
+void WorkerPool::Resize(int numThreads)
+{
+	if (numThreads == int(threads.size())) {
+		return;
+	}
+
+	if (!threads.empty()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			halt = true;
+		}
+		wake.notify_all();
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+		threads.clear();
+		halt = false;
+	}
+
+	if (numThreads > 0) {
+		workerLog.Verbose("Starting %d worker threads for %s", numThreads, name);
+	}
+
+	for (int i = 0; i < numThreads; i++) {
+		// Only the owning thread bumps the generation, so it can be read unlocked here
+		threads.emplace_back(&WorkerPool::WorkerMain, this, generation);
+	}
+}
+
+void WorkerPool::RunJobs()
+{
+	int i;
+	while ((i = nextJob.fetch_add(1, std::memory_order_relaxed)) < jobCount) {
+		try {
+			(*currentJob)(i);
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+	}
+}
+
+void WorkerPool::WorkerMain(uint64_t seenGeneration)
+{
+	Profiler::NameThread(name + " worker");
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return halt || generation != seenGeneration; });
+			if (halt) {
+				return;
+			}
+			seenGeneration = generation;
+		}
+
+		RunJobs();
+
+		bool last;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			last = --busyWorkers == 0;
+		}
+		if (last) {
+			done.notify_one();
+		}
+	}
+}
+
+void WorkerPool::ParallelFor(int count, const std::function<void(int)>& job)
+{
+	if (count <= 0) {
+		return;
+	}
+
+	// Not worth waking anyone up for a single job
+	if (wantedThreads == 0 || count == 1) {
+		for (int i = 0; i < count; i++) {
+			job(i);
+		}
+		return;
+	}
+
+	Resize(wantedThreads);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentJob = &job;
+		jobCount = count;
+		nextJob.store(0, std::memory_order_relaxed);
+		error = nullptr;
+		busyWorkers = threads.size();
+		generation++;
+	}
+	wake.notify_all();
+
+	RunJobs();
+
+	std::exception_ptr batchError;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return busyWorkers == 0; });
+		currentJob = nullptr;
+		std::swap(batchError, error);
+	}
+
+	if (batchError) {
+		std::rethrow_exception(batchError);
+	}
+}
+
+} // namespace Sys
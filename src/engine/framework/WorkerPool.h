@@ -0,0 +1,90 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#ifndef FRAMEWORK_WORKER_POOL_H_
+#define FRAMEWORK_WORKER_POOL_H_
+
+#include "common/Common.h"
+
+namespace Sys {
+
+/*
+ * A set of threads to which the main thread hands batches of independent jobs.
+ *
+ * The pool is idle between batches: ParallelFor wakes the workers, runs the
+ * batch on them and on the calling thread, and returns once every job is done.
+ * An exception thrown by a job (for example a Sys::DropErr) is rethrown on the
+ * calling thread after the batch has finished.
+ *
+ * Threads are created lazily the first time a batch needs them, so a pool
+ * that is sized to 0 costs nothing.
+ */
+class WorkerPool {
+public:
+	explicit WorkerPool(std::string name);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// Number of extra threads helping the calling thread. 0 runs every
+	// batch serially on the calling thread.
+	void SetNumThreads(int numThreads);
+	int GetNumThreads() const;
+
+	// Runs job(0) ... job(count - 1), in an unspecified order and possibly
+	// concurrently. Must not be called from inside a job.
+	void ParallelFor(int count, const std::function<void(int)>& job);
+
+private:
+	void Resize(int numThreads);
+	void WorkerMain(uint64_t seenGeneration);
+	void RunJobs();
+
+	std::string name;
+	int wantedThreads = 0;
+	std::vector<std::thread> threads;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	bool halt = false;
+	uint64_t generation = 0; // bumped for each batch, guarded by mutex
+	int busyWorkers = 0; // workers still inside the current batch, guarded by mutex
+
+	const std::function<void(int)>* currentJob = nullptr;
+	int jobCount = 0;
+	std::atomic<int> nextJob;
+	std::exception_ptr error; // first exception thrown by a job, guarded by mutex
+};
+
+} // namespace Sys
+
+#endif // FRAMEWORK_WORKER_POOL_H_
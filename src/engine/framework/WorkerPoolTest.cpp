@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "WorkerPool.h"
+
+namespace Sys {
+namespace {
+
+TEST(WorkerPool, RunsEveryJobOnce)
+{
+    WorkerPool pool("test");
+    for (int numThreads : {0, 1, 4}) {
+        pool.SetNumThreads(numThreads);
+        std::vector<std::atomic<int>> runs(1000);
+        pool.ParallelFor(runs.size(), [&runs](int i) {
+            runs[i]++;
+        });
+        for (const std::atomic<int>& count : runs) {
+            EXPECT_EQ(1, count.load());
+        }
+    }
+}
+
+TEST(WorkerPool, ReusedAcrossBatches)
+{
+    WorkerPool pool("test");
+    pool.SetNumThreads(3);
+    std::atomic<int> sum(0);
+    for (int batch = 0; batch < 100; batch++) {
+        pool.ParallelFor(10, [&sum](int i) {
+            sum += i;
+        });
+    }
+    EXPECT_EQ(100 * 45, sum.load());
+}
+
+TEST(WorkerPool, RethrowsOnCaller)
+{
+    WorkerPool pool("test");
+    pool.SetNumThreads(2);
+    std::atomic<int> runs(0);
+    EXPECT_THROW(pool.ParallelFor(50, [&runs](int i) {
+        runs++;
+        if (i == 17) {
+            throw std::runtime_error("job failed");
+        }
+    }), std::runtime_error);
+    // the rest of the batch still ran
+    EXPECT_EQ(50, runs.load());
+}
+
+} // namespace
+} // namespace Sys
@@ -166,7 +166,7 @@ void RE_GetTextureSize( int, int *width, int *height )
     *width = 1;
     *height = 1;
 }
-void RE_Add2dPolysIndexed( polyVert_t*, int, int*, int, int, int, qhandle_t ) { }
+void RE_Add2dPolysIndexed( const polyVert_t*, int, const int*, int, int, int, qhandle_t ) { }
 qhandle_t RE_GenerateTexture( const byte*, int, int )
 {
     return 1;
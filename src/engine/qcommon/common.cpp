@@ -47,6 +47,7 @@ Maryland 20850 USA.
 #include "framework/CommandSystem.h"
 #include "framework/CvarSystem.h"
 #include "framework/LogSystem.h"
+#include "framework/Profiler.h"
 #include "framework/System.h"
 #include "sys/sys_events.h"
 #include <common/FileSystem.h>
@@ -403,6 +404,7 @@ Com_EventLoop
 
 void Com_EventLoop()
 {
+	Profiler::Zone zone( "Com_EventLoop" );
 	netadr_t   evFrom;
 	byte       bufData[ MAX_MSGLEN ];
 	msg_t      buf;
@@ -783,6 +785,7 @@ static Cvar::Cvar<bool> showTraceStats("common.showTraceStats", "are physics tra
 
 void Com_Frame()
 {
+	Profiler::Zone zone( "Com_Frame" );
 	int             msec, minMsec;
 	static int      lastTime = 0;
 	//int             key;
@@ -887,29 +890,53 @@ void Com_Frame()
 
 	msec = com_frameTime - lastTime;
 
-	// For framerates up to 250fps, sleep until 1ms is remaining
-	// use extra margin of 2ms when looking for an higher framerate.
-	int margin = minMsec > 3 ? 1 : 2;
-
-	while ( msec < minMsec )
+	if ( Com_IsDedicatedServer() && !cvar_demo_timedemo.Get() )
 	{
-		// Never sleep more than 50ms.
-		// Never sleep when there is only “margin” left or less remaining.
-		int sleep = std::min( std::max( minMsec - msec - margin, 0 ), 50 );
+		// A dedicated server waits on its sockets until the very moment
+		// the next frame is due, handling packets as they arrive.
+		Sys::SteadyClock::time_point deadline = Sys::MillisecondsTimePoint( lastTime + minMsec );
 
-		if ( sleep )
+		while ( msec < minMsec )
 		{
-			// Give cycles back to the OS.
-			Sys::SleepFor( std::chrono::milliseconds( sleep ) );
+			NET_SleepUntil( std::min( deadline, Sys::SteadyClock::now() + std::chrono::milliseconds( 50 ) ) );
+
+			Com_EventLoop();
+
+			IN_Frame();
+
+			com_frameTime = Sys::Milliseconds();
+
+			msec = com_frameTime - lastTime;
 		}
 
-		Com_EventLoop();
+		SV_RecordFrameLateness( Sys::SteadyClock::now() - deadline );
+	}
+	else
+	{
+		// For framerates up to 250fps, sleep until 1ms is remaining
+		// use extra margin of 2ms when looking for an higher framerate.
+		int margin = minMsec > 3 ? 1 : 2;
+
+		while ( msec < minMsec )
+		{
+			// Never sleep more than 50ms.
+			// Never sleep when there is only “margin” left or less remaining.
+			int sleep = std::min( std::max( minMsec - msec - margin, 0 ), 50 );
+
+			if ( sleep )
+			{
+				// Give cycles back to the OS.
+				Sys::SleepFor( std::chrono::milliseconds( sleep ) );
+			}
+
+			Com_EventLoop();
 
-		IN_Frame();
+			IN_Frame();
 
-		com_frameTime = Sys::Milliseconds();
+			com_frameTime = Sys::Milliseconds();
 
-		msec = com_frameTime - lastTime;
+			msec = com_frameTime - lastTime;
+		}
 	}
 
 	IN_FrameEnd();
@@ -1023,15 +1050,13 @@ void Com_Frame()
 	//
 	if ( showTraceStats.Get() )
 	{
-		extern int c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces;
-		extern int c_pointcontents;
-
-		Log::Notice( "%4i traces  (%ib %ip %it) %4i points", c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces,
-		            c_pointcontents );
+		Log::Notice( "%4i traces  (%ib %ip %it %if) %4i points", c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces,
+		            c_facets, c_pointcontents );
 		c_traces = 0;
 		c_brush_traces = 0;
 		c_patch_traces = 0;
 		c_trisoup_traces = 0;
+		c_facets = 0;
 		c_pointcontents = 0;
 	}
 
@@ -39,7 +39,8 @@ Maryland 20850 USA.
 #include "qcommon/q_shared.h"
 #include "qcommon.h"
 
-static int bloc = 0;
+// thread local since the server may encode several client snapshots at once
+static thread_local int bloc = 0;
 
 //bani - optimized version
 //clears data along the way so we don't have to memset() it ahead of time
@@ -473,6 +474,121 @@ void Huff_offsetTransmit( huff_t *huff, int ch, byte *fout, int *offset )
 	*offset = bloc;
 }
 
+/*
+ * Huff_BuildTable, Huff_tableTransmit and Huff_tableReceive produce and read
+ * exactly the same bits as Huff_offsetTransmit and Huff_offsetReceive, as
+ * long as the tree is not updated after the table is built.
+ */
+
+static void BuildLookup_r( huffTable_t *table, const node_t *node, uint32_t code, int length )
+{
+	if ( !node || length > HUFF_LOOKUP_BITS )
+	{
+		// missing nodes and long codes are left to the tree walk
+		return;
+	}
+
+	if ( node->symbol != INTERNAL_NODE )
+	{
+		for ( int high = 0; high < 1 << ( HUFF_LOOKUP_BITS - length ); high++ )
+		{
+			int index = code | ( high << length );
+			table->lookupSymbol[ index ] = node->symbol;
+			table->lookupLength[ index ] = length;
+		}
+
+		return;
+	}
+
+	BuildLookup_r( table, node->left, code, length + 1 );
+	BuildLookup_r( table, node->right, code | ( 1 << length ), length + 1 );
+}
+
+void Huff_BuildTable( huffTable_t *table, huff_t *huff )
+{
+	ResetStruct( *table );
+	table->huff = huff;
+
+	for ( int ch = 0; ch <= HMAX; ch++ )
+	{
+		int      length = 0;
+		uint64_t code = 0;
+
+		// going up from the leaf, the bit sent first ends up in the lowest bit
+		for ( const node_t *node = huff->loc[ ch ]; node && node->parent; node = node->parent )
+		{
+			code = ( code << 1 ) | ( node->parent->right == node );
+			length++;
+		}
+
+		if ( length == 0 || length > 32 )
+		{
+			continue;
+		}
+
+		table->code[ ch ] = code;
+		table->length[ ch ] = length;
+	}
+
+	BuildLookup_r( table, huff->tree, 0, 0 );
+}
+
+void Huff_tableTransmit( const huffTable_t *table, int ch, byte *fout, int *offset )
+{
+	int length = table->length[ ch ];
+
+	if ( !length )
+	{
+		Huff_offsetTransmit( table->huff, ch, fout, offset );
+		return;
+	}
+
+	uint32_t code = table->code[ ch ];
+	int      pos = *offset;
+
+	// a byte at a time, clearing bytes as they are started like add_bit does
+	while ( length > 0 )
+	{
+		byte *out = fout + ( pos >> 3 );
+		int  shift = pos & 7;
+		int  n = std::min( 8 - shift, length );
+
+		if ( !shift )
+		{
+			*out = 0;
+		}
+
+		*out |= ( code & ( ( 1 << n ) - 1 ) ) << shift;
+		code >>= n;
+		length -= n;
+		pos += n;
+	}
+
+	*offset = pos;
+}
+
+void Huff_tableReceive( const huffTable_t *table, int *ch, byte *fin, int size, int *offset )
+{
+	int pos = *offset;
+
+	// the lookup reads 3 bytes, don't go past the end of the buffer for it
+	if ( ( pos >> 3 ) + 3 <= size )
+	{
+		const byte *in = fin + ( pos >> 3 );
+		int        bits = ( ( in[ 0 ] | in[ 1 ] << 8 | in[ 2 ] << 16 ) >> ( pos & 7 ) ) & ( ( 1 << HUFF_LOOKUP_BITS ) - 1 );
+		int        length = table->lookupLength[ bits ];
+
+		if ( length )
+		{
+			*ch = table->lookupSymbol[ bits ];
+			*offset = pos + length;
+			return;
+		}
+	}
+
+	Huff_offsetReceive( table->huff->tree, ch, fin, offset );
+}
+
 void Huff_Decompress( msg_t *mbuf, int offset )
 {
 	int    ch, cch, i, j, size;
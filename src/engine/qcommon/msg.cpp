@@ -37,6 +37,7 @@ Maryland 20850 USA.
 #include "qcommon.h"
 
 static huffman_t msgHuff;
+static huffTable_t msgHuffTable;
 static bool  msgInit = false;
 
 /*
@@ -135,10 +136,161 @@ bit functions
 =============================================================================
 */
 
+/*
+ * Writes to a non-OOB message go through a msgWriter_t, which gathers the
+ * raw bits and the huffman codes in a 64-bit accumulator and stores them to
+ * the message 32 bits at a time, instead of setting them one by one. Several
+ * writes can be batched in the same writer, but the message is only up to
+ * date once MSG_EndWriter has been called.
+ */
+struct msgWriter_t
+{
+	msg_t    *msg;
+	uint64_t acc; // pending bits, the first one in the lowest bit
+	int      accBits;
+	int      base; // bit offset of the first pending bit, a multiple of 8
+	int      cursize;
+	int      uncompsize;
+};
+
+static void MSG_BeginWriter( msgWriter_t *w, msg_t *msg )
+{
+	w->msg = msg;
+	w->base = msg->bit & ~7;
+	w->accBits = msg->bit & 7;
+	w->acc = w->accBits ? msg->data[ w->base >> 3 ] & ( ( 1 << w->accBits ) - 1 ) : 0;
+	w->cursize = msg->cursize;
+	w->uncompsize = 0;
+}
+
+static void MSG_EndWriter( msgWriter_t *w )
+{
+	msg_t *msg = w->msg;
+	byte  *out = msg->data + ( w->base >> 3 );
+
+	for ( int i = 0; i < w->accBits; i += 8 )
+	{
+		*out++ = w->acc >> i;
+	}
+
+	msg->bit = w->base + w->accBits;
+	msg->cursize = w->cursize;
+	msg->uncompsize += w->uncompsize;
+}
+
+static inline void MSG_WriterPut( msgWriter_t *w, uint32_t code, int length )
+{
+	w->acc |= uint64_t( code ) << w->accBits;
+	w->accBits += length;
+
+	if ( w->accBits >= 32 )
+	{
+		byte *out = w->msg->data + ( w->base >> 3 );
+
+		out[ 0 ] = w->acc;
+		out[ 1 ] = w->acc >> 8;
+		out[ 2 ] = w->acc >> 16;
+		out[ 3 ] = w->acc >> 24;
+		w->acc >>= 32;
+		w->accBits -= 32;
+		w->base += 32;
+	}
+}
+
+// negative bit values include signs
+static void MSG_WriterBits( msgWriter_t *w, int value, int bits )
+{
+	w->uncompsize += bits; // NERVE - SMF - net debugging
+
+	// this isn't an exact overflow check, but close enough
+	if ( w->msg->maxsize - w->cursize < 32 )
+	{
+		w->msg->overflowed = true;
+		return;
+	}
+
+	if ( bits == 0 || bits < -31 || bits > 32 )
+	{
+		Sys::Drop( "MSG_WriteBits: bad bits %i", bits );
+	}
+
+	if ( bits < 0 )
+	{
+		bits = -bits;
+	}
+
+	uint32_t v = value & ( 0xffffffff >> ( 32 - bits ) );
+	int      nbits = bits & 7;
+
+	if ( nbits )
+	{
+		MSG_WriterPut( w, v & ( ( 1 << nbits ) - 1 ), nbits );
+		v >>= nbits;
+	}
+
+	for ( int i = nbits; i < bits; i += 8 )
+	{
+		int ch = v & 0xff;
+
+		if ( msgHuffTable.length[ ch ] )
+		{
+			MSG_WriterPut( w, msgHuffTable.code[ ch ], msgHuffTable.length[ ch ] );
+		}
+		else
+		{
+			// too long for the accumulator, let the tree send it
+			int uncompsize = w->uncompsize;
+
+			w->uncompsize = 0;
+			MSG_EndWriter( w );
+			Huff_offsetTransmit( msgHuffTable.huff, ch, w->msg->data, &w->msg->bit );
+			MSG_BeginWriter( w, w->msg );
+			w->uncompsize = uncompsize;
+		}
+
+		v >>= 8;
+	}
+
+	w->cursize = ( ( w->base + w->accBits ) >> 3 ) + 1;
+}
+
+// the same as count MSG_WriterBits( w, 0, 1 )
+static void MSG_WriterZeros( msgWriter_t *w, int count )
+{
+	w->uncompsize += count; // NERVE - SMF - net debugging
+
+	if ( !count )
+	{
+		return;
+	}
+
+	if ( w->msg->maxsize - w->cursize < 32 )
+	{
+		w->msg->overflowed = true;
+		return;
+	}
+
+	for ( ; count > 32; count -= 32 )
+	{
+		MSG_WriterPut( w, 0, 32 );
+	}
+
+	MSG_WriterPut( w, 0, count );
+	w->cursize = ( ( w->base + w->accBits ) >> 3 ) + 1;
+}
+
 // negative bit values include signs
 void MSG_WriteBits( msg_t *msg, int value, int bits )
 {
-	int i;
+	if ( !msg->oob )
+	{
+		msgWriter_t w;
+
+		MSG_BeginWriter( &w, msg );
+		MSG_WriterBits( &w, value, bits );
+		MSG_EndWriter( &w );
+		return;
+	}
 
 	msg->uncompsize += bits; // NERVE - SMF - net debugging
 
@@ -159,65 +311,87 @@ void MSG_WriteBits( msg_t *msg, int value, int bits )
 		bits = -bits;
 	}
 
-	if ( msg->oob )
+	if ( bits == 8 )
 	{
-		if ( bits == 8 )
-		{
-			msg->data[ msg->cursize ] = value;
-			msg->cursize += 1;
-			msg->bit += 8;
-		}
-		else if ( bits == 16 )
-		{
-			unsigned short *sp = ( unsigned short * ) &msg->data[ msg->cursize ];
+		msg->data[ msg->cursize ] = value;
+		msg->cursize += 1;
+		msg->bit += 8;
+	}
+	else if ( bits == 16 )
+	{
+		unsigned short *sp = ( unsigned short * ) &msg->data[ msg->cursize ];
 
-			*sp = LittleShort( value );
-			msg->cursize += 2;
-			msg->bit += 16;
-		}
-		else if ( bits == 32 )
-		{
-			unsigned int *ip = ( unsigned int * ) &msg->data[ msg->cursize ];
+		*sp = LittleShort( value );
+		msg->cursize += 2;
+		msg->bit += 16;
+	}
+	else if ( bits == 32 )
+	{
+		unsigned int *ip = ( unsigned int * ) &msg->data[ msg->cursize ];
 
-			*ip = LittleLong( value );
-			msg->cursize += 4;
-			msg->bit += 8;
-		}
-		else
-		{
-			Sys::Drop( "can't read %d bits", bits );
-		}
+		*ip = LittleLong( value );
+		msg->cursize += 4;
+		msg->bit += 8;
 	}
 	else
 	{
-		value &= ( 0xffffffff >> ( 32 - bits ) );
+		Sys::Drop( "can't read %d bits", bits );
+	}
+}
 
-		if ( bits & 7 )
-		{
-			int nbits;
+/*
+============
+MSG_WriteBitstream
 
-			nbits = bits & 7;
+Appends bits that were written to another (non-OOB) message, starting at its
+first bit. The huffman tree is fixed, so encoded bits are the same wherever
+they are placed in a message and can be copied as they are.
+============
+*/
+void MSG_WriteBitstream( msg_t *msg, const byte *data, int bits, int uncompsize )
+{
+	if ( msg->oob )
+	{
+		Sys::Drop( "MSG_WriteBitstream: OOB message" );
+	}
 
-			for ( i = 0; i < nbits; i++ )
-			{
-				Huff_putBit( ( value & 1 ), msg->data, &msg->bit );
-				value = ( value >> 1 );
-			}
+	int bytes = ( bits + 7 ) >> 3;
 
-			bits = bits - nbits;
-		}
+	msg->uncompsize += uncompsize;
 
-		if ( bits )
+	if ( msg->maxsize - msg->cursize < bytes + 32 )
+	{
+		msg->overflowed = true;
+		return;
+	}
+
+	if ( !bits )
+	{
+		return;
+	}
+
+	byte *out = msg->data + ( msg->bit >> 3 );
+	int  shift = msg->bit & 7;
+
+	if ( !shift )
+	{
+		memcpy( out, data, bytes );
+	}
+	else
+	{
+		// keep the bits already written to the partial byte, the bits
+		// past the end of the source are zero like Huff_putBit leaves them
+		out[ 0 ] &= ( 1 << shift ) - 1;
+
+		for ( int i = 0; i < bytes; i++ )
 		{
-			for ( i = 0; i < bits; i += 8 )
-			{
-				Huff_offsetTransmit( &msgHuff.compressor, ( value & 0xff ), msg->data, &msg->bit );
-				value = ( value >> 8 );
-			}
+			out[ i ] |= data[ i ] << shift;
+			out[ i + 1 ] = data[ i ] >> ( 8 - shift );
 		}
-
-		msg->cursize = ( msg->bit >> 3 ) + 1;
 	}
+
+	msg->bit += bits;
+	msg->cursize = ( msg->bit >> 3 ) + 1;
 }
 
 int MSG_ReadBits( msg_t *msg, int bits )
@@ -277,7 +451,7 @@ int MSG_ReadBits( msg_t *msg, int bits )
 
 		for ( ; i < bits; i += 8 )
 		{
-			Huff_offsetReceive( msgHuff.decompressor.tree, &get, msg->data, &msg->bit );
+			Huff_tableReceive( &msgHuffTable, &get, msg->data, msg->maxsize, &msg->bit );
 			value |= get << i;
 		}
 
@@ -859,6 +1033,7 @@ void MSG_PrioritiseEntitystateFields()
 		fieldorders[ i ] = i;
 	}
 
+	MSG_FlushFieldUses();
 	qsort( fieldorders, numfields, sizeof( int ), qsort_entitystatefields );
 
 	Log::Notice( "Entitystate fields in order of priority" );
@@ -877,6 +1052,264 @@ void MSG_PrioritiseEntitystateFields()
 static const int FLOAT_INT_BITS = 13;
 static const int FLOAT_INT_BIAS = ( 1 << ( FLOAT_INT_BITS - 1 ) );
 
+/*
+ * Entity states and playerstates are flat arrays of 32-bit words, so instead
+ * of comparing them field by field, the changed words are found with vector
+ * compares and then mapped to the fields they belong to.
+ */
+
+#define MAX_FIELD_WORDS  ( MAX_PLAYERSTATE_SIZE / 4 )
+#define FIELD_MASK_WORDS ( ( MAX_FIELD_WORDS + 63 ) / 64 )
+
+struct fieldMap_t
+{
+	int     numWords;
+	bool    direct; // false if fields share words, they are then compared one by one
+	int16_t wordField[ MAX_FIELD_WORDS ]; // -1 for words that are not sent
+};
+
+// sets bit i of the mask if the i-th words of a and b differ
+static void MSG_ChangedWords( const int *a, const int *b, int numWords, uint64_t *mask )
+{
+	int i = 0;
+
+	memset( mask, 0, ( ( numWords + 63 ) / 64 ) * sizeof( uint64_t ) );
+
+#if defined(DAEMON_USE_ARCH_INTRINSICS_i686_sse2)
+	for ( ; i + 4 <= numWords; i += 4 )
+	{
+		__m128i va = _mm_loadu_si128( ( const __m128i * )( a + i ) );
+		__m128i vb = _mm_loadu_si128( ( const __m128i * )( b + i ) );
+		int     equal = _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( va, vb ) ) );
+
+		mask[ i >> 6 ] |= uint64_t( equal ^ 0xf ) << ( i & 63 );
+	}
+#endif
+
+	for ( ; i < numWords; i++ )
+	{
+		if ( a[ i ] != b[ i ] )
+		{
+			mask[ i >> 6 ] |= uint64_t( 1 ) << ( i & 63 );
+		}
+	}
+}
+
+static void MSG_BuildFieldMap( fieldMap_t *map, const netField_t *fields, int numFields, int size )
+{
+	map->numWords = size / 4;
+	map->direct = true;
+	std::fill_n( map->wordField, MAX_FIELD_WORDS, -1 );
+
+	for ( int i = 0; i < numFields; i++ )
+	{
+		int first = fields[ i ].offset / 4;
+		int count = fields[ i ].bits == STATS_GROUP_FIELD ? STATS_GROUP_NUM_STATS : 1;
+
+		for ( int word = first; word < first + count; word++ )
+		{
+			if ( map->wordField[ word ] != -1 )
+			{
+				map->direct = false;
+			}
+
+			map->wordField[ word ] = i;
+		}
+	}
+}
+
+/*
+The deltas are written on the snapshot workers, so the changed fields are
+counted per thread and only added to the field tables by MSG_FlushFieldUses.
+*/
+static thread_local int entityStateFieldUses[ MAX_FIELD_WORDS ];
+static thread_local int playerStateFieldUses[ MAX_FIELD_WORDS ];
+static std::mutex fieldUsesMutex;
+
+/*
+=============
+MSG_ChangedFields
+
+Sets the bits of the changed fields in the mask, and returns the number of
+fields up to the last changed one.
+=============
+*/
+static int MSG_ChangedFields( const fieldMap_t *map, const netField_t *fields, int *uses, int numFields, const void *from,
+                              const void *to, uint64_t *changed )
+{
+	memset( changed, 0, FIELD_MASK_WORDS * sizeof( uint64_t ) );
+
+	if ( map->direct )
+	{
+		uint64_t words[ FIELD_MASK_WORDS ];
+
+		MSG_ChangedWords( ( const int * ) from, ( const int * ) to, map->numWords, words );
+
+		for ( int i = 0; i < ( map->numWords + 63 ) / 64; i++ )
+		{
+			for ( uint64_t bits = words[ i ]; bits; bits &= bits - 1 )
+			{
+				int field = map->wordField[ i * 64 + CountTrailingZeroes( static_cast<unsigned long long>( bits ) ) ];
+
+				if ( field >= 0 )
+				{
+					changed[ field >> 6 ] |= uint64_t( 1 ) << ( field & 63 );
+				}
+			}
+		}
+	}
+	else
+	{
+		for ( int i = 0; i < numFields; i++ )
+		{
+			const netField_t *field = &fields[ i ];
+			const int        *fromF = ( const int * )( ( const byte * ) from + field->offset );
+			const int        *toF = ( const int * )( ( const byte * ) to + field->offset );
+
+			if ( field->bits == STATS_GROUP_FIELD
+			     ? memcmp( fromF, toF, sizeof( int ) * STATS_GROUP_NUM_STATS )
+			     : *fromF != *toF )
+			{
+				changed[ i >> 6 ] |= uint64_t( 1 ) << ( i & 63 );
+			}
+		}
+	}
+
+	int lc = 0;
+
+	for ( int i = 0; i < FIELD_MASK_WORDS; i++ )
+	{
+		for ( uint64_t bits = changed[ i ]; bits; bits &= bits - 1 )
+		{
+			int field = i * 64 + CountTrailingZeroes( static_cast<unsigned long long>( bits ) );
+
+			uses[ field ]++;
+			lc = field + 1;
+		}
+	}
+
+	return lc;
+}
+
+// includes presence bit
+static void WriteStatsGroup( msgWriter_t *w, const int *from, const int *to )
+{
+	uint64_t statsbits;
+
+	MSG_ChangedWords( from, to, STATS_GROUP_NUM_STATS, &statsbits );
+
+	if (!statsbits)
+	{
+		MSG_WriterBits( w, 0, 1 );  // no change to stats
+		return;
+	}
+
+	MSG_WriterBits( w, 1, 1 );  // changed
+	MSG_WriterBits( w, statsbits, 16 );
+
+	for ( int i = 0; i < MAX_STATS; i++ )
+	{
+		if ( statsbits & ( 1 << i ) )
+		{
+			MSG_WriterBits( w, to[i], 16 );  //----(SA)    back to short since weapon bits are handled elsewhere now
+		}
+	}
+}
+
+/*
+=============
+MSG_WriteDeltaFields
+
+Writes the changed fields from one state to another, as found by
+MSG_ChangedFields, in a single batch. Entity states have an extra bit telling
+zero values apart, playerstates don't but have stats groups.
+=============
+*/
+static void MSG_WriteDeltaFields( msg_t *msg, const netField_t *fields, const uint64_t *changed, const void *from,
+                                  const void *to, bool entity )
+{
+	msgWriter_t w;
+	int         next = 0; // first field not written yet
+
+	if ( msg->oob )
+	{
+		Sys::Drop( "MSG_WriteDeltaFields: OOB message" );
+	}
+
+	MSG_BeginWriter( &w, msg );
+
+	for ( int word = 0; word < FIELD_MASK_WORDS; word++ )
+	{
+		for ( uint64_t bits = changed[ word ]; bits; bits &= bits - 1 )
+		{
+			int              i = word * 64 + CountTrailingZeroes( static_cast<unsigned long long>( bits ) );
+			const netField_t *field = &fields[ i ];
+			const int        *toF = ( const int * )( ( const byte * ) to + field->offset );
+
+			// no change to the fields in between
+			MSG_WriterZeros( &w, i - next );
+			next = i + 1;
+
+			if ( field->bits == STATS_GROUP_FIELD )
+			{
+				WriteStatsGroup( &w, ( const int * )( ( const byte * ) from + field->offset ), toF );
+				continue;
+			}
+
+			MSG_WriterBits( &w, 1, 1 );  // changed
+
+			if ( field->bits == 0 )
+			{
+				// float
+				float fullFloat = * ( const float * ) toF;
+				int   trunc = ( int ) fullFloat;
+
+				if ( entity )
+				{
+					if ( fullFloat == 0.0f )
+					{
+						MSG_WriterBits( &w, 0, 1 );
+						continue;
+					}
+
+					MSG_WriterBits( &w, 1, 1 );
+				}
+
+				if ( trunc == fullFloat && trunc + FLOAT_INT_BIAS >= 0 && trunc + FLOAT_INT_BIAS < ( 1 << FLOAT_INT_BITS ) )
+				{
+					// send as small integer
+					MSG_WriterBits( &w, 0, 1 );
+					MSG_WriterBits( &w, trunc + FLOAT_INT_BIAS, FLOAT_INT_BITS );
+				}
+				else
+				{
+					// send as full floating point value
+					MSG_WriterBits( &w, 1, 1 );
+					MSG_WriterBits( &w, *toF, 32 );
+				}
+			}
+			else
+			{
+				// integer
+				if ( entity )
+				{
+					if ( *toF == 0 )
+					{
+						MSG_WriterBits( &w, 0, 1 );
+						continue;
+					}
+
+					MSG_WriterBits( &w, 1, 1 );
+				}
+
+				MSG_WriterBits( &w, *toF, field->bits );
+			}
+		}
+	}
+
+	MSG_EndWriter( &w );
+}
+
 /*
 ==================
 MSG_WriteDeltaEntity
@@ -890,11 +1323,8 @@ identical, under the assumption that the in-order delta code will catch it.
 */
 void MSG_WriteDeltaEntity( msg_t *msg, entityState_t *from, entityState_t *to, bool force )
 {
-	int        i, lc;
-	netField_t *field;
-	int        trunc;
-	float      fullFloat;
-	int        *fromF, *toF;
+	int        lc;
+	uint64_t   changed[ FIELD_MASK_WORDS ];
 
 	const int numFields = ARRAY_LEN(entityStateFields);
 
@@ -927,21 +1357,13 @@ void MSG_WriteDeltaEntity( msg_t *msg, entityState_t *from, entityState_t *to, b
 		Sys::Error( "MSG_WriteDeltaEntity: Bad entity number: %i", to->number );
 	}
 
-	lc = 0;
-
-	// build the change vector as bytes so it is endian independent
-	for ( i = 0, field = entityStateFields; i < numFields; i++, field++ )
-	{
-		fromF = ( int * )( ( byte * ) from + field->offset );
-		toF = ( int * )( ( byte * ) to + field->offset );
-
-		if ( *fromF != *toF )
-		{
-			lc = i + 1;
+	static const fieldMap_t fieldMap = [] {
+		fieldMap_t map;
+		MSG_BuildFieldMap( &map, entityStateFields, numFields, sizeof( entityState_t ) );
+		return map;
+	}();
 
-			field->used++;
-		}
-	}
+	lc = MSG_ChangedFields( &fieldMap, entityStateFields, entityStateFieldUses, numFields, from, to, changed );
 
 	if ( lc == 0 )
 	{
@@ -966,70 +1388,7 @@ void MSG_WriteDeltaEntity( msg_t *msg, entityState_t *from, entityState_t *to, b
 
 //  Log::Notice( "Delta for ent %i: ", to->number );
 
-	for ( i = 0, field = entityStateFields; i < lc; i++, field++ )
-	{
-		fromF = ( int * )( ( byte * ) from + field->offset );
-		toF = ( int * )( ( byte * ) to + field->offset );
-
-		if ( *fromF == *toF )
-		{
-			MSG_WriteBits( msg, 0, 1 );  // no change
-			continue;
-		}
-
-		MSG_WriteBits( msg, 1, 1 );  // changed
-
-		if ( field->bits == 0 )
-		{
-			// float
-			fullFloat = * ( float * ) toF;
-			trunc = ( int ) fullFloat;
-
-			if ( fullFloat == 0.0f )
-			{
-				MSG_WriteBits( msg, 0, 1 );
-			}
-			else
-			{
-				MSG_WriteBits( msg, 1, 1 );
-
-				if ( trunc == fullFloat && trunc + FLOAT_INT_BIAS >= 0 && trunc + FLOAT_INT_BIAS < ( 1 << FLOAT_INT_BITS ) )
-				{
-					// send as small integer
-					MSG_WriteBits( msg, 0, 1 );
-					MSG_WriteBits( msg, trunc + FLOAT_INT_BIAS, FLOAT_INT_BITS );
-//                  if ( print ) {
-//                      Log::Notice( "%s:%i ", field->name, trunc );
-//                  }
-				}
-				else
-				{
-					// send as full floating point value
-					MSG_WriteBits( msg, 1, 1 );
-					MSG_WriteBits( msg, *toF, 32 );
-//                  if ( print ) {
-//                      Log::Notice( "%s:%f ", field->name, *(float *)toF );
-//                  }
-				}
-			}
-		}
-		else
-		{
-			if ( *toF == 0 )
-			{
-				MSG_WriteBits( msg, 0, 1 );
-			}
-			else
-			{
-				MSG_WriteBits( msg, 1, 1 );
-				// integer
-				MSG_WriteBits( msg, *toF, field->bits );
-//              if ( print ) {
-//                  Log::Notice( "%s:%i ", field->name, *toF );
-//              }
-			}
-		}
-	}
+	MSG_WriteDeltaFields( msg, entityStateFields, changed, from, to, true );
 
 //  Log::Notice( "" );
 
@@ -1227,6 +1586,8 @@ player_state_t communication
 */
 
 static bool IsValid(const NetcodeTable& table, int size) {
+	if (table.size() > MAX_FIELD_WORDS)
+		return false;
 	if (size % PLAYERSTATE_FIELD_SIZE != 0 || size < int(offsetof(OpaquePlayerState, END)) || size > MAX_PLAYERSTATE_SIZE)
 		return false;
 	for (const netField_t& f : table) {
@@ -1247,6 +1608,7 @@ static bool IsValid(const NetcodeTable& table, int size) {
 
 static NetcodeTable playerStateFields;
 static size_t playerStateSize;
+static fieldMap_t playerStateFieldMap;
 // This will be called twice (with what should be the same data both times) in a local
 // game where both the cgame and sgame are running.
 void MSG_InitNetcodeTables(NetcodeTable playerStateTable, int psSize) {
@@ -1255,9 +1617,34 @@ void MSG_InitNetcodeTables(NetcodeTable playerStateTable, int psSize) {
 
 	playerStateFields = std::move(playerStateTable);
 	playerStateSize = psSize;
+	MSG_BuildFieldMap(&playerStateFieldMap, playerStateFields.data(), playerStateFields.size(), psSize);
 }
 // TODO: add function to clear
 
+/*
+=============
+MSG_FlushFieldUses
+
+Adds the changed fields counted by this thread to the field tables.
+=============
+*/
+void MSG_FlushFieldUses()
+{
+	std::lock_guard<std::mutex> lock( fieldUsesMutex );
+
+	for ( size_t i = 0; i < ARRAY_LEN( entityStateFields ); i++ )
+	{
+		entityStateFields[ i ].used += entityStateFieldUses[ i ];
+		entityStateFieldUses[ i ] = 0;
+	}
+
+	for ( size_t i = 0; i < playerStateFields.size(); i++ )
+	{
+		playerStateFields[ i ].used += playerStateFieldUses[ i ];
+		playerStateFieldUses[ i ] = 0;
+	}
+}
+
 
 static int qsort_playerstatefields( const void *a, const void *b )
 {
@@ -1288,6 +1675,7 @@ void MSG_PrioritisePlayerStateFields()
 		fieldorders[ i ] = i;
 	}
 
+	MSG_FlushFieldUses();
 	qsort( &fieldorders[ 0 ], fieldorders.size(), sizeof( int ), qsort_playerstatefields );
 
 	Log::Notice( "Playerstate fields in order of priority" );
@@ -1301,35 +1689,6 @@ void MSG_PrioritisePlayerStateFields()
 	Log::Notice( "};" );
 }
 
-// includes presence bit
-static void WriteStatsGroup(msg_t* msg, const int* from, const int* to)
-{
-	int statsbits = 0;
-	for ( int i = 0; i < STATS_GROUP_NUM_STATS; i++ )
-	{
-		if ( from[i] != to[i] )
-		{
-			statsbits |= 1 << i;
-		}
-	}
-	if (!statsbits)
-	{
-		MSG_WriteBits( msg, 0, 1 );  // no change to stats
-		return;
-	}
-
-	MSG_WriteBits( msg, 1, 1 );  // changed
-	MSG_WriteShort( msg, statsbits );
-
-	for ( int i = 0; i < MAX_STATS; i++ )
-	{
-		if ( statsbits & ( 1 << i ) )
-		{
-			MSG_WriteShort( msg, to[i] );  //----(SA)    back to short since weapon bits are handled elsewhere now
-		}
-	}
-}
-
 /*
 =============
 MSG_WriteDeltaPlayerstate
@@ -1339,9 +1698,7 @@ MSG_WriteDeltaPlayerstate
 void MSG_WriteDeltaPlayerstate( msg_t *msg, OpaquePlayerState *from, OpaquePlayerState *to )
 {
 	int           lc;
-	int        *fromF, *toF;
-	float      fullFloat;
-	int        trunc;
+	uint64_t      changed[ FIELD_MASK_WORDS ];
 	int        startBit, endBit;
 	int        print;
 
@@ -1376,81 +1733,11 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, OpaquePlayerState *from, OpaquePlaye
 		print = 0;
 	}
 
-	int numFields = playerStateFields.size();
-
-	lc = 0;
-
-	for ( int i = 0; i < numFields; i++ )
-	{
-		netField_t* field = &playerStateFields[i];
-		fromF = ( int * )( ( byte * ) from + field->offset );
-		toF = ( int * )( ( byte * ) to + field->offset );
-
-		if (field->bits == STATS_GROUP_FIELD
-			? memcmp(fromF, toF, sizeof(int) * STATS_GROUP_NUM_STATS)
-			: *fromF != *toF )
-		{
-			lc = i + 1;
-
-			field->used++;
-		}
-	}
+	lc = MSG_ChangedFields( &playerStateFieldMap, playerStateFields.data(), playerStateFieldUses, playerStateFields.size(), from, to, changed );
 
 	MSG_WriteByte( msg, lc );  // # of changes
 
-	for ( int i = 0; i < lc; i++ )
-	{
-		netField_t* field = &playerStateFields[i];
-		fromF = ( int * )( ( byte * ) from + field->offset );
-		toF = ( int * )( ( byte * ) to + field->offset );
-
-		if (field->bits == STATS_GROUP_FIELD)
-		{
-			WriteStatsGroup(msg, fromF, toF);
-			continue;
-		}
-		if ( *fromF == *toF )
-		{
-			MSG_WriteBits( msg, 0, 1 );  // no change
-			continue;
-		}
-
-		MSG_WriteBits( msg, 1, 1 );  // changed
-
-		if ( field->bits == 0 )
-		{
-			// float
-			fullFloat = * ( float * ) toF;
-			trunc = ( int ) fullFloat;
-
-			if ( trunc == fullFloat && trunc + FLOAT_INT_BIAS >= 0 && trunc + FLOAT_INT_BIAS < ( 1 << FLOAT_INT_BITS ) )
-			{
-				// send as small integer
-				MSG_WriteBits( msg, 0, 1 );
-				MSG_WriteBits( msg, trunc + FLOAT_INT_BIAS, FLOAT_INT_BITS );
-//              if ( print ) {
-//                  Log::Notice( "%s:%i ", field->name, trunc );
-//              }
-			}
-			else
-			{
-				// send as full floating point value
-				MSG_WriteBits( msg, 1, 1 );
-				MSG_WriteBits( msg, *toF, 32 );
-//              if ( print ) {
-//                  Log::Notice( "%s:%f ", field->name, *(float *)toF );
-//              }
-			}
-		}
-		else
-		{
-			// integer
-			MSG_WriteBits( msg, *toF, field->bits );
-//          if ( print ) {
-//              Log::Notice( "%s:%i ", field->name, *toF );
-//          }
-		}
-	}
+	MSG_WriteDeltaFields( msg, playerStateFields.data(), changed, from, to, false );
 
 	if ( print )
 	{
@@ -1884,6 +2171,9 @@ void MSG_initHuffman()
 			Huff_addRef( &msgHuff.decompressor, ( byte ) i );  /* Do update */
 		}
 	}
+
+	// the compressor and decompressor trees are the same, and won't change anymore
+	Huff_BuildTable( &msgHuffTable, &msgHuff.compressor );
 }
 
 //===========================================================================
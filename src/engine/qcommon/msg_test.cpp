@@ -0,0 +1,365 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <chrono>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "qcommon/qcommon.h"
+
+namespace {
+
+struct BitWrite {
+    int value;
+    int bits;
+};
+
+std::vector<BitWrite> RandomWrites(std::mt19937& rng, int count)
+{
+    std::vector<BitWrite> writes;
+    for (int i = 0; i < count; i++) {
+        int bits = std::uniform_int_distribution<int>(1, 32)(rng);
+        writes.push_back({static_cast<int>(rng()), bits});
+    }
+    return writes;
+}
+
+void Write(msg_t* msg, const std::vector<BitWrite>& writes)
+{
+    for (const BitWrite& write : writes) {
+        MSG_WriteBits(msg, write.value, write.bits);
+    }
+}
+
+TEST(MsgTest, WriteBitstreamMatchesWriteBits)
+{
+    std::mt19937 rng(1234);
+
+    for (int iteration = 0; iteration < 200; iteration++) {
+        std::vector<BitWrite> prefix = RandomWrites(rng, iteration % 13);
+        std::vector<BitWrite> fragment = RandomWrites(rng, iteration % 7);
+        std::vector<BitWrite> suffix = RandomWrites(rng, 3);
+
+        std::vector<byte> expectedData(1024), fragmentData(1024), actualData(1024);
+        msg_t expected, fragmentMsg, actual;
+
+        MSG_Init(&expected, expectedData.data(), expectedData.size());
+        Write(&expected, prefix);
+        Write(&expected, fragment);
+        Write(&expected, suffix);
+
+        MSG_Init(&fragmentMsg, fragmentData.data(), fragmentData.size());
+        Write(&fragmentMsg, fragment);
+
+        MSG_Init(&actual, actualData.data(), actualData.size());
+        Write(&actual, prefix);
+        MSG_WriteBitstream(&actual, fragmentData.data(), fragmentMsg.bit, fragmentMsg.uncompsize);
+        Write(&actual, suffix);
+
+        ASSERT_EQ(expected.bit, actual.bit);
+        ASSERT_EQ(expected.cursize, actual.cursize);
+        ASSERT_EQ(expected.uncompsize, actual.uncompsize);
+        ASSERT_EQ(0, memcmp(expectedData.data(), actualData.data(), expected.cursize)) << "iteration " << iteration;
+    }
+}
+
+// Random adaptive trees, some of them not having every symbol
+std::unique_ptr<huffman_t> RandomTree(std::mt19937& rng, int numSymbols)
+{
+    std::unique_ptr<huffman_t> huff(new huffman_t);
+    Huff_Init(huff.get());
+    std::uniform_int_distribution<int> symbol(0, numSymbols - 1);
+    std::geometric_distribution<int> count(0.01);
+    for (int i = 0; i < numSymbols; i++) {
+        for (int j = count(rng) + 1; j > 0; j--) {
+            Huff_addRef(&huff->compressor, symbol(rng));
+        }
+    }
+    return huff;
+}
+
+TEST(HuffmanTest, TableTransmitMatchesTree)
+{
+    std::mt19937 rng(42);
+
+    for (int numSymbols : {2, 17, 256}) {
+        std::unique_ptr<huffman_t> huff = RandomTree(rng, numSymbols);
+        std::unique_ptr<huffTable_t> table(new huffTable_t);
+        Huff_BuildTable(table.get(), &huff->compressor);
+
+        std::vector<int> symbols;
+        for (int ch = 0; ch < HMAX; ch++) {
+            if (huff->compressor.loc[ch]) {
+                symbols.push_back(ch);
+            }
+        }
+
+        std::vector<byte> expected(65536), actual(65536);
+        int expectedBit = 0, actualBit = 0;
+        for (int i = 0; i < 10000; i++) {
+            int ch = symbols[rng() % symbols.size()];
+            Huff_offsetTransmit(&huff->compressor, ch, expected.data(), &expectedBit);
+            Huff_tableTransmit(table.get(), ch, actual.data(), &actualBit);
+            ASSERT_EQ(expectedBit, actualBit);
+        }
+        EXPECT_EQ(0, memcmp(expected.data(), actual.data(), (expectedBit + 7) / 8));
+    }
+}
+
+TEST(HuffmanTest, TableReceiveMatchesTree)
+{
+    std::mt19937 rng(1337);
+
+    for (int numSymbols : {2, 17, 256}) {
+        std::unique_ptr<huffman_t> huff = RandomTree(rng, numSymbols);
+        std::unique_ptr<huffTable_t> table(new huffTable_t);
+        Huff_BuildTable(table.get(), &huff->compressor);
+
+        // decode random garbage, which also goes through NYT and up to the
+        // end of the buffer
+        std::vector<byte> data(4096);
+        for (byte& b : data) {
+            b = rng();
+        }
+
+        int expectedBit = 0, actualBit = 0;
+        while (expectedBit < int(data.size()) * 8 - 64) {
+            int expectedCh = -1, actualCh = -1;
+            Huff_offsetReceive(huff->compressor.tree, &expectedCh, data.data(), &expectedBit);
+            Huff_tableReceive(table.get(), &actualCh, data.data(), data.size(), &actualBit);
+            ASSERT_EQ(expectedCh, actualCh);
+            ASSERT_EQ(expectedBit, actualBit);
+        }
+    }
+}
+
+TEST(HuffmanTest, MessagesRoundTrip)
+{
+    std::mt19937 rng(7);
+    std::vector<BitWrite> writes = RandomWrites(rng, 5000);
+    std::vector<byte> data(MAX_MSGLEN);
+    msg_t msg;
+
+    MSG_Init(&msg, data.data(), data.size());
+    Write(&msg, writes);
+    ASSERT_FALSE(msg.overflowed);
+
+    MSG_BeginReading(&msg);
+    for (const BitWrite& write : writes) {
+        int mask = write.bits == 32 ? -1 : (1 << write.bits) - 1;
+        ASSERT_EQ(write.value & mask, MSG_ReadBits(&msg, write.bits) & mask);
+    }
+}
+
+TEST(MsgTest, DeltaEntitiesRoundTrip)
+{
+    std::mt19937 rng(55);
+    std::vector<byte> data(MAX_MSGLEN);
+    msg_t msg;
+
+    for (int iteration = 0; iteration < 100; iteration++) {
+        entityState_t from{}, to{};
+        int* fromWords = reinterpret_cast<int*>(&from);
+        int* toWords = reinterpret_cast<int*>(&to);
+        // the smallest integer fields have 8 bits
+        for (size_t word = 1; word < sizeof(entityState_t) / sizeof(int); word++) {
+            fromWords[word] = rng() % 2 ? 0 : rng() % 256;
+            toWords[word] = rng() % 3 ? fromWords[word] : rng() % 3 ? 0 : rng() % 256;
+        }
+        // and some real floats, small integers are sent differently
+        for (int i = 0; i < 3; i++) {
+            to.origin[i] = rng() % 2 ? float(int(rng() % 8192) - 4096) : float(rng()) / 1000.0f;
+            to.angles[i] = rng() % 2 ? 0.0f : float(rng() % 360);
+        }
+        from.number = to.number = iteration;
+
+        MSG_Init(&msg, data.data(), data.size());
+        MSG_WriteBits(&msg, iteration % 5, 3); // start the delta at any bit
+        MSG_WriteDeltaEntity(&msg, &from, &to, true);
+
+        entityState_t read;
+        MSG_BeginReading(&msg);
+        MSG_ReadBits(&msg, 3);
+        int number = MSG_ReadBits(&msg, GENTITYNUM_BITS);
+        ASSERT_EQ(iteration, number);
+        MSG_ReadDeltaEntity(&msg, &from, &read, number);
+        ASSERT_EQ(0, memcmp(&to, &read, sizeof(entityState_t))) << "iteration " << iteration;
+    }
+}
+
+TEST(MsgTest, DeltaPlayerstatesRoundTrip)
+{
+    const int size = 400;
+    NetcodeTable table = {
+        {"origin[0]", 0, 0, 0},
+        {"origin[1]", 4, 0, 0},
+        {"origin[2]", 8, 0, 0},
+        {"ping", 12, 16, 0},
+        {"persistant", 16, STATS_GROUP_FIELD, 0},
+        {"viewheight", 80, 8, 0},
+        {"commandTime", 124, 32, 0},
+        {"stats", 200, STATS_GROUP_FIELD, 0},
+        {"misc", 300, -16, 0},
+        {"last", 396, 8, 0},
+    };
+    std::mt19937 rng(8);
+    std::vector<byte> data(MAX_MSGLEN);
+    msg_t msg;
+
+    // the second time with fields sharing words
+    for (bool shared : {false, true}) {
+        if (shared) {
+            table.push_back({"alias", 80, 8, 0});
+        }
+        MSG_InitNetcodeTables(table, size);
+
+        for (int iteration = 0; iteration < 100; iteration++) {
+            OpaquePlayerState from{}, to{};
+            for (int i = 0; i < 3; i++) {
+                from.origin[i] = float(rng() % 1000);
+                to.origin[i] = rng() % 2 ? from.origin[i] : float(rng()) / 1000.0f;
+            }
+            for (int offset : {12, 80, 124, 396}) {
+                int* fromWord = reinterpret_cast<int*>(from.storage + offset);
+                int* toWord = reinterpret_cast<int*>(to.storage + offset);
+                *fromWord = rng() % 256;
+                *toWord = rng() % 2 ? *fromWord : rng() % 256;
+            }
+            for (int offset : {16, 200}) {
+                int* fromStats = reinterpret_cast<int*>(from.storage + offset);
+                int* toStats = reinterpret_cast<int*>(to.storage + offset);
+                for (int i = 0; i < STATS_GROUP_NUM_STATS; i++) {
+                    fromStats[i] = rng() % 32768;
+                    toStats[i] = rng() % 4 ? fromStats[i] : rng() % 32768;
+                }
+            }
+            *reinterpret_cast<int*>(to.storage + 300) = int(rng() % 65536) - 32768;
+
+            MSG_Init(&msg, data.data(), data.size());
+            MSG_WriteBits(&msg, iteration % 5, 3); // start the delta at any bit
+            MSG_WriteDeltaPlayerstate(&msg, &from, &to);
+
+            OpaquePlayerState read;
+            MSG_BeginReading(&msg);
+            MSG_ReadBits(&msg, 3);
+            MSG_ReadDeltaPlayerstate(&msg, &from, &read);
+            ASSERT_EQ(0, memcmp(&to, &read, size)) << "iteration " << iteration;
+        }
+    }
+}
+
+TEST(MsgTest, DISABLED_SnapshotBenchmark)
+{
+    // a full snapshot of 256 entities, each with a few fields changed
+    std::mt19937 rng(256);
+    const int numEntities = 256;
+    std::vector<entityState_t> from(numEntities), to(numEntities);
+    for (int i = 0; i < numEntities; i++) {
+        int* fromWords = reinterpret_cast<int*>(&from[i]);
+        int* toWords = reinterpret_cast<int*>(&to[i]);
+        for (size_t word = 1; word < sizeof(entityState_t) / sizeof(int); word++) {
+            fromWords[word] = rng() % 4 ? 0 : rng() % 1024;
+            toWords[word] = rng() % 5 ? fromWords[word] : rng() % 65536;
+        }
+        from[i].number = to[i].number = i;
+    }
+
+    std::vector<byte> data(MAX_MSGLEN);
+    msg_t msg;
+    const int rounds = 2000;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        MSG_Init(&msg, data.data(), data.size());
+        for (int i = 0; i < numEntities; i++) {
+            MSG_WriteDeltaEntity(&msg, &from[i], &to[i], true);
+        }
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    ASSERT_FALSE(msg.overflowed);
+    Log::Notice("%d entity snapshot, %d bytes: %.2f us", numEntities, msg.cursize, ns / 1000.0 / rounds);
+}
+
+TEST(HuffmanTest, DISABLED_Benchmark)
+{
+    std::mt19937 rng(99);
+    std::vector<byte> message(MAX_MSGLEN / 2);
+    for (byte& b : message) {
+        // skewed like snapshot data, mostly small values
+        b = std::min(255, int(std::geometric_distribution<int>(0.1)(rng)));
+    }
+
+    // the same tree as messages use
+    std::vector<byte> data(MAX_MSGLEN * 2);
+    std::unique_ptr<huffman_t> huff(new huffman_t);
+    Huff_Init(huff.get());
+    for (byte b : message) {
+        Huff_addRef(&huff->compressor, b);
+    }
+    std::unique_ptr<huffTable_t> table(new huffTable_t);
+    Huff_BuildTable(table.get(), &huff->compressor);
+
+    const int rounds = 200;
+    auto time = [&](const char* name, const std::function<void()>& run) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++) {
+            run();
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        Log::Notice("%s: %.2f ns/byte", name, double(ns) / rounds / message.size());
+    };
+
+    time("tree transmit", [&] {
+        int bit = 0;
+        for (byte b : message) {
+            Huff_offsetTransmit(&huff->compressor, b, data.data(), &bit);
+        }
+    });
+    time("table transmit", [&] {
+        int bit = 0;
+        for (byte b : message) {
+            Huff_tableTransmit(table.get(), b, data.data(), &bit);
+        }
+    });
+    time("tree receive", [&] {
+        int bit = 0, ch;
+        for (size_t i = 0; i < message.size(); i++) {
+            Huff_offsetReceive(huff->compressor.tree, &ch, data.data(), &bit);
+        }
+    });
+    time("table receive", [&] {
+        int bit = 0, ch;
+        for (size_t i = 0; i < message.size(); i++) {
+            Huff_tableReceive(table.get(), &ch, data.data(), data.size(), &bit);
+        }
+    });
+}
+
+} // namespace
@@ -104,6 +104,10 @@ static bool winsockInitialized = false;
 #               include <sys/filio.h>
 #       endif
 
+#       ifdef __linux__
+#               include <poll.h>
+#       endif
+
 using SOCKET = int;
 constexpr SOCKET INVALID_SOCKET{-1};
 constexpr SOCKET SOCKET_ERROR{-1};
@@ -570,137 +574,429 @@ bool        NET_IsLocalAddress( const netadr_t& adr )
 
 //=============================================================================
 
+/*
+=============================================================================
+
+Batched UDP I/O
+
+Linux can receive and send several datagrams with a single system call, see
+recvmmsg(2) and sendmmsg(2). Datagrams are received in batches into a ring
+that Sys_GetPacket then returns one by one, and the packets sent between
+NET_BeginSendBatch and NET_FlushSendBatch are queued and sent together.
+Elsewhere, or if the calls are not available, every datagram gets its own
+recvfrom or sendto.
+
+=============================================================================
+*/
+
+#if defined(__linux__)
+#define NET_BATCHED_IO
+#endif
+
+#ifdef NET_BATCHED_IO
+static Cvar::Cvar<bool> net_batchIO("net_batchIO", "receive and send several UDP packets per system call", Cvar::NONE, true);
+
+static const int NET_RECV_BATCH = 16;
+static const int NET_SEND_BATCH = 64;
+static const int NET_SEND_BATCH_BYTES = 65536;
+
+struct receivedPackets_t
+{
+	SOCKET                  socket;
+	int                     count; // received in the last batch
+	int                     next; // next one to be returned by Sys_GetPacket
+	struct mmsghdr          headers[ NET_RECV_BATCH ];
+	struct iovec            iov[ NET_RECV_BATCH ];
+	struct sockaddr_storage from[ NET_RECV_BATCH ];
+	byte                    data[ NET_RECV_BATCH ][ MAX_MSGLEN ];
+};
+
+struct sendQueue_t
+{
+	bool                    active; // between NET_BeginSendBatch and NET_FlushSendBatch
+	int                     count;
+	int                     bytes;
+	SOCKET                  sockets[ NET_SEND_BATCH ];
+	netadrtype_t            types[ NET_SEND_BATCH ];
+	struct mmsghdr          headers[ NET_SEND_BATCH ];
+	struct iovec            iov[ NET_SEND_BATCH ];
+	struct sockaddr_storage to[ NET_SEND_BATCH ];
+	byte                    data[ NET_SEND_BATCH_BYTES ];
+};
+
+static receivedPackets_t received;
+static sendQueue_t       sendQueue;
+static bool              batchedIOUnavailable = false; // the kernel lacks the calls
+#endif
+
 /*
 ==================
-Sys_GetPacket
+NET_ReceivedPacket
 
-Never called by the game logic, just the system event queuing
+Fills in where a datagram that was received on a socket comes from,
+returns false if it must be dropped
 ==================
 */
-bool Sys_GetPacket( netadr_t *net_from, msg_t *net_message )
+static bool NET_ReceivedPacket( SOCKET socket, struct sockaddr_storage *from, socklen_t fromlen, int ret,
+                                netadr_t *net_from, msg_t *net_message )
+{
+	if ( socket == ip_socket )
+	{
+		memset( ( ( struct sockaddr_in * ) from )->sin_zero, 0, 8 );
+	}
+
+	if ( socket == ip_socket && usingSocks && memcmp( from, &socksRelayAddr, fromlen ) == 0 )
+	{
+		if ( ret < 10 || net_message->data[ 0 ] != 0 || net_message->data[ 1 ] != 0 || net_message->data[ 2 ] != 0 || net_message->data[ 3 ] != 1 )
+		{
+			return false;
+		}
+
+		net_from->type = netadrtype_t::NA_IP;
+		net_from->ip[ 0 ] = net_message->data[ 4 ];
+		net_from->ip[ 1 ] = net_message->data[ 5 ];
+		net_from->ip[ 2 ] = net_message->data[ 6 ];
+		net_from->ip[ 3 ] = net_message->data[ 7 ];
+		net_from->port = * ( short * ) &net_message->data[ 8 ];
+		net_message->readcount = 10;
+	}
+	else
+	{
+		SockadrToNetadr( ( struct sockaddr * ) from, net_from );
+		net_message->readcount = 0;
+	}
+
+	if ( ret >= net_message->maxsize )
+	{
+		Log::Notice( "Oversize packet from %s", NET_AdrToString( *net_from ) );
+		return false;
+	}
+
+	net_message->cursize = ret;
+	return true;
+}
+
+/*
+==================
+NET_RecvFrom
+
+Returns -1 if no datagram was waiting on the socket, else whether the one
+that was received can be used
+==================
+*/
+static int NET_RecvFrom( SOCKET socket, netadr_t *net_from, msg_t *net_message )
 {
-	int                     ret;
 	struct sockaddr_storage from;
+	socklen_t               fromlen = sizeof( from );
+	int                     ret;
 
-	socklen_t               fromlen;
-	int                     err;
+	ret = recvfrom( socket, ( char * ) net_message->data, net_message->maxsize, 0, ( struct sockaddr * ) &from, &fromlen );
 
-	if ( ip_socket != INVALID_SOCKET )
+	if ( ret == SOCKET_ERROR )
 	{
-		fromlen = sizeof( from );
-		ret = recvfrom( ip_socket, ( char * ) net_message->data, net_message->maxsize, 0, ( struct sockaddr * ) &from, &fromlen );
+		int err = socketError;
 
-		if ( ret == SOCKET_ERROR )
+		if ( err != net::errc::resource_unavailable_try_again && err != net::errc::connection_reset )
 		{
-			err = socketError;
-
-			if ( err != net::errc::resource_unavailable_try_again && err != net::errc::connection_reset )
-			{
-				Log::Notice( "NET_GetPacket: %s", NET_ErrorString() );
-			}
+			Log::Notice( "NET_GetPacket: %s", NET_ErrorString() );
 		}
-		else
-		{
-			memset( ( ( struct sockaddr_in * ) &from )->sin_zero, 0, 8 );
 
-			if ( usingSocks && memcmp( &from, &socksRelayAddr, fromlen ) == 0 )
-			{
-				if ( ret < 10 || net_message->data[ 0 ] != 0 || net_message->data[ 1 ] != 0 || net_message->data[ 2 ] != 0 || net_message->data[ 3 ] != 1 )
-				{
-					return false;
-				}
+		return -1;
+	}
 
-				net_from->type = netadrtype_t::NA_IP;
-				net_from->ip[ 0 ] = net_message->data[ 4 ];
-				net_from->ip[ 1 ] = net_message->data[ 5 ];
-				net_from->ip[ 2 ] = net_message->data[ 6 ];
-				net_from->ip[ 3 ] = net_message->data[ 7 ];
-				net_from->port = * ( short * ) &net_message->data[ 8 ];
-				net_message->readcount = 10;
-			}
-			else
-			{
-				SockadrToNetadr( ( struct sockaddr * ) &from, net_from );
-				net_message->readcount = 0;
-			}
+	return NET_ReceivedPacket( socket, &from, fromlen, ret, net_from, net_message );
+}
 
-			if ( ret == net_message->maxsize )
-			{
-				Log::Notice( "Oversize packet from %s", NET_AdrToString( *net_from ) );
-				return false;
-			}
+#ifdef NET_BATCHED_IO
+/*
+==================
+NET_ReceiveBatch
 
-			net_message->cursize = ret;
-			return true;
+Receives as many datagrams as are waiting on the socket, up to NET_RECV_BATCH
+==================
+*/
+static void NET_ReceiveBatch( SOCKET socket )
+{
+	received.socket = socket;
+	received.count = 0;
+	received.next = 0;
+
+	for ( int i = 0; i < NET_RECV_BATCH; i++ )
+	{
+		received.iov[ i ].iov_base = received.data[ i ];
+		received.iov[ i ].iov_len = sizeof( received.data[ i ] );
+		memset( &received.headers[ i ], 0, sizeof( received.headers[ i ] ) );
+		received.headers[ i ].msg_hdr.msg_name = &received.from[ i ];
+		received.headers[ i ].msg_hdr.msg_namelen = sizeof( received.from[ i ] );
+		received.headers[ i ].msg_hdr.msg_iov = &received.iov[ i ];
+		received.headers[ i ].msg_hdr.msg_iovlen = 1;
+	}
+
+	int ret = recvmmsg( socket, received.headers, NET_RECV_BATCH, MSG_DONTWAIT, nullptr );
+
+	if ( ret == SOCKET_ERROR )
+	{
+		int err = socketError;
+
+		if ( err == ENOSYS )
+		{
+			batchedIOUnavailable = true;
 		}
+		else if ( err != net::errc::resource_unavailable_try_again && err != net::errc::connection_reset )
+		{
+			Log::Notice( "NET_GetPacket: %s", NET_ErrorString() );
+		}
+
+		return;
 	}
 
-	if ( ip6_socket != INVALID_SOCKET )
+	received.count = ret;
+}
+
+/*
+==================
+NET_NextReceivedPacket
+
+Returns -1 if there is no received datagram left, else whether the next one
+can be used
+==================
+*/
+static int NET_NextReceivedPacket( netadr_t *net_from, msg_t *net_message )
+{
+	if ( received.next >= received.count )
 	{
-		fromlen = sizeof( from );
-		ret = recvfrom( ip6_socket, ( char * ) net_message->data, net_message->maxsize, 0, ( struct sockaddr * ) &from, &fromlen );
+		return -1;
+	}
+
+	int             i = received.next++;
+	struct msghdr   *header = &received.headers[ i ].msg_hdr;
+	int             ret = std::min<int>( received.headers[ i ].msg_len, net_message->maxsize );
+
+	memcpy( net_message->data, received.data[ i ], ret );
+
+	return NET_ReceivedPacket( received.socket, &received.from[ i ], header->msg_namelen, ret, net_from, net_message );
+}
+#endif
+
+/*
+==================
+Sys_GetPacket
+
+Never called by the game logic, just the system event queuing
+==================
+*/
+bool Sys_GetPacket( netadr_t *net_from, msg_t *net_message )
+{
+	int ret;
 
-		if ( ret == SOCKET_ERROR )
+#ifdef NET_BATCHED_IO
+	if ( net_batchIO.Get() && !batchedIOUnavailable )
+	{
+		if ( ( ret = NET_NextReceivedPacket( net_from, net_message ) ) >= 0 )
 		{
-			err = socketError;
+			return ret;
+		}
 
-			if ( err != net::errc::resource_unavailable_try_again && err != net::errc::connection_reset )
+		for ( SOCKET socket : { ip_socket, ip6_socket } )
+		{
+			if ( socket != INVALID_SOCKET )
 			{
-				Log::Notice( "NET_GetPacket: %s", NET_ErrorString() );
+				NET_ReceiveBatch( socket );
+
+				if ( ( ret = NET_NextReceivedPacket( net_from, net_message ) ) >= 0 )
+				{
+					return ret;
+				}
 			}
 		}
-		else
-		{
-			SockadrToNetadr( ( struct sockaddr * ) &from, net_from );
-			net_message->readcount = 0;
 
-			if ( ret == net_message->maxsize )
-			{
-				Log::Notice( "Oversize packet from %s", NET_AdrToString( *net_from ) );
-				return false;
-			}
+		if ( multicast6_socket != INVALID_SOCKET && multicast6_socket != ip6_socket && !batchedIOUnavailable )
+		{
+			return NET_RecvFrom( multicast6_socket, net_from, net_message ) > 0;
+		}
 
-			net_message->cursize = ret;
-			return true;
+		if ( !batchedIOUnavailable )
+		{
+			return false;
 		}
 	}
+#endif
+
+	if ( ip_socket != INVALID_SOCKET && ( ret = NET_RecvFrom( ip_socket, net_from, net_message ) ) >= 0 )
+	{
+		return ret;
+	}
+
+	if ( ip6_socket != INVALID_SOCKET && ( ret = NET_RecvFrom( ip6_socket, net_from, net_message ) ) >= 0 )
+	{
+		return ret;
+	}
+
+	if ( multicast6_socket != INVALID_SOCKET && multicast6_socket != ip6_socket &&
+	     ( ret = NET_RecvFrom( multicast6_socket, net_from, net_message ) ) >= 0 )
+	{
+		return ret;
+	}
+
+	return false;
+}
+
+//=============================================================================
+
+static char socksBuf[ 4096 ];
+
+/*
+==================
+NET_SendError
+==================
+*/
+static void NET_SendError( int err, sa_family_t family, netadrtype_t type )
+{
+	// wouldblock is silent
+	if ( err == net::errc::resource_unavailable_try_again )
+	{
+		return;
+	}
+
+	// some PPP links do not allow broadcasts and return an error
+	if ( ( err == net::errc::address_not_available ) && ( ( type == netadrtype_t::NA_BROADCAST ) ) )
+	{
+		return;
+	}
+
+	if ( family == AF_INET )
+	{
+		Log::Notice( "Sys_SendPacket (ipv4): %s", NET_ErrorString() );
+	}
+	else if ( family == AF_INET6 )
+	{
+		Log::Notice( "Sys_SendPacket (ipv6): %s", NET_ErrorString() );
+	}
+	else
+	{
+		Log::Notice( "Sys_SendPacket (%i): %s", family, NET_ErrorString() );
+	}
+}
+
+#ifdef NET_BATCHED_IO
+/*
+==================
+NET_SendQueued
 
-	if ( multicast6_socket != INVALID_SOCKET && multicast6_socket != ip6_socket )
+Sends the queued packets, with one sendmmsg per run of packets going
+through the same socket
+==================
+*/
+static void NET_SendQueued()
+{
+	for ( int start = 0; start < sendQueue.count; )
 	{
-		fromlen = sizeof( from );
-		ret = recvfrom( multicast6_socket, ( char * ) net_message->data, net_message->maxsize, 0, ( struct sockaddr * ) &from, &fromlen );
+		int end = start + 1;
+
+		while ( end < sendQueue.count && sendQueue.sockets[ end ] == sendQueue.sockets[ start ] )
+		{
+			end++;
+		}
 
-		if ( ret == SOCKET_ERROR )
+		for ( int i = start; i < end; )
 		{
-			err = socketError;
+			int ret = batchedIOUnavailable ? SOCKET_ERROR
+			          : sendmmsg( sendQueue.sockets[ i ], &sendQueue.headers[ i ], end - i, 0 );
 
-			if ( err != net::errc::resource_unavailable_try_again && err != net::errc::connection_reset )
+			if ( ret == SOCKET_ERROR && ( batchedIOUnavailable || socketError == ENOSYS ) )
 			{
-				Log::Notice( "NET_GetPacket: %s", NET_ErrorString() );
+				batchedIOUnavailable = true;
+
+				const struct msghdr *header = &sendQueue.headers[ i ].msg_hdr;
+
+				ret = sendto( sendQueue.sockets[ i ], header->msg_iov->iov_base, header->msg_iov->iov_len, 0,
+				              ( struct sockaddr * ) header->msg_name, header->msg_namelen );
 			}
-		}
-		else
-		{
-			SockadrToNetadr( ( struct sockaddr * ) &from, net_from );
-			net_message->readcount = 0;
 
-			if ( ret == net_message->maxsize )
+			if ( ret == SOCKET_ERROR )
 			{
-				Log::Notice( "Oversize packet from %s", NET_AdrToString( *net_from ) );
-				return false;
+				// skip the packet that failed
+				NET_SendError( socketError, sendQueue.to[ i ].ss_family, sendQueue.types[ i ] );
+				ret = 1;
 			}
 
-			net_message->cursize = ret;
-			return true;
+			i += ret;
 		}
+
+		start = end;
 	}
 
-	return false;
+	sendQueue.count = 0;
+	sendQueue.bytes = 0;
 }
 
-//=============================================================================
+/*
+==================
+NET_QueuePacket
 
-static char socksBuf[ 4096 ];
+Returns false if the packet has to be sent right away
+==================
+*/
+static bool NET_QueuePacket( SOCKET socket, const struct sockaddr_storage *addr, socklen_t addrlen,
+                             const void *data, int length, netadrtype_t type )
+{
+	if ( !sendQueue.active || batchedIOUnavailable || length > NET_SEND_BATCH_BYTES )
+	{
+		return false;
+	}
+
+	if ( sendQueue.count == NET_SEND_BATCH || sendQueue.bytes + length > NET_SEND_BATCH_BYTES )
+	{
+		NET_SendQueued();
+	}
+
+	int  i = sendQueue.count++;
+	byte *copy = sendQueue.data + sendQueue.bytes;
+
+	memcpy( copy, data, length );
+	sendQueue.bytes += length;
+
+	sendQueue.sockets[ i ] = socket;
+	sendQueue.types[ i ] = type;
+	sendQueue.to[ i ] = *addr;
+	sendQueue.iov[ i ].iov_base = copy;
+	sendQueue.iov[ i ].iov_len = length;
+	memset( &sendQueue.headers[ i ], 0, sizeof( sendQueue.headers[ i ] ) );
+	sendQueue.headers[ i ].msg_hdr.msg_name = &sendQueue.to[ i ];
+	sendQueue.headers[ i ].msg_hdr.msg_namelen = addrlen;
+	sendQueue.headers[ i ].msg_hdr.msg_iov = &sendQueue.iov[ i ];
+	sendQueue.headers[ i ].msg_hdr.msg_iovlen = 1;
+
+	return true;
+}
+#endif
+
+/*
+==================
+NET_BeginSendBatch
+
+Packets sent until NET_FlushSendBatch may be queued and sent together
+==================
+*/
+void NET_BeginSendBatch()
+{
+#ifdef NET_BATCHED_IO
+	sendQueue.active = net_batchIO.Get();
+#endif
+}
+
+/*
+==================
+NET_FlushSendBatch
+==================
+*/
+void NET_FlushSendBatch()
+{
+#ifdef NET_BATCHED_IO
+	NET_SendQueued();
+	sendQueue.active = false;
+#endif
+}
 
 /*
 ==================
@@ -748,42 +1044,29 @@ void Sys_SendPacket( int length, const void *data, const netadr_t& to )
 	{
 		if ( addr.ss_family == AF_INET )
 		{
+#ifdef NET_BATCHED_IO
+			if ( NET_QueuePacket( ip_socket, &addr, sizeof( struct sockaddr_in ), data, length, to.type ) )
+			{
+				return;
+			}
+#endif
 			ret = sendto( ip_socket, ( const char* )data, length, 0, ( struct sockaddr * ) &addr, sizeof( struct sockaddr_in ) );
 		}
 		else if ( addr.ss_family == AF_INET6 )
 		{
+#ifdef NET_BATCHED_IO
+			if ( NET_QueuePacket( ip6_socket, &addr, sizeof( struct sockaddr_in6 ), data, length, to.type ) )
+			{
+				return;
+			}
+#endif
 			ret = sendto( ip6_socket, ( const char* )data, length, 0, ( struct sockaddr * ) &addr, sizeof( struct sockaddr_in6 ) );
 		}
 	}
 
 	if ( ret == SOCKET_ERROR )
 	{
-		int err = socketError;
-
-		// wouldblock is silent
-		if ( err == net::errc::resource_unavailable_try_again )
-		{
-			return;
-		}
-
-		// some PPP links do not allow broadcasts and return an error
-		if ( ( err == net::errc::address_not_available ) && ( ( to.type == netadrtype_t::NA_BROADCAST ) ) )
-		{
-			return;
-		}
-
-		if ( addr.ss_family == AF_INET )
-		{
-			Log::Notice( "Sys_SendPacket (ipv4): %s", NET_ErrorString() );
-		}
-		else if ( addr.ss_family == AF_INET6 )
-		{
-			Log::Notice( "Sys_SendPacket (ipv6): %s", NET_ErrorString() );
-		}
-		else
-		{
-			Log::Notice( "Sys_SendPacket (%i): %s", addr.ss_family , NET_ErrorString() );
-		}
+		NET_SendError( socketError, addr.ss_family, to.type );
 	}
 }
 
@@ -1751,6 +2034,12 @@ void NET_DisableNetworking()
 
 	networkingEnabled = false;
 
+#ifdef NET_BATCHED_IO
+	// don't return datagrams of sockets that are closed, nor send to them
+	received.count = received.next = 0;
+	sendQueue.count = sendQueue.bytes = 0;
+#endif
+
 	if ( ip_socket != INVALID_SOCKET )
 	{
 		closesocket( ip_socket );
@@ -1827,27 +2116,57 @@ void NET_Shutdown()
 
 /*
 ====================
-NET_Sleep
+NET_SleepUntil
 
-Sleeps msec or until something happens on the network
+Sleeps until a packet arrives or the deadline is reached, with a better
+precision than a millisecond where possible. Returns true if it was woken
+up by a packet. Without any socket, sleeps until the deadline.
 ====================
 */
-void NET_Sleep( int msec )
+bool NET_SleepUntil( Sys::SteadyClock::time_point deadline )
 {
-	struct timeval timeout;
-
-	fd_set         fdset;
-	SOCKET         highestfd = INVALID_SOCKET;
-
 	if ( ip_socket == INVALID_SOCKET && ip6_socket == INVALID_SOCKET )
 	{
-		return;
+		Sys::SleepUntil( deadline );
+		return false;
 	}
 
-	if ( msec < 0 )
+#ifdef NET_BATCHED_IO
+	// datagrams that were already received don't wake the sockets up
+	if ( received.next < received.count )
 	{
-		return;
+		return true;
 	}
+#endif
+
+	auto wait = std::max( deadline - Sys::SteadyClock::now(), Sys::SteadyClock::duration::zero() );
+	auto nsec = std::chrono::duration_cast<std::chrono::nanoseconds>( wait ).count();
+
+#ifdef __linux__
+	struct pollfd   fds[ 2 ];
+	nfds_t          numfds = 0;
+	struct timespec timeout;
+
+	for ( SOCKET socket : { ip_socket, ip6_socket } )
+	{
+		if ( socket != INVALID_SOCKET )
+		{
+			fds[ numfds ].fd = socket;
+			fds[ numfds ].events = POLLIN;
+			fds[ numfds ].revents = 0;
+			numfds++;
+		}
+	}
+
+	timeout.tv_sec = nsec / 1000000000;
+	timeout.tv_nsec = nsec % 1000000000;
+
+	return ppoll( fds, numfds, &timeout, nullptr ) > 0;
+#else
+	struct timeval timeout;
+
+	fd_set         fdset;
+	SOCKET         highestfd = INVALID_SOCKET;
 
 	FD_ZERO( &fdset );
 
@@ -1868,9 +2187,36 @@ void NET_Sleep( int msec )
 		}
 	}
 
-	timeout.tv_sec = msec / 1000;
-	timeout.tv_usec = ( msec % 1000 ) * 1000;
-	select( highestfd + 1, &fdset, nullptr, nullptr, &timeout );
+	// round up, waking up early would make the caller spin
+	auto usec = ( nsec + 999 ) / 1000;
+
+	timeout.tv_sec = usec / 1000000;
+	timeout.tv_usec = usec % 1000000;
+
+	return select( highestfd + 1, &fdset, nullptr, nullptr, &timeout ) > 0;
+#endif
+}
+
+/*
+====================
+NET_Sleep
+
+Sleeps msec or until something happens on the network
+====================
+*/
+void NET_Sleep( int msec )
+{
+	if ( ip_socket == INVALID_SOCKET && ip6_socket == INVALID_SOCKET )
+	{
+		return;
+	}
+
+	if ( msec < 0 )
+	{
+		return;
+	}
+
+	NET_SleepUntil( Sys::SteadyClock::now() + std::chrono::milliseconds( msec ) );
 }
 
 /*
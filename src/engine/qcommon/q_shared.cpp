@@ -301,9 +301,10 @@ static const char *punctuation[] =
 	nullptr
 };
 
-static char com_token[ MAX_TOKEN_CHARS ];
-static char com_parsename[ MAX_TOKEN_CHARS ];
-static int  com_lines;
+// The engine tokenizes text on several threads, e.g. the shader files
+static ENGINE_THREAD_LOCAL char com_token[ MAX_TOKEN_CHARS ];
+static ENGINE_THREAD_LOCAL char com_parsename[ MAX_TOKEN_CHARS ];
+static ENGINE_THREAD_LOCAL int  com_lines;
 
 void COM_BeginParseSession( const char *name )
 {
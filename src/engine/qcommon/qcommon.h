@@ -65,6 +65,7 @@ struct usercmd_t;
 struct entityState_t;
 
 void  MSG_WriteBits( msg_t *msg, int value, int bits );
+void  MSG_WriteBitstream( msg_t *msg, const byte *data, int bits, int uncompsize );
 
 void  MSG_WriteChar( msg_t *sb, int c );
 void  MSG_WriteByte( msg_t *sb, int c );
@@ -98,6 +99,7 @@ void  MSG_ReadDeltaEntity( msg_t *msg, const entityState_t *from, entityState_t
 void MSG_InitNetcodeTables(NetcodeTable playerStateTable, int playerStateSize);
 void  MSG_WriteDeltaPlayerstate( msg_t *msg, OpaquePlayerState *from, OpaquePlayerState *to );
 void  MSG_ReadDeltaPlayerstate( msg_t *msg, OpaquePlayerState *from, OpaquePlayerState *to );
+void  MSG_FlushFieldUses();
 
 //============================================================================
 
@@ -153,6 +155,8 @@ void       NET_EnableNetworking( bool serverMode );
 void       NET_DisableNetworking();
 
 void       NET_SendPacket( netsrc_t sock, int length, const void *data, const netadr_t& to );
+void       NET_BeginSendBatch();
+void       NET_FlushSendBatch();
 
 bool   NET_CompareAdr( const netadr_t& a, const netadr_t& b );
 bool   NET_CompareBaseAdr( const netadr_t& a, const netadr_t& b );
@@ -165,6 +169,7 @@ void       NET_JoinMulticast6();
 void       NET_LeaveMulticast6();
 
 void       NET_Sleep( int msec );
+bool       NET_SleepUntil( Sys::SteadyClock::time_point deadline );
 
 //----(SA)  increased for larger submodel entity counts
 #define MAX_MSGLEN           32768 // max length of a message, which may
@@ -666,6 +671,7 @@ void     SV_QuickShutdown( const char *finalmsg );
 void     SV_Frame( int msec );
 void     SV_PacketEvent( const netadr_t& from, msg_t *msg );
 int      SV_FrameMsec();
+void     SV_RecordFrameLateness( Sys::SteadyClock::duration lateness );
 
 /*
 ==============================================================
@@ -765,5 +771,27 @@ void             Huff_offsetTransmit( huff_t *huff, int ch, byte *fout, int *off
 void             Huff_putBit( int bit, byte *fout, int *offset );
 int              Huff_getBit( byte *fout, int *offset );
 
+// number of bits decoded with a single lookup by Huff_tableReceive
+#define HUFF_LOOKUP_BITS 12
+
+// the codes of a tree that is not updated anymore, flattened into tables so
+// that symbols can be sent and received without walking the tree bit by bit
+struct huffTable_t
+{
+    huff_t   *huff;
+
+    uint32_t code[ HMAX + 1 ]; // first bit sent in the lowest bit
+    byte     length[ HMAX + 1 ]; // 0 if the tree has to be walked
+
+    // symbol and code length for each value of the next HUFF_LOOKUP_BITS
+    // bits of a message, a length of 0 if the tree has to be walked
+    uint16_t lookupSymbol[ 1 << HUFF_LOOKUP_BITS ];
+    byte     lookupLength[ 1 << HUFF_LOOKUP_BITS ];
+};
+
+void             Huff_BuildTable( huffTable_t *table, huff_t *huff );
+void             Huff_tableTransmit( const huffTable_t *table, int ch, byte *fout, int *offset );
+void             Huff_tableReceive( const huffTable_t *table, int *ch, byte *fin, int size, int *offset );
+
 void Trans_LoadDefaultLanguage();
 #endif // QCOMMON_H_
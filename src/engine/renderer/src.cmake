@@ -30,11 +30,13 @@ set(RENDERERLIST
     ${ENGINE_DIR}/renderer/TextureManager.h
     ${ENGINE_DIR}/renderer/tr_image.cpp
     ${ENGINE_DIR}/renderer/tr_image.h
+    ${ENGINE_DIR}/renderer/tr_image_cache.cpp
     ${ENGINE_DIR}/renderer/tr_image_crn.cpp
     ${ENGINE_DIR}/renderer/tr_image_dds.cpp
     ${ENGINE_DIR}/renderer/tr_image_jpg.cpp
     ${ENGINE_DIR}/renderer/tr_image_ktx.cpp
     ${ENGINE_DIR}/renderer/tr_image_png.cpp
+    ${ENGINE_DIR}/renderer/tr_image_streaming.cpp
     ${ENGINE_DIR}/renderer/tr_image_tga.cpp
     ${ENGINE_DIR}/renderer/tr_image_webp.cpp
     ${ENGINE_DIR}/renderer/tr_init.cpp
@@ -53,8 +55,10 @@ set(RENDERERLIST
     ${ENGINE_DIR}/renderer/tr_scene.cpp
     ${ENGINE_DIR}/renderer/tr_shade.cpp
     ${ENGINE_DIR}/renderer/tr_shader.cpp
+    ${ENGINE_DIR}/renderer/tr_shader_text.h
     ${ENGINE_DIR}/renderer/tr_shade_calc.cpp
     ${ENGINE_DIR}/renderer/tr_skin.cpp
+    ${ENGINE_DIR}/renderer/tr_skinning.h
     ${ENGINE_DIR}/renderer/tr_sky.cpp
     ${ENGINE_DIR}/renderer/tr_surface.cpp
     ${ENGINE_DIR}/renderer/tr_types.h
@@ -69,4 +73,6 @@ set(RENDERERLIST
 
 set(RENDERERTESTLIST
     ${ENGINE_DIR}/renderer/gl_shader_test.cpp
+    ${ENGINE_DIR}/renderer/tr_shader_text_test.cpp
+    ${ENGINE_DIR}/renderer/tr_skinning_test.cpp
 )
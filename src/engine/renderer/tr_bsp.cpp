@@ -584,7 +584,20 @@ static void R_LoadLightmaps( lump_t *l, const char *bspName )
 			// we are about to upload textures
 			R_SyncRenderThread();
 
+			size_t batchSize = R_ImagePrefetchBatchSize();
+
 			for (size_t i = 0; i < lightmapFiles.size(); i++) {
+				// decode the next few lightmaps on the image loading threads
+				if (batchSize && i % batchSize == 0) {
+					R_DiscardPrefetchedImages();
+
+					std::vector<std::string> batch;
+					for (size_t j = i; j < std::min(i + batchSize, lightmapFiles.size()); j++) {
+						batch.push_back(Str::Format("%s/%s", mapName, lightmapFiles[j]));
+					}
+					R_PrefetchImages(batch);
+				}
+
 				Log::Debug("...loading external lightmap '%s/%s'", mapName, lightmapFiles[i]);
 
 				if (!tr.worldDeluxeMapping || i % 2 == 0) {
@@ -607,6 +620,8 @@ static void R_LoadLightmaps( lump_t *l, const char *bspName )
 					tr.deluxemaps.push_back( image );
 				}
 			}
+
+			R_DiscardPrefetchedImages();
 		}
 	} else {
 		len = l->filelen;
@@ -2809,6 +2824,75 @@ static void R_CreateWorldVBO() {
 R_LoadSurfaces
 ===============
 */
+/*
+=================
+R_PreloadSurfaceShaders
+
+Registers the shaders of the surfaces in the order the surface parsers
+would, with their images decoded beforehand by the image loading threads.
+It goes a batch of images at a time, so that few decoded images are held
+at once while the main thread uploads them.
+=================
+*/
+static void R_PreloadSurfaceShaders( const dsurface_t *in, int count )
+{
+	size_t batchSize = R_ImagePrefetchBatchSize();
+
+	if ( !batchSize )
+	{
+		return;
+	}
+
+	std::vector<bool> seen( s_worldData.numShaders );
+	std::vector<const char *> shaderNames;
+
+	for ( int i = 0; i < count; i++ )
+	{
+		int shaderNum = LittleLong( in[ i ].shaderNum );
+
+		switch ( LittleLong( in[ i ].surfaceType ) )
+		{
+			case mapSurfaceType_t::MST_PATCH:
+			case mapSurfaceType_t::MST_TRIANGLE_SOUP:
+			case mapSurfaceType_t::MST_PLANAR:
+			case mapSurfaceType_t::MST_FOLIAGE:
+				break;
+
+			default:
+				continue;
+		}
+
+		// bad numbers are reported by ShaderForShaderNum
+		if ( shaderNum >= 0 && shaderNum < s_worldData.numShaders && !seen[ shaderNum ] )
+		{
+			seen[ shaderNum ] = true;
+			shaderNames.push_back( s_worldData.shaders[ shaderNum ].shader );
+		}
+	}
+
+	size_t next = 0;
+
+	while ( next < shaderNames.size() )
+	{
+		std::vector<std::string> imageNames;
+		size_t end = next;
+
+		while ( end < shaderNames.size() && imageNames.size() < batchSize )
+		{
+			R_GetShaderImageNames( shaderNames[ end++ ], imageNames );
+		}
+
+		R_PrefetchImages( imageNames );
+
+		for ( ; next < end; next++ )
+		{
+			R_FindShader( shaderNames[ next ], RSF_3D );
+		}
+
+		R_DiscardPrefetchedImages();
+	}
+}
+
 static void R_LoadSurfaces( lump_t *surfs, lump_t *verts, lump_t *indexLump )
 {
 	dsurface_t   *in;
@@ -2855,6 +2939,8 @@ static void R_LoadSurfaces( lump_t *surfs, lump_t *verts, lump_t *indexLump )
 	s_worldData.surfaces = out;
 	s_worldData.numSurfaces = count;
 
+	R_PreloadSurfaceShaders( in, count );
+
 	for ( i = 0; i < count; i++, in++, out++ )
 	{
 		switch ( LittleLong( in->surfaceType ) )
@@ -4661,6 +4747,10 @@ void RE_LoadWorldMap( const char *name )
 
 	Log::Debug("----- RE_LoadWorldMap( %s ) -----", name );
 
+	// only report the images and shaders of this map
+	R_ResetImageLoadStats();
+	R_ResetShaderLoadStats();
+
 	// set default sun direction to be used if it isn't
 	// overridden by a shader
 	tr.sunDirection[ 0 ] = 0.45f;
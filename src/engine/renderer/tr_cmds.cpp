@@ -591,7 +591,7 @@ void RE_2DPolyies( polyVert_t *verts, int numverts, qhandle_t hShader )
 	r_numPolyVerts += numverts;
 }
 
-void RE_2DPolyiesIndexed( polyVert_t *verts, int numverts, int *indexes, int numindexes, int trans_x, int trans_y, qhandle_t hShader )
+void RE_2DPolyiesIndexed( const polyVert_t *verts, int numverts, const int *indexes, int numindexes, int trans_x, int trans_y, qhandle_t hShader )
 {
 	Poly2dIndexedCommand *cmd;
 
@@ -797,6 +797,8 @@ void RE_BeginFrame()
 		GL_CheckErrors_( __FILE__, __LINE__ );
 	}
 
+	R_UpdateTextureStreaming();
+
 	// draw buffer stuff
 	cmd = R_GetRenderCommand<DrawBufferCommand>();
 
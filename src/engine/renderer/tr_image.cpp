@@ -26,10 +26,18 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "tr_local.h"
 #include <iomanip>
 #include "Material.h"
+#include "framework/WorkerPool.h"
 
 static Cvar::Cvar<bool> r_allowImageParamMismatch(
 	"r_allowImageParamMismatch", "reuse images when requested with different parameters",
 	Cvar::NONE, false);
+static Cvar::Range<Cvar::Cvar<int>> r_imageLoadThreads( "r_imageLoadThreads",
+	"number of worker threads decoding the images of a map ahead of their upload, 0 to decode them when uploading",
+	Cvar::NONE, 4, 0, 64 );
+
+static Log::Logger imageLoadLog( "renderer.imageLoad", "", Log::Level::NOTICE );
+
+static Sys::WorkerPool imageWorkers( "image loading" );
 
 int                  gl_filter_min = GL_LINEAR_MIPMAP_NEAREST;
 int                  gl_filter_max = GL_LINEAR;
@@ -875,6 +883,23 @@ void R_UploadImage( const char *name, const byte **dataArray, int numLayers, int
 	int customScalingStep = R_GetImageCustomScalingStep( image, imageParams );
 	R_DownscaleImageDimensions( customScalingStep, &scaledWidth, &scaledHeight, &dataArray, numLayers, &numMips );
 
+	// texture streaming starts with a low resolution placeholder
+	int streamingStep = R_GetImageStreamingStep( image, scaledWidth, scaledHeight );
+
+	if ( streamingStep > 0 )
+	{
+		// compressed images can only skip their precomputed mips, others are resampled
+		if ( IsImageCompressed( image->bits ) )
+		{
+			R_DownscaleImageDimensions( streamingStep, &scaledWidth, &scaledHeight, &dataArray, numLayers, &numMips );
+		}
+		else
+		{
+			scaledWidth = std::max( 1, scaledWidth >> streamingStep );
+			scaledHeight = std::max( 1, scaledHeight >> streamingStep );
+		}
+	}
+
 	// clamp to the current upper OpenGL limit
 	// scale both axis down equally so we don't have to
 	// deal with a half mip resampling
@@ -1623,20 +1648,21 @@ struct imageExtLoader_t
 	const char *name;
 	imageLoader_t imageLoader;
 	bool cubemap;
+	bool cache; // decoding is slower than reading the result back
 };
 
 /* The ordering indicates the order of preference used when
 there are multiple images of different formats available. */
 static const imageExtLoader_t imageLoaders[] =
 {
-	{ "webp", "WebP", LoadWEBP, false },
-	{ "png",  "PNG",  LoadPNG,  false },
-	{ "tga",  "TGA",  LoadTGA,  false },
-	{ "jpg",  "JPEG", LoadJPG,  false },
-	{ "jpeg", "JPEG", LoadJPG,  false },
-	{ "dds",  "DDS",  LoadDDS,  false },
-	{ "crn",  "CRN",  LoadCRN,  true  },
-	{ "ktx",  "KTX",  LoadKTX,  true  },
+	{ "webp", "WebP", LoadWEBP, false, true  },
+	{ "png",  "PNG",  LoadPNG,  false, true  },
+	{ "tga",  "TGA",  LoadTGA,  false, false },
+	{ "jpg",  "JPEG", LoadJPG,  false, true  },
+	{ "jpeg", "JPEG", LoadJPG,  false, true  },
+	{ "dds",  "DDS",  LoadDDS,  false, false },
+	{ "crn",  "CRN",  LoadCRN,  true,  true  },
+	{ "ktx",  "KTX",  LoadKTX,  true,  false },
 };
 
 /*
@@ -1698,11 +1724,28 @@ bool R_HasImageLoader( const char *baseName ) {
 static void R_LoadImageWithLoader( const char* fileName, const char* altName, const imageExtLoader_t *loader, byte **pic, int *width, int *height, int *numLayers, int *numMips, int *bits, byte alphaByte )
 {
 	Log::Debug( "Found %s image candidate '%s': %s", loader->name, fileName, altName );
+
+	// homepath images are not in a pak, so there would be no way to tell their versions apart
+	bool cache = loader->cache && !( *bits & IF_HOMEPATH );
+
+	if ( cache && R_ReadImageCache( altName, pic, width, height, numMips, bits ) )
+	{
+		*numLayers = 0;
+		Log::Debug( "Found %d×%d %s image '%s' in the cache: %s", *width, *height, loader->name, fileName, altName );
+		return;
+	}
+
+	int loaderBits = *bits;
 	loader->imageLoader( altName, pic, width, height, numLayers, numMips, bits, alphaByte );
 
 	if ( *pic )
 	{
 		Log::Debug("Found %d×%d %s image '%s': %s", *width, *height, loader->name, fileName, altName );
+
+		if ( cache && *numLayers == 0 )
+		{
+			R_WriteImageCache( altName, pic, *width, *height, *numMips, *bits & ~loaderBits );
+		}
 	}
 }
 
@@ -1791,6 +1834,194 @@ static void R_LoadImage( const char *name, byte **pic, int *width, int *height,
 	}
 }
 
+// An image decoded by R_PrefetchImages, waiting for R_FindImageFile to upload it
+struct prefetchedImage_t
+{
+	std::vector<byte *> pic; // empty if the image could not be decoded
+	int width, height, numMips, bits;
+};
+
+static std::unordered_map<std::string, prefetchedImage_t, Str::IHash, Str::IEqual> prefetchedImages;
+
+// Decoding work since the last R_ResetImageLoadStats
+static struct
+{
+	std::atomic<int> numDecoded;
+	std::atomic<int64_t> decodeTime; // in nanoseconds, summed over all the threads
+	int numPrefetched;
+	int numUnused;
+	Sys::SteadyClock::duration prefetchTime;
+} imageLoadStats;
+
+void R_DecodeImage( const char *name, byte **pic, int *width, int *height,
+			 int *numLayers, int *numMips, int *bits )
+{
+	Sys::SteadyClock::time_point start = Sys::SteadyClock::now();
+
+	R_LoadImage( name, pic, width, height, numLayers, numMips, bits );
+
+	imageLoadStats.decodeTime += std::chrono::duration_cast<std::chrono::nanoseconds>( Sys::SteadyClock::now() - start ).count();
+
+	if ( *pic )
+	{
+		imageLoadStats.numDecoded++;
+	}
+}
+
+static bool R_IsImageLoaded( const char *name )
+{
+	for ( image_t *image = r_imageHashTable[ GenerateImageHashValue( name ) ]; image; image = image->next )
+	{
+		if ( !Q_strnicmp( name, image->name, sizeof( image->name ) ) )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+===============
+R_ImagePrefetchBatchSize
+
+How many images to hand to R_PrefetchImages at once, enough to keep the
+image loading threads busy without holding too many decoded images.
+Returns 0 when images are not decoded ahead of their upload.
+==============
+*/
+int R_ImagePrefetchBatchSize()
+{
+	int numThreads = r_imageLoadThreads.Get();
+
+	return numThreads ? 4 * ( numThreads + 1 ) : 0;
+}
+
+/*
+===============
+R_PrefetchImages
+
+Decodes the given image files on the image loading threads, so that a
+following R_FindImageFile of the same name only has to upload it.
+Images that are already loaded or prefetched are skipped.
+==============
+*/
+void R_PrefetchImages( const std::vector<std::string> &imageNames )
+{
+	std::vector<std::pair<const std::string, prefetchedImage_t> *> jobs;
+
+	for ( const std::string &name : imageNames )
+	{
+		if ( name.empty() || R_IsImageLoaded( name.c_str() ) )
+		{
+			continue;
+		}
+
+		auto inserted = prefetchedImages.emplace( name, prefetchedImage_t() );
+
+		if ( inserted.second )
+		{
+			jobs.push_back( &*inserted.first );
+		}
+	}
+
+	if ( jobs.empty() )
+	{
+		return;
+	}
+
+	Sys::SteadyClock::time_point start = Sys::SteadyClock::now();
+
+	imageWorkers.SetNumThreads( r_imageLoadThreads.Get() );
+
+	try
+	{
+		imageWorkers.ParallelFor( jobs.size(), [&jobs]( int i ) {
+			prefetchedImage_t &image = jobs[ i ]->second;
+			int numLayers = 0;
+			byte *pic[ MAX_TEXTURE_MIPS * MAX_TEXTURE_LAYERS ];
+			pic[ 0 ] = nullptr;
+
+			image.width = image.height = image.numMips = image.bits = 0;
+			R_DecodeImage( jobs[ i ]->first.c_str(), pic, &image.width, &image.height, &numLayers, &image.numMips, &image.bits );
+
+			if ( !*pic )
+			{
+				return;
+			}
+
+			// R_FindImageFile rejects those anyway
+			if ( numLayers > 0 )
+			{
+				Z_Free( *pic );
+				return;
+			}
+
+			image.pic.assign( pic, pic + std::max( image.numMips, 1 ) );
+		} );
+	}
+	catch ( ... )
+	{
+		R_DiscardPrefetchedImages();
+		throw;
+	}
+
+	imageLoadStats.numPrefetched += jobs.size();
+	imageLoadStats.prefetchTime += Sys::SteadyClock::now() - start;
+}
+
+/*
+===============
+R_DiscardPrefetchedImages
+
+Frees the prefetched images that nobody asked for.
+==============
+*/
+void R_DiscardPrefetchedImages()
+{
+	for ( auto &entry : prefetchedImages )
+	{
+		if ( !entry.second.pic.empty() )
+		{
+			Z_Free( entry.second.pic[ 0 ] );
+			imageLoadStats.numUnused++;
+		}
+	}
+
+	prefetchedImages.clear();
+}
+
+/*
+===============
+R_ResetImageLoadStats
+==============
+*/
+void R_ResetImageLoadStats()
+{
+	imageLoadStats.numDecoded = 0;
+	imageLoadStats.decodeTime = 0;
+	imageLoadStats.numPrefetched = 0;
+	imageLoadStats.numUnused = 0;
+	imageLoadStats.prefetchTime = {};
+}
+
+/*
+===============
+R_PrintImageLoadStats
+
+Reports the time spent decoding images since the last R_ResetImageLoadStats.
+==============
+*/
+void R_PrintImageLoadStats( const char *mapName )
+{
+	using ms = std::chrono::duration<float, std::milli>;
+
+	imageLoadLog.Notice( "%s: decoded %d images in %.1f ms, %d of them ahead of their upload in %.1f ms with %d threads (%d unused)",
+		mapName, imageLoadStats.numDecoded.load(), imageLoadStats.decodeTime.load() * 1e-6f,
+		imageLoadStats.numPrefetched, ms( imageLoadStats.prefetchTime ).count(),
+		imageWorkers.GetNumThreads(), imageLoadStats.numUnused );
+}
+
 /*
 ===============
 R_FindImageFile
@@ -1870,7 +2101,23 @@ image_t *R_FindImageFile( const char *imageName, imageParams_t &imageParams )
 	byte *pic[ MAX_TEXTURE_MIPS * MAX_TEXTURE_LAYERS ];
 	pic[ 0 ] = nullptr;
 
-	R_LoadImage( imageName, pic, &width, &height, &numLayers, &numMips, &imageParams.bits );
+	auto prefetched = prefetchedImages.find( imageName );
+
+	if ( prefetched != prefetchedImages.end() )
+	{
+		const prefetchedImage_t &image = prefetched->second;
+		std::copy( image.pic.begin(), image.pic.end(), pic );
+		width = image.width;
+		height = image.height;
+		numMips = image.numMips;
+		imageParams.bits |= image.bits;
+
+		prefetchedImages.erase( prefetched );
+	}
+	else
+	{
+		R_DecodeImage( imageName, pic, &width, &height, &numLayers, &numMips, &imageParams.bits );
+	}
 
 	if ( *pic )
 	{
@@ -1890,6 +2137,11 @@ image_t *R_FindImageFile( const char *imageName, imageParams_t &imageParams )
 		R_ProcessLightmap( *pic, width, height, imageParams.bits );
 	}
 
+	if ( R_IsImageStreamable( width, height, numMips, imageParams ) )
+	{
+		imageParams.bits |= IF_STREAMED;
+	}
+
 	image_t *image = R_CreateImage( imageName, (const byte **)pic, width, height, numMips, imageParams );
 	image->initialParams = initialParams;
 
@@ -2161,7 +2413,7 @@ image_t *R_FindCubeImage( const char *name, imageParams_t &imageParams )
 	// Look for cached 6-face cube map file.
 	if ( imageParams.bits & IF_HOMEPATH )
 	{
-		static const imageExtLoader_t loader = { "ktx", "KTX", LoadKTX, true };
+		static const imageExtLoader_t loader = { "ktx", "KTX", LoadKTX, true, false };
 		std::string altName = Str::Format( "%s.%s", name, loader.ext );
 
 		Log::Debug( "Looking for cached %s cube map '%s' candidate: %s", loader.name, name, altName );
@@ -2783,6 +3035,9 @@ void R_ShutdownImages()
 {
 	Log::Debug("------- R_ShutdownImages -------" );
 
+	R_DiscardPrefetchedImages();
+	R_ShutdownTextureStreaming();
+
 	for ( image_t *image : tr.images )
 	{
 		if ( image->texture->IsResident() ) {
@@ -0,0 +1,349 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+// tr_image_cache.cpp -- keeps decoded images in the homepath so they don't have to be decoded again
+
+#include "tr_local.h"
+
+static Cvar::Cvar<bool> r_imageCache(
+	"r_imageCache", "cache decoded images in the homepath", Cvar::NONE, true );
+
+static Log::Logger imageCacheLog( "renderer.imageCache" );
+
+static const uint32_t IMAGE_CACHE_MAGIC = 0x494d4344; // "DCMI"
+static const uint32_t IMAGE_CACHE_VERSION = 1;
+
+// The format bits the image loaders add, the only ones a cache file carries
+static const int IMAGE_CACHE_FORMAT_BITS = IF_BC1 | IF_BC2 | IF_BC3 | IF_BC4 | IF_BC5;
+
+/* The header is followed by the key of the source file, then by the
+image data as the loader returned it: one block in which each mip starts
+at its offset. */
+struct imageCacheHeader_t
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t keyLength;
+	uint32_t dataSize;
+	int32_t width;
+	int32_t height;
+	int32_t numMips;
+	int32_t bits; // format bits added by the loader
+	uint32_t mipOffsets[ MAX_TEXTURE_MIPS ];
+};
+
+static std::string R_ImageCachePath( const char *fileName )
+{
+	return Str::Format( "cache/images/%s.bin", fileName );
+}
+
+/*
+===============
+R_ImageCacheKey
+
+Identifies the version of a source image, from the pak it comes from.
+Returns an empty string for files that are not in a pak.
+===============
+*/
+static std::string R_ImageCacheKey( const char *fileName )
+{
+	const FS::LoadedPakInfo *pak = FS::PakPath::LocateFile( fileName );
+
+	if ( !pak )
+	{
+		return "";
+	}
+
+	// Directory paks have no checksum, and their files can change at any time
+	std::error_code err;
+	auto timestamp = FS::PakPath::FileTimestamp( fileName, err ).time_since_epoch().count();
+
+	if ( err )
+	{
+		return "";
+	}
+
+	return Str::Format( "%s %s %08x %d", pak->name, pak->version, pak->realChecksum ? *pak->realChecksum : 0, timestamp );
+}
+
+/*
+===============
+R_ImageMipOffsets
+
+Computes where each mip of a decoded image starts when they are packed
+in one block, and returns the size of the block, or 0 if the image has
+no such layout or is too big for the cache.
+===============
+*/
+static uint32_t R_ImageMipOffsets( int width, int height, int numMips, int bits, uint32_t *mipOffsets )
+{
+	if ( width <= 0 || height <= 0 || numMips < 0 || numMips > MAX_TEXTURE_MIPS )
+	{
+		return 0;
+	}
+
+	if ( !IsImageCompressed( bits ) )
+	{
+		uint64_t size = uint64_t( width ) * height * 4;
+
+		if ( numMips > 1 || size > UINT32_MAX )
+		{
+			return 0;
+		}
+
+		mipOffsets[ 0 ] = 0;
+		return size;
+	}
+
+	int blockSize = bits & ( IF_BC1 | IF_BC4 ) ? 8 : 16;
+	uint64_t size = 0;
+
+	for ( int i = 0; i < std::max( numMips, 1 ); i++ )
+	{
+		mipOffsets[ i ] = size;
+		size += uint64_t( ( width + 3 ) >> 2 ) * ( ( height + 3 ) >> 2 ) * blockSize;
+		width = std::max( width >> 1, 1 );
+		height = std::max( height >> 1, 1 );
+
+		if ( size > UINT32_MAX )
+		{
+			return 0;
+		}
+	}
+
+	return size;
+}
+
+/*
+===============
+R_ImageDataSize
+
+Size of the block holding the mips of a decoded image, or 0 if its layout
+is not one that can be cached.
+===============
+*/
+static uint32_t R_ImageDataSize( byte **pic, int width, int height, int numMips, int bits )
+{
+	uint32_t mipOffsets[ MAX_TEXTURE_MIPS ];
+	uint32_t size = R_ImageMipOffsets( width, height, numMips, bits, mipOffsets );
+
+	for ( int i = 0; size && i < std::max( numMips, 1 ); i++ )
+	{
+		if ( pic[ i ] != pic[ 0 ] + mipOffsets[ i ] )
+		{
+			return 0;
+		}
+	}
+
+	return size;
+}
+
+/*
+===============
+R_ReadImageCache
+
+Loads a decoded image from the cache, if it was made from the same
+version of the source file. Can be called from any thread.
+===============
+*/
+bool R_ReadImageCache( const char *fileName, byte **pic, int *width, int *height, int *numMips, int *bits )
+{
+	if ( !r_imageCache.Get() )
+	{
+		return false;
+	}
+
+	std::string key = R_ImageCacheKey( fileName );
+
+	if ( key.empty() )
+	{
+		return false;
+	}
+
+	std::string path = R_ImageCachePath( fileName );
+	std::error_code err;
+	FS::File file = FS::HomePath::OpenRead( path, err );
+
+	if ( err )
+	{
+		return false;
+	}
+
+	imageCacheHeader_t header;
+	std::string fileKey;
+
+	if ( file.Read( &header, sizeof( header ), err ) != sizeof( header ) || err
+	     || header.magic != IMAGE_CACHE_MAGIC || header.version != IMAGE_CACHE_VERSION
+	     || header.keyLength != key.size() )
+	{
+		imageCacheLog.Verbose( "Image cache %s is out of date", path );
+		return false;
+	}
+
+	// The data must be laid out exactly as R_WriteImageCache would write it
+	// for these dimensions and format, which is at most one of the formats
+	uint32_t mipOffsets[ MAX_TEXTURE_MIPS ];
+	uint32_t dataSize = R_ImageMipOffsets( header.width, header.height, header.numMips, header.bits, mipOffsets );
+
+	if ( ( header.bits & ~IMAGE_CACHE_FORMAT_BITS ) || ( header.bits & ( header.bits - 1 ) )
+	     || !dataSize || dataSize != header.dataSize )
+	{
+		imageCacheLog.Verbose( "Image cache %s is corrupt", path );
+		return false;
+	}
+
+	for ( int i = 0; i < header.numMips; i++ )
+	{
+		if ( header.mipOffsets[ i ] != mipOffsets[ i ] )
+		{
+			imageCacheLog.Verbose( "Image cache %s is corrupt", path );
+			return false;
+		}
+	}
+
+	fileKey.resize( header.keyLength );
+
+	if ( file.Read( &fileKey[ 0 ], fileKey.size(), err ) != fileKey.size() || err || fileKey != key )
+	{
+		imageCacheLog.Verbose( "Image cache %s is out of date", path );
+		return false;
+	}
+
+	FS::offset_t length = file.Length( err );
+
+	if ( err || length < 0 || uint64_t( length ) != sizeof( header ) + header.keyLength + header.dataSize )
+	{
+		imageCacheLog.Verbose( "Image cache %s has the wrong size", path );
+		return false;
+	}
+
+	byte *data = ( byte * ) Z_Malloc( header.dataSize );
+
+	if ( file.Read( data, header.dataSize, err ) != header.dataSize || err )
+	{
+		imageCacheLog.Verbose( "Image cache %s could not be read", path );
+		Z_Free( data );
+		return false;
+	}
+
+	pic[ 0 ] = data;
+
+	for ( int i = 1; i < header.numMips; i++ )
+	{
+		pic[ i ] = data + header.mipOffsets[ i ];
+	}
+
+	*width = header.width;
+	*height = header.height;
+	*numMips = header.numMips;
+	*bits |= header.bits & IMAGE_CACHE_FORMAT_BITS;
+
+	return true;
+}
+
+/*
+===============
+R_WriteImageCache
+
+Saves an image as its loader decoded it, bits being the format bits the
+loader added. Images whose data is not in the expected layout are skipped.
+Can be called from any thread.
+===============
+*/
+void R_WriteImageCache( const char *fileName, byte **pic, int width, int height, int numMips, int bits )
+{
+	if ( !r_imageCache.Get() )
+	{
+		return;
+	}
+
+	std::string key = R_ImageCacheKey( fileName );
+	uint32_t dataSize = R_ImageDataSize( pic, width, height, numMips, bits );
+
+	if ( key.empty() || !dataSize )
+	{
+		return;
+	}
+
+	imageCacheHeader_t header{};
+	header.magic = IMAGE_CACHE_MAGIC;
+	header.version = IMAGE_CACHE_VERSION;
+	header.keyLength = key.size();
+	header.dataSize = dataSize;
+	header.width = width;
+	header.height = height;
+	header.numMips = numMips;
+	header.bits = bits & IMAGE_CACHE_FORMAT_BITS;
+
+	for ( int i = 0; i < numMips; i++ )
+	{
+		header.mipOffsets[ i ] = pic[ i ] - pic[ 0 ];
+	}
+
+	// The same image may be decoded by several threads at once
+	std::string path = R_ImageCachePath( fileName );
+	std::string tempPath = Str::Format( "%s.%x.tmp", path, std::hash<std::thread::id>()( std::this_thread::get_id() ) );
+	std::error_code err;
+	{
+		FS::File file = FS::HomePath::OpenWrite( tempPath, err );
+
+		if ( !err )
+		{
+			file.Write( &header, sizeof( header ), err );
+		}
+
+		if ( !err )
+		{
+			file.Write( key.data(), key.size(), err );
+		}
+
+		if ( !err )
+		{
+			file.Write( pic[ 0 ], dataSize, err );
+		}
+
+		if ( !err )
+		{
+			file.Close( err );
+		}
+	}
+
+	if ( !err )
+	{
+		FS::HomePath::MoveFile( path, tempPath, err );
+	}
+
+	if ( err )
+	{
+		imageCacheLog.Verbose( "Could not write the image cache %s: %s", path, err.message() );
+
+		std::error_code deleteErr;
+		FS::HomePath::DeleteFile( tempPath, deleteErr );
+	}
+}
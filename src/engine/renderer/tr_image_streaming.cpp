@@ -0,0 +1,539 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+// tr_image_streaming.cpp -- uploads placeholders of large images and streams their full resolution when they are seen
+
+#include "tr_local.h"
+
+static Cvar::Cvar<bool> r_textureStreaming( "r_textureStreaming",
+	"upload low resolution placeholders of newly loaded images, and load their full resolution in the background once they are seen",
+	Cvar::NONE, false );
+static Cvar::Range<Cvar::Cvar<int>> r_textureStreamingBudget( "r_textureStreamingBudget",
+	"video memory in MiB for the full resolution of streamed images, least recently seen ones go back to their placeholder beyond it, 0 for no limit",
+	Cvar::NONE, 1024, 0, 1 << 20 );
+static Cvar::Range<Cvar::Cvar<int>> r_textureStreamingPlaceholderSize( "r_textureStreamingPlaceholderSize",
+	"largest dimension of the placeholders of streamed images",
+	Cvar::NONE, 64, 1, 4096 );
+static Cvar::Range<Cvar::Cvar<int>> r_textureStreamingUploads( "r_textureStreamingUploads",
+	"maximum number of streamed images uploaded per frame",
+	Cvar::NONE, 4, 1, 256 );
+
+static Log::Logger streamingLog( "renderer.textureStreaming" );
+
+// Images have to be unseen for that many frames before being evicted, so
+// that looking around doesn't make them go back and forth
+static const int EVICTION_DELAY = 100;
+
+struct streamRequest_t
+{
+	image_t *image;
+	std::string name;
+};
+
+struct streamResult_t
+{
+	streamRequest_t request;
+	std::vector<byte *> pic; // empty if the image could not be decoded
+	int width, height, numMips;
+};
+
+// Decodes the requested images on its own thread, the main thread uploads them
+static struct
+{
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool quit = false;
+	std::deque<streamRequest_t> requests;
+	std::deque<streamResult_t> results;
+} streamer;
+
+// Images seen at placeholder resolution during the last frame
+static std::vector<image_t *> wantedImages;
+
+// Estimated memory of the full resolution images, including the ones being decoded
+static size_t residentBytes = 0;
+
+static void R_StreamingThread()
+{
+	while ( true )
+	{
+		streamResult_t result;
+
+		{
+			std::unique_lock<std::mutex> lock( streamer.mutex );
+			streamer.wake.wait( lock, [] { return streamer.quit || !streamer.requests.empty(); } );
+
+			if ( streamer.quit )
+			{
+				return;
+			}
+
+			result.request = std::move( streamer.requests.front() );
+			streamer.requests.pop_front();
+		}
+
+		int numLayers = 0, bits = 0;
+		byte *pic[ MAX_TEXTURE_MIPS * MAX_TEXTURE_LAYERS ];
+		pic[ 0 ] = nullptr;
+		result.width = result.height = result.numMips = 0;
+
+		try
+		{
+			R_DecodeImage( result.request.name.c_str(), pic, &result.width, &result.height, &numLayers, &result.numMips, &bits );
+		}
+		catch ( Sys::DropErr &err )
+		{
+			Log::Warn( "Could not stream image '%s': %s", result.request.name, err.what() );
+		}
+		catch ( std::exception &err )
+		{
+			Log::Warn( "Could not stream image '%s': %s", result.request.name, err.what() );
+		}
+		catch ( ... )
+		{
+			Log::Warn( "Could not stream image '%s'", result.request.name );
+		}
+
+		if ( *pic )
+		{
+			result.pic.assign( pic, pic + std::max( result.numMips, 1 ) );
+		}
+
+		std::lock_guard<std::mutex> lock( streamer.mutex );
+		streamer.results.push_back( std::move( result ) );
+	}
+}
+
+// Rough size of the full resolution of an image with all its mips
+static size_t R_StreamedImageSize( const image_t *image )
+{
+	size_t texels = size_t( image->width ) * image->height * 4 / 3;
+
+	if ( image->bits & ( IF_BC1 | IF_BC4 ) )
+	{
+		return texels / 2;
+	}
+
+	if ( IsImageCompressed( image->bits ) )
+	{
+		return texels;
+	}
+
+	return texels * 4;
+}
+
+/*
+===============
+R_IsImageStreamable
+
+Whether a newly loaded image should only get its placeholder uploaded.
+Images that are not mipmapped, like the 2D ones, are always uploaded
+in full, as well as lightmaps.
+===============
+*/
+bool R_IsImageStreamable( int width, int height, int numMips, const imageParams_t &imageParams )
+{
+	// bindless textures can't be redefined once they have a handle
+	if ( !r_textureStreaming.Get() || glConfig.usingBindlessTextures )
+	{
+		return false;
+	}
+
+	if ( imageParams.filterType != filterType_t::FT_DEFAULT
+		|| ( imageParams.bits & ( IF_NOPICMIP | IF_FITSCREEN | IF_LIGHTMAP | IF_HOMEPATH ) ) )
+	{
+		return false;
+	}
+
+	// compressed images are downscaled by skipping their precomputed mips
+	if ( IsImageCompressed( imageParams.bits ) && numMips <= 1 )
+	{
+		return false;
+	}
+
+	return std::max( width, height ) > r_textureStreamingPlaceholderSize.Get();
+}
+
+/*
+===============
+R_GetImageStreamingStep
+
+Number of times R_UploadImage halves an image of the given size
+to upload its placeholder, 0 to upload it at full resolution.
+===============
+*/
+int R_GetImageStreamingStep( const image_t *image, int width, int height )
+{
+	if ( !( image->bits & IF_STREAMED ) || image->streamState == streamState_t::RESIDENT )
+	{
+		return 0;
+	}
+
+	int dimension = std::max( width, height );
+	int step = 0;
+
+	while ( dimension > r_textureStreamingPlaceholderSize.Get() )
+	{
+		dimension >>= 1;
+		step++;
+	}
+
+	return step;
+}
+
+/*
+===============
+R_StreamShaderImages
+
+Called for every surface added to the scene. Marks the streamed
+images of the shader as seen, for R_UpdateTextureStreaming.
+===============
+*/
+void R_StreamShaderImages( shader_t *shader )
+{
+	if ( shader->streamFrame == tr.frameCount )
+	{
+		return;
+	}
+
+	shader->streamFrame = tr.frameCount;
+
+	for ( const shaderStage_t *pStage = shader->stages; pStage < shader->lastStage; pStage++ )
+	{
+		for ( const textureBundle_t &bundle : pStage->bundle )
+		{
+			for ( int i = 0; i < std::max( int( bundle.numImages ), 1 ); i++ )
+			{
+				image_t *image = bundle.image[ i ];
+
+				if ( !image || !( image->bits & IF_STREAMED ) )
+				{
+					continue;
+				}
+
+				image->streamFrame = tr.frameCount;
+
+				if ( image->streamState == streamState_t::PLACEHOLDER )
+				{
+					image->streamState = streamState_t::WANTED;
+					wantedImages.push_back( image );
+				}
+			}
+		}
+	}
+}
+
+/*
+===============
+R_EvictStreamedImage
+
+Sends an image back to its placeholder by keeping only its smallest mips,
+which are read back from the texture rather than decoded again. Returns
+false if the image has no mip small enough.
+===============
+*/
+static bool R_EvictStreamedImage( image_t *image )
+{
+	int step = 0;
+
+	while ( std::max( image->uploadWidth >> step, image->uploadHeight >> step ) > r_textureStreamingPlaceholderSize.Get() )
+	{
+		step++;
+	}
+
+	if ( step == 0 )
+	{
+		return false;
+	}
+
+	bool compressed = IsImageCompressed( image->bits );
+	bool isSRGB = image->bits & IF_SRGB;
+	std::vector<std::vector<byte>> mips;
+	int width = 0, height = 0;
+
+	GL_Bind( image );
+
+	// read all the mips before redefining the texture, levels that were
+	// never uploaded have no size
+	for ( int level = step; level < MAX_TEXTURE_MIPS; level++ )
+	{
+		GLint mipWidth, mipHeight;
+		glGetTexLevelParameteriv( GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &mipWidth );
+		glGetTexLevelParameteriv( GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &mipHeight );
+
+		if ( mipWidth <= 0 || mipHeight <= 0 )
+		{
+			break;
+		}
+
+		if ( level == step )
+		{
+			width = mipWidth;
+			height = mipHeight;
+		}
+
+		if ( compressed )
+		{
+			GLint size;
+			glGetTexLevelParameteriv( GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size );
+			mips.emplace_back( size );
+			glGetCompressedTexImage( GL_TEXTURE_2D, level, mips.back().data() );
+		}
+		else
+		{
+			mips.emplace_back( size_t( mipWidth ) * mipHeight * 4 );
+			glGetTexImage( GL_TEXTURE_2D, level, GL_RGBA, GL_UNSIGNED_BYTE, mips.back().data() );
+		}
+	}
+
+	if ( mips.empty() )
+	{
+		return false;
+	}
+
+	int mipWidth = width, mipHeight = height;
+
+	for ( size_t level = 0; level < mips.size(); level++ )
+	{
+		if ( compressed )
+		{
+			GL_CompressedTexImage2D( GL_TEXTURE_2D, level, image->internalFormat, mipWidth, mipHeight, 0, mips[ level ].size(), mips[ level ].data(), isSRGB );
+		}
+		else
+		{
+			GL_TexImage2D( GL_TEXTURE_2D, level, image->internalFormat, mipWidth, mipHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, mips[ level ].data(), isSRGB );
+		}
+
+		mipWidth = std::max( mipWidth >> 1, 1 );
+		mipHeight = std::max( mipHeight >> 1, 1 );
+	}
+
+	// release the larger mips that are left over
+	for ( int level = mips.size(); level < MAX_TEXTURE_MIPS; level++ )
+	{
+		glTexImage2D( GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+	}
+
+	GL_CheckErrors();
+
+	image->uploadWidth = width;
+	image->uploadHeight = height;
+	image->streamState = streamState_t::PLACEHOLDER;
+
+	return true;
+}
+
+// Sends the least recently seen images back to their placeholder until
+// at least the given amount of memory is released
+static void R_EvictStreamedImages( size_t bytes )
+{
+	std::vector<image_t *> candidates;
+
+	for ( image_t *image : tr.images )
+	{
+		if ( image->streamState == streamState_t::RESIDENT && image->streamFrame < tr.frameCount - EVICTION_DELAY )
+		{
+			candidates.push_back( image );
+		}
+	}
+
+	if ( candidates.empty() )
+	{
+		return;
+	}
+
+	std::sort( candidates.begin(), candidates.end(), []( const image_t *a, const image_t *b ) {
+		return a->streamFrame < b->streamFrame;
+	} );
+
+	// we are about to redefine textures
+	R_SyncRenderThread();
+
+	size_t released = 0;
+
+	for ( image_t *image : candidates )
+	{
+		if ( released >= bytes )
+		{
+			break;
+		}
+
+		streamingLog.Verbose( "Evicting %s, unseen for %d frames", image->name, tr.frameCount - image->streamFrame );
+
+		// the memory is only released once the large mips are gone
+		if ( R_EvictStreamedImage( image ) )
+		{
+			released += R_StreamedImageSize( image );
+		}
+	}
+
+	residentBytes -= std::min( released, residentBytes );
+}
+
+/*
+===============
+R_UpdateTextureStreaming
+
+Called at the beginning of each frame. Requests the full resolution of
+the images seen during the last frame within the budget, and uploads
+the images the streaming thread has decoded.
+===============
+*/
+void R_UpdateTextureStreaming()
+{
+	std::vector<streamRequest_t> requests;
+	size_t budget = r_textureStreamingBudget.Get() ? size_t( r_textureStreamingBudget.Get() ) << 20 : SIZE_MAX;
+
+	size_t wantedBytes = 0;
+
+	for ( const image_t *image : wantedImages )
+	{
+		wantedBytes += R_StreamedImageSize( image );
+	}
+
+	// make room for all of them at once, evicting scans and sorts the images
+	if ( residentBytes + wantedBytes > budget )
+	{
+		R_EvictStreamedImages( residentBytes + wantedBytes - budget );
+	}
+
+	for ( image_t *image : wantedImages )
+	{
+		size_t size = R_StreamedImageSize( image );
+
+		// stay at the placeholder resolution, it is tried again the next time it is seen
+		if ( residentBytes + size > budget )
+		{
+			image->streamState = streamState_t::PLACEHOLDER;
+			continue;
+		}
+
+		residentBytes += size;
+		image->streamState = streamState_t::LOADING;
+		requests.push_back( { image, image->name } );
+	}
+
+	wantedImages.clear();
+
+	std::vector<streamResult_t> results;
+
+	{
+		std::lock_guard<std::mutex> lock( streamer.mutex );
+
+		for ( streamRequest_t &request : requests )
+		{
+			streamer.requests.push_back( std::move( request ) );
+		}
+
+		size_t numResults = std::min( streamer.results.size(), size_t( r_textureStreamingUploads.Get() ) );
+		std::move( streamer.results.begin(), streamer.results.begin() + numResults, std::back_inserter( results ) );
+		streamer.results.erase( streamer.results.begin(), streamer.results.begin() + numResults );
+	}
+
+	if ( !requests.empty() )
+	{
+		if ( !streamer.thread.joinable() )
+		{
+			streamer.quit = false;
+			streamer.thread = std::thread( R_StreamingThread );
+		}
+
+		streamer.wake.notify_one();
+	}
+
+	if ( results.empty() )
+	{
+		return;
+	}
+
+	// we are about to upload textures
+	R_SyncRenderThread();
+
+	for ( streamResult_t &result : results )
+	{
+		image_t *image = result.request.image;
+
+		// the file is gone or was changed, keep what we have
+		if ( result.pic.empty() || result.width != image->width || result.height != image->height )
+		{
+			Log::Warn( "Could not stream image '%s', keeping its current resolution", image->name );
+
+			residentBytes -= std::min( R_StreamedImageSize( image ), residentBytes );
+			image->bits &= ~IF_STREAMED;
+			image->streamState = streamState_t::PLACEHOLDER;
+		}
+		else
+		{
+			streamingLog.Debug( "Uploading %s at full resolution", image->name );
+
+			image->streamState = streamState_t::RESIDENT;
+			R_UploadImage( image->name, ( const byte ** ) result.pic.data(), 1, result.numMips, image, image->initialParams );
+		}
+
+		if ( !result.pic.empty() )
+		{
+			Z_Free( result.pic[ 0 ] );
+		}
+	}
+}
+
+/*
+===============
+R_ShutdownTextureStreaming
+
+Stops the streaming thread and drops its work, before the images are freed.
+===============
+*/
+void R_ShutdownTextureStreaming()
+{
+	if ( streamer.thread.joinable() )
+	{
+		{
+			std::lock_guard<std::mutex> lock( streamer.mutex );
+			streamer.quit = true;
+		}
+
+		streamer.wake.notify_one();
+		streamer.thread.join();
+	}
+
+	for ( streamResult_t &result : streamer.results )
+	{
+		if ( !result.pic.empty() )
+		{
+			Z_Free( result.pic[ 0 ] );
+		}
+	}
+
+	streamer.requests.clear();
+	streamer.results.clear();
+	wantedImages.clear();
+	residentBytes = 0;
+}
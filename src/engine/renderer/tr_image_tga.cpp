@@ -309,7 +309,7 @@ breakOut:
 
 		//Log::Warn("'%s' TGA file header declares top-down image, flipping", name);
 
-		flip = ( unsigned char * ) ri.Hunk_AllocateTempMemory( columns * 4 );
+		flip = ( unsigned char * ) Z_Malloc( columns * 4 );
 
 		for ( row = 0; row < (int) rows / 2; row++ )
 		{
@@ -321,6 +321,6 @@ breakOut:
 			memcpy( dst, flip, columns * 4 );
 		}
 
-		ri.Hunk_FreeTempMemory( flip );
+		Z_Free( flip );
 	}
 }
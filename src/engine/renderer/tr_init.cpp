@@ -1524,6 +1524,15 @@ ScreenshotCmd screenshotPNGRegistration("screenshotPNG", ssFormat_t::SSF_PNG, "p
 	void RE_EndRegistration()
 	{
 		R_SyncRenderThread();
+
+		if ( tr.world )
+		{
+			R_PrintImageLoadStats( tr.world->baseName );
+			R_ResetImageLoadStats();
+			R_PrintShaderLoadStats( tr.world->baseName );
+			R_ResetShaderLoadStats();
+		}
+
 		if ( r_lazyShaders.Get() == 1 ) {
 			if ( tr.world->numFogs > 0 )
 			{
@@ -509,7 +509,8 @@ enum class ssaoMode {
 	  IF_BC4 = BIT( 22 ),
 	  IF_BC5 = BIT( 23 ),
 	  IF_RGBA32UI = BIT( 24 ),
-	  IF_HOMEPATH = BIT( 25 )
+	  IF_HOMEPATH = BIT( 25 ),
+	  IF_STREAMED = BIT( 26 ) // see tr_image_streaming.cpp
 	};
 
 	enum class filterType_t
@@ -559,6 +560,15 @@ enum class ssaoMode {
 		}
 	};
 
+	// texture streaming state of the images with IF_STREAMED
+	enum class streamState_t : uint8_t
+	{
+	  PLACEHOLDER, // low resolution uploaded
+	  WANTED, // seen this frame, full resolution not requested yet
+	  LOADING, // full resolution being decoded
+	  RESIDENT // full resolution uploaded
+	};
+
 	struct image_t
 	{
 		char name[ MAX_QPATH ];
@@ -574,6 +584,9 @@ enum class ssaoMode {
 
 		int            frameUsed; // for texture usage in frame statistics
 
+		streamState_t  streamState;
+		int            streamFrame; // last frame a surface using it was added, for texture streaming
+
 		uint32_t       internalFormat;
 
 		uint32_t       bits;
@@ -1193,6 +1206,8 @@ enum
 		struct shader_t *depthShader;
 		struct shader_t *fogShader;
 		struct shader_t *next;
+
+		int streamFrame; // last frame its images were marked as used by texture streaming
 	};
 
 // *INDENT-OFF*
@@ -2987,12 +3002,20 @@ void GL_CompressedTexSubImage3D( GLenum target, GLint level, GLint xOffset, GLin
 	void    R_ShutdownImages();
 
 	bool R_HasImageLoader( const char *baseName );
+	int R_ImagePrefetchBatchSize();
+	void R_PrefetchImages( const std::vector<std::string> &imageNames );
+	void R_DiscardPrefetchedImages();
+	void R_ResetImageLoadStats();
+	void R_PrintImageLoadStats( const char *mapName );
+	void R_DecodeImage( const char *name, byte **pic, int *width, int *height,
+			 int *numLayers, int *numMips, int *bits );
 	image_t *R_FindImageFile( const char *name, imageParams_t &imageParams );
 	image_t *R_FindCubeImage( const char *name, imageParams_t &imageParams );
 
 	image_t *R_CreateImage( const char *name, const byte **pic, int width, int height, int numMips, const imageParams_t &imageParams );
 
 	image_t *R_CreateCubeImage( const char *name, const byte *pic[ 6 ], int width, int height, const imageParams_t &imageParams );
+
 	image_t *R_Create3DImage( const char *name, const byte *pic, int width, int height, int depth, const imageParams_t &imageParams );
 
 	image_t *R_CreateGlyph( const char *name, const byte *pic, int width, int height );
@@ -3008,6 +3031,29 @@ void GL_CompressedTexSubImage3D( GLenum target, GLint level, GLint xOffset, GLin
 	/*
 	====================================================================
 
+	IMAGE CACHE, tr_image_cache.cpp
+
+	====================================================================
+	*/
+	bool R_ReadImageCache( const char *fileName, byte **pic, int *width, int *height, int *numMips, int *bits );
+	void R_WriteImageCache( const char *fileName, byte **pic, int width, int height, int numMips, int bits );
+
+	/*
+	====================================================================
+
+	TEXTURE STREAMING, tr_image_streaming.cpp
+
+	====================================================================
+	*/
+	bool R_IsImageStreamable( int width, int height, int numMips, const imageParams_t &imageParams );
+	int  R_GetImageStreamingStep( const image_t *image, int width, int height );
+	void R_StreamShaderImages( shader_t *shader );
+	void R_UpdateTextureStreaming();
+	void R_ShutdownTextureStreaming();
+
+	/*
+	====================================================================
+
 	SHADERS, tr_shader.c
 
 	====================================================================
@@ -3016,6 +3062,9 @@ void GL_CompressedTexSubImage3D( GLenum target, GLint level, GLint xOffset, GLin
 	qhandle_t RE_RegisterShaderFromImage( const char *name, image_t *image );
 
 	shader_t  *R_FindShader( const char *name, int flags );
+	void      R_GetShaderImageNames( const char *shaderName, std::vector<std::string> &imageNames );
+	void      R_ResetShaderLoadStats();
+	void      R_PrintShaderLoadStats( const char *mapName );
 	shader_t  *R_GetShaderByHandle( qhandle_t hShader );
 	const char *RE_GetShaderNameFromHandle( qhandle_t shader );
 	void      R_InitShaders();
@@ -3630,7 +3679,7 @@ void GLimp_LogComment_( std::string comment );
 	    float s1, float t1, float s2, float t2, qhandle_t hShader, const Color::Color& gradientColor,
 	    int gradientType );
 	void                                RE_2DPolyies( polyVert_t *verts, int numverts, qhandle_t hShader );
-	void                                RE_2DPolyiesIndexed( polyVert_t *verts, int numverts, int *indexes, int numindexes, int trans_x, int trans_y, qhandle_t hShader );
+	void                                RE_2DPolyiesIndexed( const polyVert_t *verts, int numverts, const int *indexes, int numindexes, int trans_x, int trans_y, qhandle_t hShader );
 	void                                RE_ScissorEnable( bool enable );
 	void                                RE_ScissorSet( int x, int y, int w, int h );
 	void                                RE_SetMatrixTransform( const matrix_t matrix );
@@ -1691,6 +1691,8 @@ R_AddDrawSurf
 */
 void R_AddDrawSurf( surfaceType_t *surface, shader_t *shader, int lightmapNum, int fogNum, bool bspSurface, int portalNum )
 {
+	R_StreamShaderImages( shader );
+
 	// instead of checking for overflow, we just mask the index
 	// so it wraps around
 	const int baseIndex = tr.refdef.numDrawSurfs & DRAWSURF_MASK;
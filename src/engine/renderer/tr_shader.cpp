@@ -24,8 +24,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "tr_local.h"
 #include "gl_shader.h"
 #include "framework/CvarSystem.h"
+#include "framework/WorkerPool.h"
 #include "Material.h"
 #include "GeometryOptimiser.h"
+#include "tr_shader_text.h"
 #include <iomanip>
 
 static const int MAX_SHADERTABLE_HASH = 1024;
@@ -35,9 +37,11 @@ static const int FILE_HASH_SIZE       = 1024;
 static shader_t      *shaderHashTable[ FILE_HASH_SIZE ];
 
 static const int MAX_SHADERTEXT_HASH  = 2048;
-static const char          **shaderTextHashTable[ MAX_SHADERTEXT_HASH ];
+static const shaderToken_t **shaderTextHashTable[ MAX_SHADERTEXT_HASH ];
 
 static char          *s_shaderText;
+static char          *s_shaderTokenStrings;
+static shaderToken_t *s_shaderTokens, *s_shaderTokensEnd;
 
 // the shader is parsed into these global variables, then copied into
 // dynamically allocated memory if it is valid.
@@ -87,6 +91,42 @@ static Cvar::Cvar<float> r_portalDefaultRange(
 Cvar::Cvar<bool> r_depthShaders(
 	"r_depthShaders", "use depth pre-pass shaders", Cvar::CHEAT, true);
 
+static Cvar::Range<Cvar::Cvar<int>> r_shaderLoadThreads( "r_shaderLoadThreads",
+	"number of worker threads reading and indexing the shader files, 0 to do it on the main thread",
+	Cvar::NONE, 4, 0, 64 );
+
+static Log::Logger shaderLoadLog( "renderer.shaderLoad", "", Log::Level::NOTICE );
+
+static Sys::WorkerPool shaderWorkers( "shader loading" );
+
+// Shader registrations since the last R_ResetShaderLoadStats
+static struct
+{
+	int numShaders;
+	int depth; // R_FindShader may be called while parsing a shader
+	Sys::SteadyClock::duration time;
+} shaderLoadStats;
+
+// Adds the time until it goes out of scope to the shader registration time
+struct shaderLoadTimer_t
+{
+	Sys::SteadyClock::time_point start = Sys::SteadyClock::now();
+
+	shaderLoadTimer_t()
+	{
+		shaderLoadStats.depth++;
+	}
+
+	~shaderLoadTimer_t()
+	{
+		if ( --shaderLoadStats.depth == 0 )
+		{
+			shaderLoadStats.numShaders++;
+			shaderLoadStats.time += Sys::SteadyClock::now() - start;
+		}
+	}
+};
+
 /*
 ================
 return a hash value for the filename
@@ -191,12 +231,12 @@ void R_RemapShader( const char *shaderName, const char *newShaderName, const cha
 ParseVector
 ===============
 */
-static bool ParseVector( const char **text, int count, float *v )
+static bool ParseVector( shaderText_t *text, int count, float *v )
 {
 	const char *token;
 	int  i;
 
-	token = COM_ParseExt2( text, false );
+	token = ParseShaderToken( text, false );
 
 	if ( strcmp( token, "(" ) )
 	{
@@ -206,7 +246,7 @@ static bool ParseVector( const char **text, int count, float *v )
 
 	for ( i = 0; i < count; i++ )
 	{
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( !token[ 0 ] )
 		{
@@ -217,7 +257,7 @@ static bool ParseVector( const char **text, int count, float *v )
 		v[ i ] = atof( token );
 	}
 
-	token = COM_ParseExt2( text, false );
+	token = ParseShaderToken( text, false );
 
 	if ( strcmp( token, ")" ) )
 	{
@@ -880,6 +920,13 @@ static void ParseExpression( const char **text, expression_t *exp, int bits = 0
 	exp->numOps = numOps;
 }
 
+static void ParseExpression( shaderText_t *text, expression_t *exp, int bits = 0 )
+{
+	const char *p = ShaderTextPosition( text );
+	ParseExpression( &p, exp, bits );
+	ShaderTextSeek( text, p );
+}
+
 /*
 ===============
 NameToAFunc
@@ -1058,11 +1105,11 @@ static genFunc_t NameToGenFunc( const char *funcname )
 ParseWaveForm
 ===================
 */
-static void ParseWaveForm( const char **text, waveForm_t *wave )
+static void ParseWaveForm( shaderText_t *text, waveForm_t *wave )
 {
 	const char *token;
 
-	token = COM_ParseExt2( text, false );
+	token = ParseShaderToken( text, false );
 
 	if ( token[ 0 ] == 0 )
 	{
@@ -1073,7 +1120,7 @@ static void ParseWaveForm( const char **text, waveForm_t *wave )
 	wave->func = NameToGenFunc( token );
 
 	// BASE, AMP, PHASE, FREQ
-	token = COM_ParseExt2( text, false );
+	token = ParseShaderToken( text, false );
 
 	if ( token[ 0 ] == 0 )
 	{
@@ -1083,7 +1130,7 @@ static void ParseWaveForm( const char **text, waveForm_t *wave )
 
 	wave->base = atof( token );
 
-	token = COM_ParseExt2( text, false );
+	token = ParseShaderToken( text, false );
 
 	if ( token[ 0 ] == 0 )
 	{
@@ -1093,7 +1140,7 @@ static void ParseWaveForm( const char **text, waveForm_t *wave )
 
 	wave->amplitude = atof( token );
 
-	token = COM_ParseExt2( text, false );
+	token = ParseShaderToken( text, false );
 
 	if ( token[ 0 ] == 0 )
 	{
@@ -1103,7 +1150,7 @@ static void ParseWaveForm( const char **text, waveForm_t *wave )
 
 	wave->phase = atof( token );
 
-	token = COM_ParseExt2( text, false );
+	token = ParseShaderToken( text, false );
 
 	if ( token[ 0 ] == 0 )
 	{
@@ -1119,7 +1166,7 @@ static void ParseWaveForm( const char **text, waveForm_t *wave )
 ParseTexMod
 ===================
 */
-static bool ParseTexMod( const char **text, shaderStage_t *stage )
+static bool ParseTexMod( shaderText_t *text, shaderStage_t *stage )
 {
 	const char   *token;
 	texModInfo_t *tmi;
@@ -1132,12 +1179,12 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 	tmi = &stage->bundle[ 0 ].texMods[ stage->bundle[ 0 ].numTexMods ];
 	stage->bundle[ 0 ].numTexMods++;
 
-	token = COM_ParseExt2( text, false );
+	token = ParseShaderToken( text, false );
 
 	// turb
 	if ( !Q_stricmp( token, "turb" ) )
 	{
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1146,7 +1193,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 		}
 
 		tmi->wave.base = atof( token );
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1155,7 +1202,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 		}
 
 		tmi->wave.amplitude = atof( token );
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1164,7 +1211,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 		}
 
 		tmi->wave.phase = atof( token );
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1179,7 +1226,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 	// scale
 	else if ( !Q_stricmp( token, "scale" ) )
 	{
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1189,7 +1236,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 
 		tmi->scale[ 0 ] = atof( token );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1203,7 +1250,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 	// scroll
 	else if ( !Q_stricmp( token, "scroll" ) )
 	{
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1212,7 +1259,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 		}
 
 		tmi->scroll[ 0 ] = atof( token );
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1226,7 +1273,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 	// stretch
 	else if ( !Q_stricmp( token, "stretch" ) )
 	{
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1236,7 +1283,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 
 		tmi->wave.func = NameToGenFunc( token );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1246,7 +1293,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 
 		tmi->wave.base = atof( token );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1256,7 +1303,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 
 		tmi->wave.amplitude = atof( token );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1266,7 +1313,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 
 		tmi->wave.phase = atof( token );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1283,7 +1330,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 	{
 		MatrixIdentity( tmi->matrix );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1293,7 +1340,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 
 		tmi->matrix[ 0 ] = atof( token );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1303,7 +1350,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 
 		tmi->matrix[ 1 ] = atof( token );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1313,7 +1360,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 
 		tmi->matrix[ 4 ] = atof( token );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1323,7 +1370,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 
 		tmi->matrix[ 5 ] = atof( token );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1333,7 +1380,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 
 		tmi->matrix[ 12 ] = atof( token );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1348,7 +1395,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 	// rotate
 	else if ( !Q_stricmp( token, "rotate" ) )
 	{
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -1373,7 +1420,7 @@ static bool ParseTexMod( const char **text, shaderStage_t *stage )
 	return true;
 }
 
-static bool ParseMap( const char **text, char *buffer, int bufferSize )
+static bool ParseMap( shaderText_t *text, char *buffer, int bufferSize )
 {
 	int  len;
 
@@ -1382,7 +1429,7 @@ static bool ParseMap( const char **text, char *buffer, int bufferSize )
 
 	while ( true )
 	{
-		const char *token = COM_ParseExt2( text, false );
+		const char *token = ParseShaderToken( text, false );
 
 		if ( !token[ 0 ] )
 		{
@@ -1406,6 +1453,18 @@ static bool ParseMap( const char **text, char *buffer, int bufferSize )
 	return true;
 }
 
+// Whether the images of such stages are ignored with the current rendering features
+static bool IsStageTypeDisabled( stageType_t type )
+{
+	// NOTE: Normal map can ship height map in alpha channel.
+	return ( type == stageType_t::ST_NORMALMAP && !glConfig.normalMapping && !glConfig.reliefMapping )
+		|| ( type == stageType_t::ST_HEIGHTMAP && !glConfig.reliefMapping )
+		|| ( type == stageType_t::ST_SPECULARMAP && !glConfig.specularMapping )
+		|| ( type == stageType_t::ST_PHYSICALMAP && !glConfig.physicalMapping )
+		|| ( type == stageType_t::ST_GLOWMAP && !r_glowMapping->integer )
+		|| ( type == stageType_t::ST_REFLECTIONMAP && !glConfig.reflectionMappingAvailable );
+}
+
 static bool LoadMap( shaderStage_t *stage, const char *buffer, stageType_t type, const int bundleIndex = TB_COLORMAP )
 {
 	const char         *buffer_p = &buffer[ 0 ];
@@ -1418,13 +1477,7 @@ static bool LoadMap( shaderStage_t *stage, const char *buffer, stageType_t type,
 
 	const char *token = COM_ParseExt2( &buffer_p, false );
 
-	// NOTE: Normal map can ship height map in alpha channel.
-	if ( ( type == stageType_t::ST_NORMALMAP && !glConfig.normalMapping && !glConfig.reliefMapping )
-		|| ( type == stageType_t::ST_HEIGHTMAP && !glConfig.reliefMapping )
-		|| ( type == stageType_t::ST_SPECULARMAP && !glConfig.specularMapping )
-		|| ( type == stageType_t::ST_PHYSICALMAP && !glConfig.physicalMapping )
-		|| ( type == stageType_t::ST_GLOWMAP && !r_glowMapping->integer )
-		|| ( type == stageType_t::ST_REFLECTIONMAP && !glConfig.reflectionMappingAvailable ) )
+	if ( IsStageTypeDisabled( type ) )
 	{
 		return true;
 	}
@@ -1597,7 +1650,7 @@ ParseDifuseMap
 and others
 ===================
 */
-static void ParseDiffuseMap( shaderStage_t *stage, const char **text, const int bundleIndex = TB_DIFFUSEMAP )
+static void ParseDiffuseMap( shaderStage_t *stage, shaderText_t *text, const int bundleIndex = TB_DIFFUSEMAP )
 {
 	char buffer[ 1024 ] = "";
 
@@ -1607,7 +1660,7 @@ static void ParseDiffuseMap( shaderStage_t *stage, const char **text, const int
 	}
 }
 
-static void ParseLegacyDiffuseStage( shaderStage_t *stage, const char **text )
+static void ParseLegacyDiffuseStage( shaderStage_t *stage, shaderText_t *text )
 {
 	stage->active = true;
 	stage->type = stageType_t::ST_DIFFUSEMAP;
@@ -1617,7 +1670,7 @@ static void ParseLegacyDiffuseStage( shaderStage_t *stage, const char **text )
 	ParseDiffuseMap( stage, text, TB_COLORMAP );
 }
 
-static void ParseNormalMap( shaderStage_t *stage, const char **text, const int bundleIndex = TB_NORMALMAP )
+static void ParseNormalMap( shaderStage_t *stage, shaderText_t *text, const int bundleIndex = TB_NORMALMAP )
 {
 	char buffer[ 1024 ] = "";
 
@@ -1636,7 +1689,7 @@ static void ParseNormalMap( shaderStage_t *stage, const char **text, const int b
 	}
 }
 
-static void ParseLegacyNormalStage( shaderStage_t *stage, const char **text )
+static void ParseLegacyNormalStage( shaderStage_t *stage, shaderText_t *text )
 {
 	stage->active = true;
 	stage->type = stageType_t::ST_NORMALMAP;
@@ -1646,7 +1699,7 @@ static void ParseLegacyNormalStage( shaderStage_t *stage, const char **text )
 	ParseNormalMap( stage, text, TB_COLORMAP );
 }
 
-static void ParseNormalMapDetectHeightMap( shaderStage_t *stage, const char **text, const int bundleIndex = TB_NORMALMAP )
+static void ParseNormalMapDetectHeightMap( shaderStage_t *stage, shaderText_t *text, const int bundleIndex = TB_NORMALMAP )
 {
 	/* Always call this function on assets known to never use RGTC format
 	or the engine running on hardware with driver not implementing the
@@ -1662,7 +1715,7 @@ static void ParseNormalMapDetectHeightMap( shaderStage_t *stage, const char **te
 
 	Please do not implement material keyword for this function, never. */
 
-	const char* initialText = *text;
+	shaderText_t initialText = *text;
 
 	ParseNormalMap( stage, text, bundleIndex );
 
@@ -1691,7 +1744,7 @@ static void ParseNormalMapDetectHeightMap( shaderStage_t *stage, const char **te
 
 // There is no ParseLegacyNormalStageDetectHeightMap.
 
-static void ParseHeightMap( shaderStage_t *stage, const char **text, const int bundleIndex = TB_HEIGHTMAP )
+static void ParseHeightMap( shaderStage_t *stage, shaderText_t *text, const int bundleIndex = TB_HEIGHTMAP )
 {
 	char buffer[ 1024 ] = "";
 
@@ -1703,7 +1756,7 @@ static void ParseHeightMap( shaderStage_t *stage, const char **text, const int b
 
 // There is no ParseLegacyHeightStage.
 
-static void ParseSpecularMap( shaderStage_t *stage, const char **text, const int bundleIndex = TB_SPECULARMAP )
+static void ParseSpecularMap( shaderStage_t *stage, shaderText_t *text, const int bundleIndex = TB_SPECULARMAP )
 {
 	char buffer[ 1024 ] = "";
 
@@ -1713,7 +1766,7 @@ static void ParseSpecularMap( shaderStage_t *stage, const char **text, const int
 	}
 }
 
-static void ParseLegacySpecularStage( shaderStage_t *stage, const char **text )
+static void ParseLegacySpecularStage( shaderStage_t *stage, shaderText_t *text )
 {
 	stage->active = true;
 	stage->type = stageType_t::ST_SPECULARMAP;
@@ -1723,7 +1776,7 @@ static void ParseLegacySpecularStage( shaderStage_t *stage, const char **text )
 	ParseSpecularMap( stage, text, TB_COLORMAP );
 }
 
-static void ParsePhysicalMap( shaderStage_t *stage, const char **text, const int bundleIndex = TB_PHYSICALMAP )
+static void ParsePhysicalMap( shaderStage_t *stage, shaderText_t *text, const int bundleIndex = TB_PHYSICALMAP )
 {
 	char buffer[ 1024 ] = "";
 
@@ -1739,7 +1792,7 @@ static void ParsePhysicalMap( shaderStage_t *stage, const char **text, const int
 
 // There is no ParseLegacyPhysicalStage.
 
-static void ParseGlowMap( shaderStage_t *stage, const char **text, const int bundleIndex = TB_GLOWMAP )
+static void ParseGlowMap( shaderStage_t *stage, shaderText_t *text, const int bundleIndex = TB_GLOWMAP )
 {
 	char buffer[ 1024 ] = "";
 
@@ -1749,7 +1802,7 @@ static void ParseGlowMap( shaderStage_t *stage, const char **text, const int bun
 	}
 }
 
-static void ParseLegacyGlowStage( shaderStage_t *stage, const char **text )
+static void ParseLegacyGlowStage( shaderStage_t *stage, shaderText_t *text )
 {
 	stage->active = true;
 	stage->type = stageType_t::ST_GLOWMAP;
@@ -1759,7 +1812,7 @@ static void ParseLegacyGlowStage( shaderStage_t *stage, const char **text )
 	ParseGlowMap( stage, text, TB_COLORMAP );
 }
 
-static void ParseReflectionMap( shaderStage_t *stage, const char **text, const int bundleIndex = TB_REFLECTIONMAP )
+static void ParseReflectionMap( shaderStage_t *stage, shaderText_t *text, const int bundleIndex = TB_REFLECTIONMAP )
 {
 	char buffer[ 1024 ] = "";
 
@@ -1774,7 +1827,7 @@ static void ParseReflectionMap( shaderStage_t *stage, const char **text, const i
 }
 
 // This is not legacy.
-static void ParseReflectionStage( shaderStage_t *stage, const char **text )
+static void ParseReflectionStage( shaderStage_t *stage, shaderText_t *text )
 {
 	stage->active = true;
 	stage->type = stageType_t::ST_REFLECTIONMAP;
@@ -1784,7 +1837,7 @@ static void ParseReflectionStage( shaderStage_t *stage, const char **text )
 	ParseReflectionMap( stage, text, TB_COLORMAP );
 }
 
-static void ParseReflectionStageBlended( shaderStage_t *stage, const char **text )
+static void ParseReflectionStageBlended( shaderStage_t *stage, shaderText_t *text )
 {
 	stage->active = true;
 	stage->type = stageType_t::ST_REFLECTIONMAP;
@@ -1846,7 +1899,7 @@ struct extraMapParser_t
 {
 	const char *suffix;
 	const char *description;
-	void ( *parser ) ( shaderStage_t*, const char**, int );
+	void ( *parser ) ( shaderStage_t*, shaderText_t*, int );
 	int bundleIndex;
 };
 
@@ -1973,8 +2026,12 @@ void LoadExtraMaps( shaderStage_t *stage, const char *colorMapName )
 				foundExtraMap = true;
 				Log::Debug( "found extra %s '%s'", parser.description, extraMapName.c_str() );
 
-				const char *name = extraMapName.c_str();
-				parser.parser( stage, &name, parser.bundleIndex );
+				std::vector<shaderToken_t> tokens;
+				std::string strings;
+				TokenizeShaderText( extraMapName.c_str(), tokens, strings );
+
+				shaderText_t text = { extraMapName.c_str(), strings.c_str(), tokens.data(), tokens.data() + tokens.size(), 0 };
+				parser.parser( stage, &text, parser.bundleIndex );
 
 				if ( parser.bundleIndex == TB_NORMALMAP )
 				{
@@ -1999,7 +2056,7 @@ void LoadExtraMaps( shaderStage_t *stage, const char *colorMapName )
 ParseStage
 ===================
 */
-static bool ParseStage( shaderStage_t *stage, const char **text )
+static bool ParseStage( shaderStage_t *stage, shaderText_t *text )
 {
 	const char *token;
 	int          colorMaskBits = 0;
@@ -2012,7 +2069,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 
 	while ( true )
 	{
-		token = COM_ParseExt2( text, true );
+		token = ParseShaderToken( text, true );
 
 		if ( !token[ 0 ] )
 		{
@@ -2160,7 +2217,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 				Log::Warn("keyword '%s' cannot be used in collapsed shader '%s'", token, shader.name );
 			}
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -2212,7 +2269,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 				Log::Warn("keyword '%s' cannot be used in collapsed shader '%s'", token, shader.name );
 			}
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -2227,7 +2284,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 			{
 				int num;
 
-				token = COM_ParseExt2( text, false );
+				token = ParseShaderToken( text, false );
 
 				if ( !token[ 0 ] )
 				{
@@ -2271,7 +2328,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 					token, shader.name );
 			}
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -2291,7 +2348,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 				Log::Warn("keyword '%s' cannot be used in collapsed shader '%s'", token, shader.name );
 			}
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -2338,7 +2395,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 		// alphafunc <func>
 		else if ( !Q_stricmp( token, "alphaFunc" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -2357,7 +2414,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 		// depthFunc <func>
 		else if ( !Q_stricmp( token, "depthfunc" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -2431,7 +2488,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 		// ET fog
 		else if ( !Q_stricmp( token, "fog" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( token[ 0 ] == 0 )
 			{
@@ -2451,7 +2508,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 		}
 		else if ( !Q_stricmp( token, "depthFade" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -2475,7 +2532,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 		else if ( !Q_stricmp( token, "blendfunc" ) ||
 			  !Q_stricmp( token, "blend" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( token[ 0 ] == 0 )
 			{
@@ -2547,10 +2604,10 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 				// complex double blends
 				blendSrcBits = NameToSrcBlendMode( token );
 
-				token = COM_ParseExt2( text, false );
+				token = ParseShaderToken( text, false );
 
 				if ( !Q_stricmp(token, "," ) ) {
-					token = COM_ParseExt2( text, false );
+					token = ParseShaderToken( text, false );
 				}
 
 				if ( token[ 0 ] == 0 )
@@ -2579,7 +2636,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 		// stage <type>
 		else if ( !Q_stricmp( token, "stage" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( token[ 0 ] == 0 )
 			{
@@ -2655,7 +2712,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 		// rgbGen
 		else if ( !Q_stricmp( token, "rgbGen" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( token[ 0 ] == 0 )
 			{
@@ -2777,7 +2834,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 		// alphaGen
 		else if ( !Q_stricmp( token, "alphaGen" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( token[ 0 ] == 0 )
 			{
@@ -2792,7 +2849,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 			}
 			else if ( !Q_stricmp( token, "const" ) )
 			{
-				token = COM_ParseExt2( text, false );
+				token = ParseShaderToken( text, false );
 				stage->constantColor.SetAlpha( 255 * atof( token ) );
 				stage->alphaGen = alphaGen_t::AGEN_CONST;
 			}
@@ -2825,7 +2882,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 				stage->type = stageType_t::ST_PORTALMAP;
 				stage->alphaGen = alphaGen_t::AGEN_PORTAL;
 
-				token = COM_ParseExt2( text, false );
+				token = ParseShaderToken( text, false );
 
 				/* Until we implement “alphaGen portal” to blend textures on them
 				we are still rendering portals so we need to parse the range. */
@@ -2863,7 +2920,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 		// tcGen <function>
 		else if ( !Q_stricmp( token, "texGen" ) || !Q_stricmp( token, "tcGen" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( token[ 0 ] == 0 )
 			{
@@ -2898,7 +2955,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 			else
 			{
 				Log::Warn("unknown tcGen keyword '%s' not supported in shader '%s'", token, shader.name );
-				SkipRestOfLine( text );
+				SkipRestOfShaderLine( text );
 			}
 		}
 		// tcMod <type> <...>
@@ -3107,7 +3164,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 
 			for ( int i = 0; i < 3; i++ )
 			{
-				token = COM_ParseExt( text, false );
+				token = ParseShaderWord( text, false );
 
 				if ( !Q_stricmp( token, components[ i ] ) )
 				{
@@ -3139,7 +3196,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 				}
 			}
 
-			SkipRestOfLine( text );
+			SkipRestOfShaderLine( text );
 			continue;
 		}
 		/* normalScale <float> <float> <float>
@@ -3162,7 +3219,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 		{
 			for ( int i = 0; i < 3; i++ )
 			{
-				token = COM_ParseExt2( text, false );
+				token = ParseShaderToken( text, false );
 
 				if ( token[ 0 ] == '\0' )
 				{
@@ -3191,7 +3248,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 				stage->normalScale[ i ] = j;
 			}
 
-			SkipRestOfLine( text );
+			SkipRestOfShaderLine( text );
 			continue;
 		}
 		// normalIntensity <arithmetic expression>
@@ -3217,7 +3274,7 @@ static bool ParseStage( shaderStage_t *stage, const char **text )
 		else
 		{
 			Log::Warn("unknown shader stage parameter '%s' in shader '%s'", token, shader.name );
-			SkipRestOfLine( text );
+			SkipRestOfShaderLine( text );
 			continue;
 		}
 	}
@@ -3295,12 +3352,12 @@ deformVertexes autoSprite
 deformVertexes autoSprite2
 ===============
 */
-static void ParseDeform( const char **text )
+static void ParseDeform( shaderText_t *text )
 {
 	const char *token;
 	deformStage_t *ds;
 
-	token = COM_ParseExt2( text, false );
+	token = ParseShaderToken( text, false );
 
 	if ( token[ 0 ] == 0 )
 	{
@@ -3333,7 +3390,7 @@ static void ParseDeform( const char **text )
 
 	if ( !Q_stricmp( token, "bulge" ) )
 	{
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -3343,7 +3400,7 @@ static void ParseDeform( const char **text )
 
 		ds->bulgeWidth = atof( token );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -3353,7 +3410,7 @@ static void ParseDeform( const char **text )
 
 		ds->bulgeHeight = atof( token );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -3369,7 +3426,7 @@ static void ParseDeform( const char **text )
 
 	if ( !Q_stricmp( token, "wave" ) )
 	{
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -3394,7 +3451,7 @@ static void ParseDeform( const char **text )
 
 	if ( !Q_stricmp( token, "normal" ) )
 	{
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -3404,7 +3461,7 @@ static void ParseDeform( const char **text )
 
 		ds->deformationWave.amplitude = atof( token );
 
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -3424,7 +3481,7 @@ static void ParseDeform( const char **text )
 
 		for ( i = 0; i < 3; i++ )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( token[ 0 ] == 0 )
 			{
@@ -3446,7 +3503,7 @@ static void ParseDeform( const char **text )
 
 		for ( i = 0; i < 3; i++ )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( token[ 0 ] == 0 )
 			{
@@ -3470,7 +3527,7 @@ static void ParseDeform( const char **text )
 
 	if ( !Q_stricmp( token, "flare" ) )
 	{
-		token = COM_ParseExt2( text, false );
+		token = ParseShaderToken( text, false );
 
 		if ( token[ 0 ] == 0 )
 		{
@@ -3492,13 +3549,13 @@ ParseSkyParms
 skyParms <outerbox> <cloudheight> <innerbox>
 ===============
 */
-static void ParseSkyParms( const char **text )
+static void ParseSkyParms( shaderText_t *text )
 {
 	const char *token;
 	char prefix[ MAX_QPATH ];
 
 	// outerbox
-	token = COM_ParseExt2( text, false );
+	token = ParseShaderToken( text, false );
 
 	if ( token[ 0 ] == 0 )
 	{
@@ -3532,7 +3589,7 @@ static void ParseSkyParms( const char **text )
 	}
 
 	// cloudheight
-	token = COM_ParseExt2( text, false );
+	token = ParseShaderToken( text, false );
 
 	if ( token[ 0 ] == 0 )
 	{
@@ -3548,7 +3605,7 @@ static void ParseSkyParms( const char **text )
 	}
 
 	// innerbox
-	token = COM_ParseExt2( text, false );
+	token = ParseShaderToken( text, false );
 
 	if ( token[ 0 ] == 0 )
 	{
@@ -3585,11 +3642,11 @@ static void ParseSkyParms( const char **text )
 ParseSort
 =================
 */
-static void ParseSort( const char **text )
+static void ParseSort( shaderText_t *text )
 {
 	const char *token;
 
-	token = COM_ParseExt2( text, false );
+	token = ParseShaderToken( text, false );
 
 	if ( token[ 0 ] == 0 )
 	{
@@ -3799,9 +3856,9 @@ static bool SurfaceParm( const char *token )
 	return false;
 }
 
-static void ParseSurfaceParm( const char **text )
+static void ParseSurfaceParm( shaderText_t *text )
 {
-	const char *token = COM_ParseExt2( text, false );
+	const char *token = ParseShaderToken( text, false );
 	SurfaceParm( token );
 }
 
@@ -3814,16 +3871,14 @@ shader.  Parse it into the global shader variable.  Later functions
 will optimize it.
 =================
 */
-static bool ParseShader( const char *_text )
+static bool ParseShader( shaderText_t *text )
 {
-	const char **text;
 	const char *token;
 	int  s;
 
 	s = 0;
-	text = &_text;
 
-	token = COM_ParseExt2( text, true );
+	token = ParseShaderToken( text, true );
 
 	if ( token[ 0 ] != '{' )
 	{
@@ -3833,7 +3888,7 @@ static bool ParseShader( const char *_text )
 
 	while ( true )
 	{
-		token = COM_ParseExt2( text, true );
+		token = ParseShaderToken( text, true );
 
 		if ( !token[ 0 ] )
 		{
@@ -4028,25 +4083,25 @@ static bool ParseShader( const char *_text )
 		// skip stuff that only the QuakeEdRadient needs
 		else if ( !Q_strnicmp( token, "qer", 3 ) )
 		{
-			SkipRestOfLine( text );
+			SkipRestOfShaderLine( text );
 			continue;
 		}
 		// skip description
 		else if ( !Q_stricmp( token, "description" ) )
 		{
-			SkipRestOfLine( text );
+			SkipRestOfShaderLine( text );
 			continue;
 		}
 		// skip renderbump
 		else if ( !Q_stricmp( token, "renderbump" ) )
 		{
-			SkipRestOfLine( text );
+			SkipRestOfShaderLine( text );
 			continue;
 		}
 		// skip guiSurf
 		else if ( !Q_stricmp( token, "guiSurf" ) )
 		{
-			SkipRestOfLine( text );
+			SkipRestOfShaderLine( text );
 			continue;
 		}
 		// sun parms
@@ -4054,7 +4109,7 @@ static bool ParseShader( const char *_text )
 		{
 			float a, b;
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -4064,7 +4119,7 @@ static bool ParseShader( const char *_text )
 
 			tr.sunLight[ 0 ] = atof( token );
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -4074,7 +4129,7 @@ static bool ParseShader( const char *_text )
 
 			tr.sunLight[ 1 ] = atof( token );
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -4086,7 +4141,7 @@ static bool ParseShader( const char *_text )
 
 			VectorNormalize( tr.sunLight );
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -4097,7 +4152,7 @@ static bool ParseShader( const char *_text )
 			a = atof( token );
 			VectorScale( tr.sunLight, a, tr.sunLight );
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -4107,7 +4162,7 @@ static bool ParseShader( const char *_text )
 
 			a = DEG2RAD( atof( token ) );
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -4151,7 +4206,7 @@ static bool ParseShader( const char *_text )
 		}
 		else if ( !Q_stricmp( token, "tesssize" ) )
 		{
-			SkipRestOfLine( text );
+			SkipRestOfShaderLine( text );
 			continue;
 		}
 
@@ -4163,7 +4218,7 @@ static bool ParseShader( const char *_text )
 		// skip stuff that only the q3map needs
 		else if ( !Q_strnicmp( token, "q3map", 5 ) )
 		{
-			SkipRestOfLine( text );
+			SkipRestOfShaderLine( text );
 			continue;
 		}
 		// skip stuff that only q3map or the server needs
@@ -4194,7 +4249,7 @@ static bool ParseShader( const char *_text )
 		// imageMinDimension enforcement
 		else if ( !Q_stricmp( token, "imageMinDimension" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( token[ 0 ] )
 			{
@@ -4206,7 +4261,7 @@ static bool ParseShader( const char *_text )
 		// imageMaxDimension enforcement
 		else if ( !Q_stricmp( token, "imageMaxDimension" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( token[ 0 ] )
 			{
@@ -4230,7 +4285,7 @@ static bool ParseShader( const char *_text )
 		{
 			shader.polygonOffset = true;
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( token[ 0 ] )
 			{
@@ -4276,12 +4331,12 @@ static bool ParseShader( const char *_text )
 
 			Log::Warn("deprecated keyword '%s' in shader '%s', this was a workaround for a design flaw, there is no need for it", token, shader.name );
 
-			SkipRestOfLine( text );
+			SkipRestOfShaderLine( text );
 			continue;
 		}
 		else if ( r_dpMaterial.Get() && !Q_stricmp( token, "dpoffsetmapping" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !Q_stricmp( token, "none" ) )
 			{
@@ -4321,11 +4376,11 @@ static bool ParseShader( const char *_text )
 			else
 			{
 				Log::Warn("invalid parm for dpoffsetmapping keyword in shader '%s'", shader.name );
-				SkipRestOfLine( text );
+				SkipRestOfShaderLine( text );
 				continue;
 			}
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -4335,7 +4390,7 @@ static bool ParseShader( const char *_text )
 
 			shader.reliefDepthScale = atof( token );
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			// dpoffsetmapping - 2
 			if ( !token[ 0 ] )
@@ -4370,11 +4425,11 @@ static bool ParseShader( const char *_text )
 			else
 			{
 				Log::Warn("invalid parm for dpoffsetmapping keyword in shader '%s'", shader.name );
-				SkipRestOfLine( text );
+				SkipRestOfShaderLine( text );
 				continue;
 			}
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -4400,7 +4455,7 @@ static bool ParseShader( const char *_text )
 		{
 			/*
 			Log::Warn("fogParms keyword not supported in shader '%s'", shader.name);
-			SkipRestOfLine(text);
+			SkipRestOfShaderLine( text );
 
 			*/
 
@@ -4409,7 +4464,7 @@ static bool ParseShader( const char *_text )
 				return false;
 			}
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( !token[ 0 ] )
 			{
@@ -4422,7 +4477,7 @@ static bool ParseShader( const char *_text )
 			shader.sort = Util::ordinal(shaderSort_t::SS_FOG);
 
 			// skip any old gradient directions
-			SkipRestOfLine( text );
+			SkipRestOfShaderLine( text );
 			continue;
 		}
 		// noFog
@@ -4442,7 +4497,7 @@ static bool ParseShader( const char *_text )
 			allowing to set it there or fallback to the default value if is set
 			nowhere. Allowing to set the portal range ther allows to set the
 			range for portals that don't blend with textures. */
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( token[ 0 ] )
 			{
@@ -4471,13 +4526,13 @@ static bool ParseShader( const char *_text )
 		// light <value> determines flaring in q3map, not needed here
 		else if ( !Q_stricmp( token, "light" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 			continue;
 		}
 		// cull <face>
 		else if ( !Q_stricmp( token, "cull" ) )
 		{
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			if ( token[ 0 ] == 0 )
 			{
@@ -4550,7 +4605,7 @@ static bool ParseShader( const char *_text )
 			}
 
 			// get image
-			token = COM_ParseExt( text, false );
+			token = ParseShaderWord( text, false );
 
 			if ( !GL1 )
 			{
@@ -4667,7 +4722,7 @@ static bool ParseShader( const char *_text )
 			const char *p;
 			int index = 0;
 
-			token = COM_ParseExt2( text, false );
+			token = ParseShaderToken( text, false );
 
 			for ( i = 1, p = whenTokens; i < MAX_ALTSHADERS && *p; ++i, p += strlen( p ) + 1 )
 			{
@@ -4686,7 +4741,7 @@ static bool ParseShader( const char *_text )
 			{
 				int tokenLen;
 
-				token = COM_ParseExt( text, false );
+				token = ParseShaderWord( text, false );
 
 				if ( !token[ 0 ] )
 				{
@@ -4714,13 +4769,13 @@ static bool ParseShader( const char *_text )
 			{
 				Log::Warn("disabled DarkPlaces shader parameter '%s' in '%s'", token, shader.name );
 			}
-			SkipRestOfLine( text );
+			SkipRestOfShaderLine( text );
 			continue;
 		}
 		else
 		{
 			Log::Warn("unknown general shader parameter '%s' in '%s'", token, shader.name );
-			SkipRestOfLine( text );
+			SkipRestOfShaderLine( text );
 			continue;
 		}
 	}
@@ -5944,32 +5999,149 @@ FindShaderInShaderText
 Scans the combined text description of all the shader files for
 the given shader name.
 
-return nullptr if not found
+return false if not found
 
-If found, it will return a valid shader
+If found, text is set to read the definition of the shader
 =====================
 */
-static const char    *FindShaderInShaderText( const char *shaderName )
+static bool FindShaderInShaderText( const char *shaderName, shaderText_t *text )
 {
-	const char *token, *p;
-
 	int  i, hash;
 
 	hash = generateHashValue( shaderName, MAX_SHADERTEXT_HASH );
 
 	for ( i = 0; shaderTextHashTable[ hash ][ i ]; i++ )
 	{
-		p = shaderTextHashTable[ hash ][ i ];
-		token = COM_ParseExt2( &p, true );
+		const shaderToken_t *name = shaderTextHashTable[ hash ][ i ];
 
-		if ( !Q_stricmp( token, shaderName ) )
+		if ( !Q_stricmp( s_shaderTokenStrings + name->string, shaderName ) )
 		{
-			return p;
+			*text = { s_shaderText, s_shaderTokenStrings, name + 1, s_shaderTokensEnd, 0 };
+			return true;
 		}
 	}
 
 	// if the shader is not in the table, it must not exist
-	return nullptr;
+	return false;
+}
+
+/*
+====================
+R_GetShaderImageNames
+
+Adds the names of the image files R_FindShader would load for the given
+shader, without parsing it, so that they can be decoded beforehand.
+Shaders that are already registered add nothing.
+Less common ways to reference images (animMap, DarkPlaces extra maps…)
+are not looked for, their images are decoded when the shader is parsed.
+=====================
+*/
+void R_GetShaderImageNames( const char *shaderName, std::vector<std::string> &imageNames )
+{
+	static const struct
+	{
+		const char *keyword;
+		stageType_t type;
+	} imageKeywords[] =
+	{
+		{ "map",             stageType_t::ST_COLORMAP },
+		{ "clampMap",        stageType_t::ST_COLORMAP },
+		{ "diffuseMap",      stageType_t::ST_DIFFUSEMAP },
+		{ "normalMap",       stageType_t::ST_NORMALMAP },
+		{ "bumpMap",         stageType_t::ST_NORMALMAP },
+		{ "normalHeightMap", stageType_t::ST_NORMALMAP },
+		{ "heightMap",       stageType_t::ST_HEIGHTMAP },
+		{ "specularMap",     stageType_t::ST_SPECULARMAP },
+		{ "physicalMap",     stageType_t::ST_PHYSICALMAP },
+		{ "glowMap",         stageType_t::ST_GLOWMAP },
+	};
+
+	char strippedName[ MAX_QPATH ];
+	COM_StripExtension3( shaderName, strippedName, sizeof( strippedName ) );
+
+	int hash = generateHashValue( strippedName, FILE_HASH_SIZE );
+
+	for ( shader_t *sh = shaderHashTable[ hash ]; sh; sh = sh->next )
+	{
+		if ( !Q_stricmp( sh->name, strippedName ) )
+		{
+			return;
+		}
+	}
+
+	shaderText_t text;
+
+	// implicit shader made of the image of the same name
+	if ( !FindShaderInShaderText( strippedName, &text ) )
+	{
+		imageNames.emplace_back( strippedName );
+		return;
+	}
+
+	int depth = 0;
+
+	while ( true )
+	{
+		const char *token = ParseShaderToken( &text, true );
+
+		if ( !token[ 0 ] )
+		{
+			return;
+		}
+
+		if ( token[ 0 ] == '{' )
+		{
+			depth++;
+			continue;
+		}
+
+		if ( token[ 0 ] == '}' )
+		{
+			if ( --depth <= 0 )
+			{
+				return;
+			}
+
+			continue;
+		}
+
+		if ( !Q_stricmp( token, "implicitMap" ) || !Q_stricmp( token, "implicitMask" ) || !Q_stricmp( token, "implicitBlend" ) )
+		{
+			token = ParseShaderToken( &text, false );
+			imageNames.emplace_back( token[ 0 ] && token[ 0 ] != '-' ? token : strippedName );
+			continue;
+		}
+
+		for ( const auto &imageKeyword : imageKeywords )
+		{
+			if ( Q_stricmp( token, imageKeyword.keyword ) )
+			{
+				continue;
+			}
+
+			// the rest of the line, like ParseMap
+			std::string imageName;
+
+			while ( *( token = ParseShaderToken( &text, false ) ) )
+			{
+				if ( !imageName.empty() )
+				{
+					imageName += ' ';
+				}
+
+				imageName += token;
+			}
+
+			// built-in images like $whiteimage and *white are not files
+			if ( !imageName.empty() && imageName[ 0 ] != '$' && imageName[ 0 ] != '*' && imageName[ 0 ] != '_'
+				&& !IsStageTypeDisabled( imageKeyword.type ) )
+			{
+				imageNames.push_back( std::move( imageName ) );
+			}
+
+			break;
+		}
+	}
 }
 
 static void ClearGlobalShader()
@@ -6001,7 +6173,7 @@ shader_t       *R_FindShader( const char *name, int flags )
 	char     strippedName[ MAX_QPATH ];
 	char     fileName[ MAX_QPATH ];
 	int      i, hash, bits;
-	const char     *shaderText;
+	shaderText_t   shaderText;
 	image_t  *image;
 	shader_t *sh;
 
@@ -6044,6 +6216,8 @@ shader_t       *R_FindShader( const char *name, int flags )
 		              strippedName, firstRegistration->registerFlags, flags );
 	}
 
+	shaderLoadTimer_t timer;
+
 	shader.altShader[ 0 ].index = flags; // save for later use (in case of alternative shaders)
 
 	// make sure the render thread is stopped, because we are probably
@@ -6089,9 +6263,7 @@ shader_t       *R_FindShader( const char *name, int flags )
 	}
 
 	// attempt to define shader from an explicit parameter file
-	shaderText = FindShaderInShaderText( strippedName );
-
-	if ( shaderText )
+	if ( FindShaderInShaderText( strippedName, &shaderText ) )
 	{
 		// enable this when building a pak file to get a global list
 		// of all explicit shaders
@@ -6100,7 +6272,7 @@ shader_t       *R_FindShader( const char *name, int flags )
 			Log::Notice("loading explicit shader '%s'", strippedName );
 		}
 
-		if ( !ParseShader( shaderText ) )
+		if ( !ParseShader( &shaderText ) )
 		{
 			// had errors, so use default shader
 			shader.defaultShader = true;
@@ -6513,51 +6685,71 @@ public:
 };
 static ShaderExpCmd shaderExpCmdRegistration;
 
+// A shader or table definition found in a shader file
+struct shaderTextEntry_t
+{
+	size_t offset; // of the name, or of the "table" keyword
+	size_t token; // index of the same
+	int hash; // in shaderTextHashTable, -1 for tables
+};
+
+// A shader file read, tokenized and indexed by LoadShaderFile
+struct shaderFile_t
+{
+	std::string name;
+	std::string text; // unixified, without comments
+	std::vector<shaderToken_t> tokens;
+	std::string tokenStrings;
+	std::vector<shaderTextEntry_t> entries;
+	bool valid;
+};
+
 /*
 ====================
-ScanAndLoadShaderFiles
+LoadShaderFile
 
-Finds and loads all .shader files, combining them into
-a single large text block that can be scanned for shader names
+Reads a shader file, tokenizes it and finds the shaders and tables it
+defines. Runs on the shader loading threads.
 =====================
 */
-static void ScanAndLoadShaderFiles()
+static void LoadShaderFile( shaderFile_t &file )
 {
-	std::vector<std::string> buffers;
-	const char *p;
-	const char *oldp, *token;
-	char *textEnd;
-	const char **hashMem;
-	int  shaderTextHashTableSizes[ MAX_SHADERTEXT_HASH ], hash, size;
-	char filename[ MAX_QPATH ];
-	size_t sum = 0;
+	Log::Debug( "loading '%s' shader file", file.name );
 
-	Log::Debug("----- ScanAndLoadShaderFiles -----" );
+	file.valid = false;
 
-	// load and parse shader files
-	for ( const std::string& basename : FS::PakPath::ListFiles("scripts") )
+	std::error_code err;
+	file.text = FS::PakPath::ReadFile( file.name, err );
+
+	if ( err )
 	{
-		if ( !Str::IsISuffix( ".shader", basename ) )
-		{
-			continue;
-		}
+		Log::Warn( "Couldn't load shader file %s", file.name );
+		return;
+	}
+
+	// ydnar: unixify all shaders
+	COM_FixPath( &file.text[ 0 ] );
 
-		Com_sprintf( filename, sizeof( filename ), "scripts/%s", basename.c_str() );
+	COM_Compress( &file.text[ 0 ] );
+	file.text.resize( strlen( file.text.c_str() ) );
 
-		Log::Debug("loading '%s' shader file", filename );
-		std::error_code err;
-		std::string buffer = FS::PakPath::ReadFile( filename, err );
+	const char *base = file.text.c_str();
+	const char *p = base;
 
-		if ( err )
+	while ( true )
+	{
+		const char *oldp = p;
+		const char *token = COM_ParseExt2( &p, true );
+
+		if ( !*token )
 		{
-			Log::Warn( "Couldn't load shader file %s", filename );
-			continue;
+			break;
 		}
 
-		p = buffer.c_str();
-		bool syntaxError = false;
+		int hash = -1;
 
-		while ( true )
+		// Step over the "table" and the name
+		if ( !Q_stricmp( token, "table" ) )
 		{
 			token = COM_ParseExt2( &p, true );
 
@@ -6565,87 +6757,110 @@ static void ScanAndLoadShaderFiles()
 			{
 				break;
 			}
-
-			// Step over the "table" and the name
-			if ( !Q_stricmp( token, "table" ) )
-			{
-				token = COM_ParseExt2( &p, true );
-
-				if ( !*token )
-				{
-					break;
-				}
-			}
-
-			token = COM_ParseExt2( &p, true );
-
-			if ( token[ 0 ] != '{' || token[ 1 ] != '\0' || !SkipBracedSection_Depth( &p, 1 ) )
-			{
-				Log::Warn("Bad shader file %s has incorrect syntax.", filename );
-				syntaxError = true;
-				break;
-			}
+		}
+		else
+		{
+			hash = generateHashValue( token, MAX_SHADERTEXT_HASH );
 		}
 
-		if ( !syntaxError )
+		token = COM_ParseExt2( &p, true );
+
+		if ( token[ 0 ] != '{' || token[ 1 ] != '\0' || !SkipBracedSection_Depth( &p, 1 ) )
 		{
-			sum += buffer.size();
-			buffers.push_back( std::move( buffer ) );
+			Log::Warn( "Bad shader file %s has incorrect syntax.", file.name );
+			file.entries.clear();
+			return;
 		}
+
+		file.entries.push_back( { size_t( oldp - base ), 0, hash } );
 	}
 
-	// build single large buffer
-	s_shaderText = (char*) ri.Hunk_Alloc( sum + buffers.size() * 2, ha_pref::h_low );
-	s_shaderText[ 0 ] = '\0';
-	textEnd = s_shaderText;
+	TokenizeShaderText( base, file.tokens, file.tokenStrings );
 
-	for ( auto i = buffers.rbegin(); i != buffers.rend(); ++i )
+	// the entries start at the whitespace before their first token
+	for ( shaderTextEntry_t &entry : file.entries )
 	{
-		strcat( textEnd, i->c_str() );
-		strcat( textEnd, "\n" );
-		textEnd += strlen( textEnd );
+		auto first = std::lower_bound( file.tokens.begin(), file.tokens.end(), entry.offset, []( const shaderToken_t &fileToken, size_t offset ) {
+			return fileToken.start < offset;
+		} );
+
+		entry.token = first - file.tokens.begin();
 	}
 
-	// ydnar: unixify all shaders
-	COM_FixPath( s_shaderText );
+	file.valid = true;
+}
 
-	COM_Compress( s_shaderText );
+/*
+====================
+ScanAndLoadShaderFiles
 
-	memset( shaderTextHashTableSizes, 0, sizeof( shaderTextHashTableSizes ) );
-	size = 0;
+Finds and loads all .shader files, combining them into
+a single large text block and the tokens of that text,
+indexed by shader name
+=====================
+*/
+static void ScanAndLoadShaderFiles()
+{
+	const char *token;
+	const shaderToken_t **hashMem;
+	int  shaderTextHashTableSizes[ MAX_SHADERTEXT_HASH ], hash, size;
 
-	p = s_shaderText;
+	Log::Debug("----- ScanAndLoadShaderFiles -----" );
 
-	// look for shader names
-	while ( true )
-	{
-		token = COM_ParseExt2( &p, true );
+	Sys::SteadyClock::time_point start = Sys::SteadyClock::now();
 
-		if ( token[ 0 ] == 0 )
+	std::vector<shaderFile_t> files;
+
+	for ( const std::string& basename : FS::PakPath::ListFiles("scripts") )
+	{
+		if ( Str::IsISuffix( ".shader", basename ) )
 		{
-			break;
+			files.emplace_back();
+			files.back().name = "scripts/" + basename;
 		}
+	}
 
-		// skip shader tables
-		if ( !Q_stricmp( token, "table" ) )
-		{
-			// skip table name
-			token = COM_ParseExt2( &p, true );
+	// read, clean up, tokenize and index the files in parallel
+	shaderWorkers.SetNumThreads( r_shaderLoadThreads.Get() );
+	shaderWorkers.ParallelFor( files.size(), [&files]( int i ) {
+		LoadShaderFile( files[ i ] );
+	} );
 
-			SkipBracedSection( &p );
-		}
-		else
+	// build single large buffers, the last files first so that they take precedence
+	size_t sum = 0, numTokens = 0, stringsSum = 0;
+	memset( shaderTextHashTableSizes, 0, sizeof( shaderTextHashTableSizes ) );
+	size = 0;
+
+	for ( const shaderFile_t &file : files )
+	{
+		if ( file.valid )
 		{
-			hash = generateHashValue( token, MAX_SHADERTEXT_HASH );
-			shaderTextHashTableSizes[ hash ]++;
-			size++;
-			SkipBracedSection( &p );
+			sum += file.text.size() + 1;
+			numTokens += file.tokens.size();
+			stringsSum += file.tokenStrings.size();
+
+			for ( const shaderTextEntry_t &entry : file.entries )
+			{
+				if ( entry.hash >= 0 )
+				{
+					shaderTextHashTableSizes[ entry.hash ]++;
+					size++;
+				}
+			}
 		}
 	}
 
+	s_shaderText = (char*) ri.Hunk_Alloc( sum + 1, ha_pref::h_low );
+	s_shaderTokenStrings = (char*) ri.Hunk_Alloc( stringsSum + 1, ha_pref::h_low );
+	s_shaderTokens = (shaderToken_t*) ri.Hunk_Alloc( ( numTokens + 1 ) * sizeof( shaderToken_t ), ha_pref::h_low );
+	s_shaderTokensEnd = s_shaderTokens;
+
+	std::vector<const shaderToken_t *> tables;
+	size_t textSize = 0, stringsSize = 0;
+
 	size += MAX_SHADERTEXT_HASH;
 
-	hashMem = (const char**) ri.Hunk_Alloc( size * sizeof( char * ), ha_pref::h_low );
+	hashMem = (const shaderToken_t**) ri.Hunk_Alloc( size * sizeof( shaderToken_t * ), ha_pref::h_low );
 
 	for ( int i = 0; i < MAX_SHADERTEXT_HASH; i++ )
 	{
@@ -6655,103 +6870,164 @@ static void ScanAndLoadShaderFiles()
 
 	memset( shaderTextHashTableSizes, 0, sizeof( shaderTextHashTableSizes ) );
 
-	p = s_shaderText;
-
-	// look for shader names
-	while ( true )
+	for ( auto file = files.rbegin(); file != files.rend(); ++file )
 	{
-		oldp = p;
-		token = COM_ParseExt( &p, true );
+		if ( !file->valid )
+		{
+			continue;
+		}
 
-		if ( token[ 0 ] == 0 )
+		char *text = s_shaderText + textSize;
+		memcpy( text, file->text.c_str(), file->text.size() );
+		text[ file->text.size() ] = '\n';
+
+		memcpy( s_shaderTokenStrings + stringsSize, file->tokenStrings.data(), file->tokenStrings.size() );
+
+		shaderToken_t *tokens = s_shaderTokensEnd;
+
+		for ( shaderToken_t fileToken : file->tokens )
 		{
-			break;
+			fileToken.string += stringsSize;
+			fileToken.space += textSize;
+			fileToken.start += textSize;
+			*s_shaderTokensEnd++ = fileToken;
 		}
 
-		// parse shader tables
-		if ( !Q_stricmp( token, "table" ) )
+		// the files are separated by a line break
+		if ( textSize && !file->tokens.empty() )
 		{
-			int           depth;
-			float         values[ FUNCTABLE_SIZE ];
-			int           numValues;
-			shaderTable_t *tb;
-			bool      alreadyCreated;
+			tokens->space = textSize - 1;
+			tokens->lineBreaks++;
+		}
 
-			// zeroes shader table, booleans can be assumed as false
-			table = {};
+		textSize += file->text.size() + 1;
+		stringsSize += file->tokenStrings.size();
 
-			token = COM_ParseExt2( &p, true );
+		for ( const shaderTextEntry_t &entry : file->entries )
+		{
+			if ( entry.hash < 0 )
+			{
+				tables.push_back( tokens + entry.token );
+			}
+			else
+			{
+				hash = entry.hash;
+				shaderTextHashTable[ hash ][ shaderTextHashTableSizes[ hash ]++ ] = tokens + entry.token;
+			}
+		}
+	}
+
+	s_shaderText[ textSize ] = '\0';
+
+	// parse shader tables
+	for ( const shaderToken_t *tableToken : tables )
+	{
+		int           depth;
+		float         values[ FUNCTABLE_SIZE ];
+		int           numValues;
+		shaderTable_t *tb;
+		bool      alreadyCreated;
 
-			Q_strncpyz( table.name, token, sizeof( table.name ) );
+		// zeroes shader table, booleans can be assumed as false
+		table = {};
 
-			// check if already created
-			alreadyCreated = false;
-			hash = generateHashValue( table.name, MAX_SHADERTABLE_HASH );
+		// skip the "table" keyword
+		shaderText_t p = { s_shaderText, s_shaderTokenStrings, tableToken, s_shaderTokensEnd, 0 };
+		ParseShaderToken( &p, true );
+		token = ParseShaderToken( &p, true );
 
-			for ( tb = shaderTableHashTable[ hash ]; tb; tb = tb->next )
+		Q_strncpyz( table.name, token, sizeof( table.name ) );
+
+		// check if already created
+		alreadyCreated = false;
+		hash = generateHashValue( table.name, MAX_SHADERTABLE_HASH );
+
+		for ( tb = shaderTableHashTable[ hash ]; tb; tb = tb->next )
+		{
+			if ( Q_stricmp( tb->name, table.name ) == 0 )
 			{
-				if ( Q_stricmp( tb->name, table.name ) == 0 )
-				{
-					// match found
-					alreadyCreated = true;
-					break;
-				}
+				// match found
+				alreadyCreated = true;
+				break;
 			}
+		}
 
-			depth = 0;
-			numValues = 0;
+		depth = 0;
+		numValues = 0;
 
-			do
-			{
-				token = COM_ParseExt2( &p, true );
+		do
+		{
+			token = ParseShaderToken( &p, true );
 
-				if ( !Q_stricmp( token, "snap" ) )
-				{
-					table.snap = true;
-				}
-				else if ( !Q_stricmp( token, "clamp" ) )
-				{
-					table.clamp = true;
-				}
-				else if ( token[ 0 ] == '{' )
-				{
-					depth++;
-				}
-				else if ( token[ 0 ] == '}' )
-				{
-					depth--;
-				}
-				else if ( token[ 0 ] == ',' )
-				{
-					continue;
-				}
-				else
+			if ( !Q_stricmp( token, "snap" ) )
+			{
+				table.snap = true;
+			}
+			else if ( !Q_stricmp( token, "clamp" ) )
+			{
+				table.clamp = true;
+			}
+			else if ( token[ 0 ] == '{' )
+			{
+				depth++;
+			}
+			else if ( token[ 0 ] == '}' )
+			{
+				depth--;
+			}
+			else if ( token[ 0 ] == ',' )
+			{
+				continue;
+			}
+			else
+			{
+				if ( numValues == FUNCTABLE_SIZE )
 				{
-					if ( numValues == FUNCTABLE_SIZE )
-					{
-						Log::Warn("FUNCTABLE_SIZE hit" );
-						break;
-					}
-
-					values[ numValues++ ] = atof( token );
+					Log::Warn("FUNCTABLE_SIZE hit" );
+					break;
 				}
-			}
-			while ( depth && p );
 
-			if ( !alreadyCreated )
-			{
-				Log::Debug("...generating '%s'", table.name );
-				GeneratePermanentShaderTable( values, numValues );
+				values[ numValues++ ] = atof( token );
 			}
 		}
-		else
-		{
-			hash = generateHashValue( token, MAX_SHADERTEXT_HASH );
-			shaderTextHashTable[ hash ][ shaderTextHashTableSizes[ hash ]++ ] = oldp;
+		while ( depth && p.token );
 
-			SkipBracedSection( &p );
+		if ( !alreadyCreated )
+		{
+			Log::Debug("...generating '%s'", table.name );
+			GeneratePermanentShaderTable( values, numValues );
 		}
 	}
+
+	shaderLoadLog.Verbose( "Loaded %d shader files with %d shaders in %.1f ms using %d threads",
+		files.size(), size - MAX_SHADERTEXT_HASH,
+		std::chrono::duration<float, std::milli>( Sys::SteadyClock::now() - start ).count(),
+		shaderWorkers.GetNumThreads() );
+}
+
+/*
+====================
+R_ResetShaderLoadStats
+====================
+*/
+void R_ResetShaderLoadStats()
+{
+	shaderLoadStats.numShaders = 0;
+	shaderLoadStats.time = {};
+}
+
+/*
+====================
+R_PrintShaderLoadStats
+
+Reports the time spent creating shaders since the last R_ResetShaderLoadStats,
+which includes loading their images.
+====================
+*/
+void R_PrintShaderLoadStats( const char *mapName )
+{
+	shaderLoadLog.Notice( "%s: registered %d shaders in %.1f ms", mapName, shaderLoadStats.numShaders,
+		std::chrono::duration<float, std::milli>( shaderLoadStats.time ).count() );
 }
 
 /*
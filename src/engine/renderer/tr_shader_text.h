@@ -0,0 +1,225 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+// tr_shader_text.h -- the tokens of the shader files
+
+#ifndef TR_SHADER_TEXT_H
+#define TR_SHADER_TEXT_H
+
+#include "qcommon/q_shared.h"
+
+/* The shader files are tokenized by the shader loading threads, the shaders
+are then parsed from these tokens. Offsets are relative to the text and to
+the token strings the tokens were read from. */
+struct shaderToken_t
+{
+	uint32_t string; // NUL-terminated
+	uint32_t space; // whitespace before the token
+	uint32_t start;
+	uint32_t lineBreaks; // in the whitespace before the token
+};
+
+// Reads tokens the way COM_ParseExt2 and SkipRestOfLine read text
+struct shaderText_t
+{
+	const char *text;
+	const char *strings;
+	const shaderToken_t *token; // the next one, nullptr once past the end
+	const shaderToken_t *end;
+	uint32_t lineBreaksRead; // of the ones before the next token
+};
+
+/*
+====================
+TokenizeShaderText
+
+Splits text into the tokens COM_ParseExt2 would return. The text must
+have no comments, like after COM_Compress.
+====================
+*/
+inline void TokenizeShaderText( const char *text, std::vector<shaderToken_t> &tokens, std::string &strings )
+{
+	const char *end = text + strlen( text );
+	const char *p = text;
+
+	while ( true )
+	{
+		const char *space = p;
+		const char *token = COM_ParseExt2( &p, true );
+
+		// an unterminated quoted string leaves p past the end
+		if ( !p || p > end )
+		{
+			break;
+		}
+
+		const char *start = space;
+		uint32_t lineBreaks = 0;
+
+		while ( *start && *start <= ' ' )
+		{
+			lineBreaks += *start++ == '\n';
+		}
+
+		tokens.push_back( { uint32_t( strings.size() ), uint32_t( space - text ), uint32_t( start - text ), lineBreaks } );
+		strings.append( token, strlen( token ) + 1 );
+	}
+}
+
+/*
+====================
+ParseShaderToken
+
+Returns the next token like COM_ParseExt2: an empty string at the end,
+and at the end of the line if line breaks are not allowed.
+====================
+*/
+inline const char *ParseShaderToken( shaderText_t *text, bool allowLineBreaks )
+{
+	static char token[ MAX_TOKEN_CHARS ];
+
+	token[ 0 ] = '\0';
+
+	if ( !text->token )
+	{
+		return token;
+	}
+
+	if ( text->token == text->end )
+	{
+		text->token = nullptr;
+		return token;
+	}
+
+	// like the text, stop at the first token of the next line
+	if ( text->lineBreaksRead < text->token->lineBreaks && !allowLineBreaks )
+	{
+		text->lineBreaksRead = text->token->lineBreaks;
+		return token;
+	}
+
+	Q_strncpyz( token, text->strings + text->token->string, sizeof( token ) );
+	text->token++;
+	text->lineBreaksRead = 0;
+
+	return token;
+}
+
+/*
+====================
+SkipRestOfShaderLine
+
+Skips to the next line break, empty lines being skipped one at a time
+as SkipRestOfLine does.
+====================
+*/
+inline void SkipRestOfShaderLine( shaderText_t *text )
+{
+	if ( !text->token || text->token == text->end )
+	{
+		return;
+	}
+
+	if ( text->lineBreaksRead < text->token->lineBreaks )
+	{
+		text->lineBreaksRead++;
+		return;
+	}
+
+	do
+	{
+		text->token++;
+	}
+	while ( text->token != text->end && !text->token->lineBreaks );
+
+	text->lineBreaksRead = text->token != text->end;
+}
+
+/*
+====================
+ShaderTextPosition
+
+Where the tokens are in the text, for the parsers that read text.
+ShaderTextSeek moves the tokens to where they stopped.
+====================
+*/
+inline const char *ShaderTextPosition( const shaderText_t *text )
+{
+	if ( !text->token || text->token == text->end )
+	{
+		return nullptr;
+	}
+
+	const char *p = text->text + text->token->space;
+
+	for ( uint32_t i = 0; i < text->lineBreaksRead; i++ )
+	{
+		p = strchr( p, '\n' ) + 1;
+	}
+
+	return p;
+}
+
+inline void ShaderTextSeek( shaderText_t *text, const char *p )
+{
+	if ( !p )
+	{
+		text->token = nullptr;
+		return;
+	}
+
+	uint32_t offset = p - text->text;
+
+	while ( text->token != text->end && text->token->start < offset )
+	{
+		text->token++;
+	}
+
+	text->lineBreaksRead = 0;
+
+	if ( text->token != text->end )
+	{
+		for ( const char *c = text->text + text->token->space; c < p; c++ )
+		{
+			text->lineBreaksRead += *c == '\n';
+		}
+	}
+}
+
+// Reads a token delimited by whitespace only, like COM_ParseExt
+inline const char *ParseShaderWord( shaderText_t *text, bool allowLineBreaks )
+{
+	const char *p = ShaderTextPosition( text );
+	const char *token = COM_ParseExt( &p, allowLineBreaks );
+	ShaderTextSeek( text, p );
+
+	return token;
+}
+
+#endif // TR_SHADER_TEXT_H
@@ -0,0 +1,121 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <gtest/gtest.h>
+
+#include "common/Common.h"
+#include "engine/renderer/tr_shader_text.h"
+
+namespace {
+
+// Shader file syntax, with quoted strings, expressions, comments and empty lines
+static const char shaderFile[] =
+    "textures/a/b\n{\n  qer_editorimage textures/a/b.tga\n  surfaceparm nomarks\n  cull none\n"
+    "  {\n    map \"textures/a b/c.tga\"\n    tcMod scroll 0.05 -0.5\n    rgbGen wave sin 0 1 0 .5\n"
+    "    alphaTest 0.5 + 1 * time, 3\n    blendFunc GL_ONE GL_ONE // comment\n  }\n"
+    "  normalFormat -X +Y Z\n  deformVertexes wave 100 sin 3 0 0.2 0.7\n"
+    "  when destroyed \"foo/bar\"\n\n\n  {\n  }\n  sort 6\n}\n"
+    "table sinTable { snap { 0, 0.5, 1.0 } }\nfoo\n{\nx(1,2)y\n}\n";
+
+// Random sequences of reads from the tokens and from the text must return
+// the same strings and reach the end at the same time
+TEST(ShaderTextTest, TokensReadLikeText)
+{
+    std::vector<char> buffer(shaderFile, shaderFile + sizeof(shaderFile));
+    COM_Compress(buffer.data());
+    const char* text = buffer.data();
+
+    std::vector<shaderToken_t> tokens;
+    std::string strings;
+    TokenizeShaderText(text, tokens, strings);
+    ASSERT_FALSE(tokens.empty());
+
+    std::mt19937 rng(3);
+    for (int run = 0; run < 20000; run++) {
+        const char* p = text;
+        shaderText_t t = {text, strings.c_str(), tokens.data(), tokens.data() + tokens.size(), 0};
+
+        // like a shader parsed from the middle of the file
+        if (run % 2) {
+            size_t k = rng() % tokens.size();
+            t.token = tokens.data() + k;
+            p = text + tokens[k].space;
+        }
+
+        std::string ops;
+        for (int i = 0; i < 40; i++) {
+            int op = rng() % 7;
+            std::string expected, token;
+            switch (op) {
+            case 0:
+            case 1:
+                expected = COM_ParseExt2(&p, op == 0);
+                token = ParseShaderToken(&t, op == 0);
+                break;
+            case 2:
+                // SkipRestOfLine would step over the end of the text
+                if (p && *p) {
+                    SkipRestOfLine(&p);
+                }
+                SkipRestOfShaderLine(&t);
+                break;
+            case 3:
+            case 4:
+                expected = COM_ParseExt(&p, op == 3);
+                token = ParseShaderWord(&t, op == 3);
+                break;
+            case 5: {
+                // a parser reading the text from where the tokens are
+                const char* q = ShaderTextPosition(&t);
+                expected = COM_ParseExt2(&p, false);
+                token = COM_ParseExt2(&q, false);
+                ShaderTextSeek(&t, q);
+                break;
+            }
+            case 6: {
+                const char* q = ShaderTextPosition(&t);
+                if (p && *p) {
+                    SkipRestOfLine(&p);
+                }
+                if (q) {
+                    SkipRestOfLine(&q);
+                    ShaderTextSeek(&t, q);
+                }
+                break;
+            }
+            }
+            ops += char('0' + op);
+            ASSERT_EQ(expected, token) << "run " << run << " ops " << ops;
+            ASSERT_EQ(p == nullptr, t.token == nullptr) << "run " << run << " ops " << ops;
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,203 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+// tr_skinning.h -- vertex skinning on the CPU, when it can't be done by the GPU
+
+#ifndef TR_SKINNING_H
+#define TR_SKINNING_H
+
+#include "qcommon/q_shared.h"
+
+/* Instead of transforming a vertex by each of its bones with quaternions
+and summing the results, the bones of a surface are converted once to
+3×4 matrices. Each vertex blends the matrices of its bones with its
+weights, then gets transformed by the blended matrix. Since skinning is
+linear in the bone transforms, both give the same vertices. */
+
+// The columns of a bone transform, padded to 4 floats
+struct alignas( 16 ) skinningBone_t
+{
+	vec4_t matrix[ 4 ]; // scaled rotation, then translation
+	vec4_t rotation[ 3 ]; // unscaled, for the normal vectors
+};
+
+inline void R_SetSkinningBones( const transform_t *bones, int numBones, skinningBone_t *out )
+{
+	for ( int i = 0; i < numBones; i++ )
+	{
+		const transform_t &t = bones[ i ];
+		skinningBone_t &bone = out[ i ];
+
+		float x = t.rot[ 0 ], y = t.rot[ 1 ], z = t.rot[ 2 ], w = t.rot[ 3 ];
+
+		Vector4Set( bone.rotation[ 0 ], 1.0f - 2.0f * ( y * y + z * z ), 2.0f * ( x * y + z * w ), 2.0f * ( x * z - y * w ), 0.0f );
+		Vector4Set( bone.rotation[ 1 ], 2.0f * ( x * y - z * w ), 1.0f - 2.0f * ( x * x + z * z ), 2.0f * ( y * z + x * w ), 0.0f );
+		Vector4Set( bone.rotation[ 2 ], 2.0f * ( x * z + y * w ), 2.0f * ( y * z - x * w ), 1.0f - 2.0f * ( x * x + y * y ), 0.0f );
+
+		for ( int j = 0; j < 3; j++ )
+		{
+			Vector4Set( bone.matrix[ j ], bone.rotation[ j ][ 0 ] * t.scale, bone.rotation[ j ][ 1 ] * t.scale,
+				bone.rotation[ j ][ 2 ] * t.scale, 0.0f );
+		}
+
+		Vector4Set( bone.matrix[ 3 ], t.trans[ 0 ], t.trans[ 1 ], t.trans[ 2 ], 0.0f );
+	}
+}
+
+#if defined( DAEMON_USE_ARCH_INTRINSICS_i686_sse )
+// column0 * v.x + column1 * v.y + column2 * v.z
+inline __m128 sseSkinningTransform( const __m128 *columns, const vec3_t v )
+{
+	__m128 out = _mm_mul_ps( columns[ 0 ], _mm_set1_ps( v[ 0 ] ) );
+	out = _mm_add_ps( out, _mm_mul_ps( columns[ 1 ], _mm_set1_ps( v[ 1 ] ) ) );
+	return _mm_add_ps( out, _mm_mul_ps( columns[ 2 ], _mm_set1_ps( v[ 2 ] ) ) );
+}
+
+/*
+R_SkinPosition
+
+Returns in out the position blended by the first numWeights bones of a vertex.
+*/
+template<typename Index>
+inline void R_SkinPosition( const skinningBone_t *bones, const Index *indexes, const float *weights, int numWeights,
+	const vec3_t position, vec3_t out )
+{
+	__m128 matrix[ 4 ] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+
+	for ( int i = 0; i < numWeights; i++ )
+	{
+		const skinningBone_t &bone = bones[ indexes[ i ] ];
+		__m128 weight = _mm_set1_ps( weights[ i ] );
+
+		for ( int j = 0; j < 4; j++ )
+		{
+			matrix[ j ] = _mm_add_ps( matrix[ j ], _mm_mul_ps( weight, _mm_load_ps( bone.matrix[ j ] ) ) );
+		}
+	}
+
+	sseStoreVec3( _mm_add_ps( sseSkinningTransform( matrix, position ), matrix[ 3 ] ), out );
+}
+
+/*
+R_SkinVertex
+
+Same as R_SkinPosition, also rotating the normal, tangent and binormal,
+which are not normalized.
+*/
+template<typename Index>
+inline void R_SkinVertex( const skinningBone_t *bones, const Index *indexes, const float *weights, int numWeights,
+	const vec3_t position, const vec3_t normal, const vec3_t tangent, const vec3_t binormal,
+	vec3_t outPosition, vec3_t outNormal, vec3_t outTangent, vec3_t outBinormal )
+{
+	__m128 matrix[ 4 ] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+	__m128 rotation[ 3 ] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+
+	for ( int i = 0; i < numWeights; i++ )
+	{
+		const skinningBone_t &bone = bones[ indexes[ i ] ];
+		__m128 weight = _mm_set1_ps( weights[ i ] );
+
+		for ( int j = 0; j < 4; j++ )
+		{
+			matrix[ j ] = _mm_add_ps( matrix[ j ], _mm_mul_ps( weight, _mm_load_ps( bone.matrix[ j ] ) ) );
+		}
+
+		for ( int j = 0; j < 3; j++ )
+		{
+			rotation[ j ] = _mm_add_ps( rotation[ j ], _mm_mul_ps( weight, _mm_load_ps( bone.rotation[ j ] ) ) );
+		}
+	}
+
+	sseStoreVec3( _mm_add_ps( sseSkinningTransform( matrix, position ), matrix[ 3 ] ), outPosition );
+	sseStoreVec3( sseSkinningTransform( rotation, normal ), outNormal );
+	sseStoreVec3( sseSkinningTransform( rotation, tangent ), outTangent );
+	sseStoreVec3( sseSkinningTransform( rotation, binormal ), outBinormal );
+}
+#else
+// column0 * v.x + column1 * v.y + column2 * v.z
+inline void R_SkinningTransform( const vec4_t *columns, const vec3_t v, vec3_t out )
+{
+	for ( int i = 0; i < 3; i++ )
+	{
+		out[ i ] = columns[ 0 ][ i ] * v[ 0 ] + columns[ 1 ][ i ] * v[ 1 ] + columns[ 2 ][ i ] * v[ 2 ];
+	}
+}
+
+template<typename Index>
+inline void R_SkinPosition( const skinningBone_t *bones, const Index *indexes, const float *weights, int numWeights,
+	const vec3_t position, vec3_t out )
+{
+	vec4_t matrix[ 4 ] = {};
+
+	for ( int i = 0; i < numWeights; i++ )
+	{
+		const skinningBone_t &bone = bones[ indexes[ i ] ];
+
+		for ( int j = 0; j < 4; j++ )
+		{
+			VectorMA( matrix[ j ], weights[ i ], bone.matrix[ j ], matrix[ j ] );
+		}
+	}
+
+	R_SkinningTransform( matrix, position, out );
+	VectorAdd( out, matrix[ 3 ], out );
+}
+
+template<typename Index>
+inline void R_SkinVertex( const skinningBone_t *bones, const Index *indexes, const float *weights, int numWeights,
+	const vec3_t position, const vec3_t normal, const vec3_t tangent, const vec3_t binormal,
+	vec3_t outPosition, vec3_t outNormal, vec3_t outTangent, vec3_t outBinormal )
+{
+	vec4_t matrix[ 4 ] = {};
+	vec4_t rotation[ 3 ] = {};
+
+	for ( int i = 0; i < numWeights; i++ )
+	{
+		const skinningBone_t &bone = bones[ indexes[ i ] ];
+
+		for ( int j = 0; j < 4; j++ )
+		{
+			VectorMA( matrix[ j ], weights[ i ], bone.matrix[ j ], matrix[ j ] );
+		}
+
+		for ( int j = 0; j < 3; j++ )
+		{
+			VectorMA( rotation[ j ], weights[ i ], bone.rotation[ j ], rotation[ j ] );
+		}
+	}
+
+	R_SkinningTransform( matrix, position, outPosition );
+	VectorAdd( outPosition, matrix[ 3 ], outPosition );
+	R_SkinningTransform( rotation, normal, outNormal );
+	R_SkinningTransform( rotation, tangent, outTangent );
+	R_SkinningTransform( rotation, binormal, outBinormal );
+}
+#endif
+
+#endif // TR_SKINNING_H
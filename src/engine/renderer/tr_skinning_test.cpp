@@ -0,0 +1,209 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <gtest/gtest.h>
+
+#include "common/Common.h"
+#include "engine/renderer/tr_skinning.h"
+
+namespace {
+
+static void RandomTransform(std::mt19937& rng, transform_t* t)
+{
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    quat_t rot = { dist(rng), dist(rng), dist(rng), dist(rng) };
+    QuatNormalize(rot);
+    vec3_t trans = { 50.0f * dist(rng), 50.0f * dist(rng), 50.0f * dist(rng) };
+    TransInitRotationQuat(rot, t);
+    TransAddTranslation(trans, t);
+    TransInsScale(1.0f + 0.5f * dist(rng), t);
+}
+
+// The vertices of a model, with the same layout as IQM ones
+struct TestModel {
+    int numJoints;
+    std::vector<transform_t> poses[2];
+    std::vector<float> positions, normals, tangents, bitangents;
+    std::vector<int> blendIndexes;
+    std::vector<float> blendWeights;
+};
+
+static TestModel RandomModel(std::mt19937& rng, int numJoints, int numVertexes)
+{
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    TestModel model;
+    model.numJoints = numJoints;
+    for (std::vector<transform_t>& pose : model.poses) {
+        pose.resize(numJoints);
+        for (transform_t& t : pose) {
+            RandomTransform(rng, &t);
+        }
+    }
+    for (int i = 0; i < 3 * numVertexes; i++) {
+        model.positions.push_back(20.0f * dist(rng));
+        model.normals.push_back(dist(rng));
+        model.tangents.push_back(dist(rng));
+        model.bitangents.push_back(dist(rng));
+    }
+    for (int i = 0; i < numVertexes; i++) {
+        float weights[4] = { 1.0f, std::abs(dist(rng)), std::abs(dist(rng)), std::abs(dist(rng)) };
+        float sum = weights[0] + weights[1] + weights[2] + weights[3];
+        for (float weight : weights) {
+            model.blendIndexes.push_back(rng() % numJoints);
+            model.blendWeights.push_back(weight / sum);
+        }
+    }
+    return model;
+}
+
+// Interpolates the poses like IQMBuildSkeleton does
+static void LerpSkeleton(const TestModel& model, float frac, transform_t* bones)
+{
+    for (int i = 0; i < model.numJoints; i++) {
+        TransStartLerp(&bones[i]);
+        TransAddWeight(1.0f - frac, &model.poses[0][i], &bones[i]);
+        TransAddWeight(frac, &model.poses[1][i], &bones[i]);
+        TransEndLerp(&bones[i]);
+    }
+}
+
+// Transforms the vertices by each of their bones, as Tess_SurfaceIQM did
+static void SkinWithTransforms(const TestModel& model, const transform_t* bones, std::vector<float>& out)
+{
+    size_t numVertexes = model.positions.size() / 3;
+    out.resize(12 * numVertexes);
+    for (size_t i = 0; i < numVertexes; i++) {
+        vec3_t position = {}, normal = {}, tangent = {}, binormal = {};
+        for (size_t j = 4 * i; j < 4 * i + 4; j++) {
+            const transform_t* bone = &bones[model.blendIndexes[j]];
+            float weight = model.blendWeights[j];
+            vec3_t tmp;
+            TransformPoint(bone, &model.positions[3 * i], tmp);
+            VectorMA(position, weight, tmp, position);
+            TransformNormalVector(bone, &model.normals[3 * i], tmp);
+            VectorMA(normal, weight, tmp, normal);
+            TransformNormalVector(bone, &model.tangents[3 * i], tmp);
+            VectorMA(tangent, weight, tmp, tangent);
+            TransformNormalVector(bone, &model.bitangents[3 * i], tmp);
+            VectorMA(binormal, weight, tmp, binormal);
+        }
+        VectorCopy(position, &out[12 * i]);
+        VectorCopy(normal, &out[12 * i + 3]);
+        VectorCopy(tangent, &out[12 * i + 6]);
+        VectorCopy(binormal, &out[12 * i + 9]);
+    }
+}
+
+static void SkinWithMatrices(const TestModel& model, const transform_t* bones, skinningBone_t* skinningBones, std::vector<float>& out)
+{
+    size_t numVertexes = model.positions.size() / 3;
+    out.resize(12 * numVertexes);
+    R_SetSkinningBones(bones, model.numJoints, skinningBones);
+    for (size_t i = 0; i < numVertexes; i++) {
+        R_SkinVertex(skinningBones, &model.blendIndexes[4 * i], &model.blendWeights[4 * i], 4,
+            &model.positions[3 * i], &model.normals[3 * i], &model.tangents[3 * i], &model.bitangents[3 * i],
+            &out[12 * i], &out[12 * i + 3], &out[12 * i + 6], &out[12 * i + 9]);
+    }
+}
+
+TEST(SkinningTest, MatchesBoneTransforms)
+{
+    std::mt19937 rng(64);
+    TestModel model = RandomModel(rng, 40, 500);
+    std::vector<transform_t> bones(model.numJoints);
+    std::vector<skinningBone_t> skinningBones(model.numJoints);
+    LerpSkeleton(model, 0.3f, bones.data());
+
+    std::vector<float> expected, actual;
+    SkinWithTransforms(model, bones.data(), expected);
+    SkinWithMatrices(model, bones.data(), skinningBones.data(), actual);
+
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_NEAR(expected[i], actual[i], 1e-3f * (1.0f + std::abs(expected[i]))) << "at " << i;
+    }
+}
+
+TEST(SkinningTest, PositionOnly)
+{
+    std::mt19937 rng(3);
+    TestModel model = RandomModel(rng, 10, 100);
+    std::vector<transform_t> bones(model.numJoints);
+    std::vector<skinningBone_t> skinningBones(model.numJoints);
+    LerpSkeleton(model, 0.8f, bones.data());
+    R_SetSkinningBones(bones.data(), model.numJoints, skinningBones.data());
+
+    std::vector<float> expected;
+    SkinWithTransforms(model, bones.data(), expected);
+
+    for (size_t i = 0; i < model.positions.size() / 3; i++) {
+        vec3_t position;
+        R_SkinPosition(skinningBones.data(), &model.blendIndexes[4 * i], &model.blendWeights[4 * i], 4,
+            &model.positions[3 * i], position);
+        for (int j = 0; j < 3; j++) {
+            EXPECT_NEAR(expected[12 * i + j], position[j], 1e-3f * (1.0f + std::abs(position[j])));
+        }
+    }
+}
+
+TEST(SkinningTest, DISABLED_Benchmark)
+{
+    // 64 animated models, each like a player model
+    std::mt19937 rng(64);
+    std::vector<TestModel> models;
+    for (int i = 0; i < 64; i++) {
+        models.push_back(RandomModel(rng, 64, 3000));
+    }
+    std::vector<transform_t> bones(64);
+    std::vector<skinningBone_t> skinningBones(64);
+    std::vector<float> out;
+
+    const int rounds = 20;
+    auto time = [&](const char* name, const std::function<void(const TestModel&)>& skin) {
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (const TestModel& model : models) {
+                LerpSkeleton(model, round / float(rounds), bones.data());
+                skin(model);
+            }
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        Log::Notice("%s: %.2f ms per frame of %d models", name, ns * 1e-6 / rounds, models.size());
+    };
+
+    time("per bone transforms", [&](const TestModel& model) {
+        SkinWithTransforms(model, bones.data(), out);
+    });
+    time("blended matrices", [&](const TestModel& model) {
+        SkinWithMatrices(model, bones.data(), skinningBones.data(), out);
+    });
+}
+
+} // namespace
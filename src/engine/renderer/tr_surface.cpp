@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "tr_local.h"
 #include "gl_shader.h"
 #include "Material.h"
+#include "tr_skinning.h"
 
 /*
 ==============================================================================
@@ -41,6 +42,7 @@ use the shader system.
 */
 
 static transform_t bones[ MAX_BONES ];
+static skinningBone_t skinningBones[ MAX_BONES ];
 
 /*
 ==============
@@ -1054,29 +1056,16 @@ static void Tess_SurfaceMD5( md5Surface_t *srf )
 	shaderVertex_t *tessVertex = tess.verts + tess.numVertexes;
 	shaderVertex_t *lastVertex = tessVertex + srf->numVerts;
 
+	R_SetSkinningBones( bones, model->numBones, skinningBones );
+
 	// Deform the vertices by the lerped bones.
 	if ( tess.skipTangents )
 	{
 		for ( ; tessVertex < lastVertex; tessVertex++,
 			surfaceVertex++ )
 		{
-			vec3_t position = {};
-
-			float *boneWeight = surfaceVertex->boneWeights;
-			float *lastWeight = boneWeight + surfaceVertex->numWeights;
-			uint32_t *boneIndex = surfaceVertex->boneIndexes;
-			vec4_t *surfacePosition = &surfaceVertex->position;
-
-			for ( ; boneWeight < lastWeight; boneWeight++,
-				boneIndex++ )
-			{
-				vec3_t tmp;
-
-				TransformPoint( &bones[ *boneIndex ], *surfacePosition, tmp );
-				VectorMA( position, *boneWeight, tmp, position );
-			}
-
-			VectorCopy( position, tessVertex->xyz );
+			R_SkinPosition( skinningBones, surfaceVertex->boneIndexes, surfaceVertex->boneWeights, surfaceVertex->numWeights,
+				surfaceVertex->position, tessVertex->xyz );
 
 			Vector2Copy( surfaceVertex->texCoords, tessVertex->texCoords );
 		}
@@ -1086,38 +1075,15 @@ static void Tess_SurfaceMD5( md5Surface_t *srf )
 		for ( ; tessVertex < lastVertex; tessVertex++,
 			surfaceVertex++ )
 		{
-			vec3_t tangent = {}, binormal = {}, normal = {}, position = {};
-
-			float *boneWeight = surfaceVertex->boneWeights;
-			float *lastWeight = boneWeight + surfaceVertex->numWeights;
-			uint32_t *boneIndex = surfaceVertex->boneIndexes;
-			vec4_t *surfacePosition = &surfaceVertex->position;
-			vec4_t *surfaceNormal = &surfaceVertex->normal;
-			vec4_t *surfaceTangent = &surfaceVertex->tangent;
-			vec4_t *surfaceBinormal = &surfaceVertex->binormal;
-
-			for ( ; boneWeight < lastWeight; boneWeight++,
-				boneIndex++ )
-			{
-				vec3_t tmp;
-
-				TransformPoint( &bones[ *boneIndex ], *surfacePosition, tmp );
-				VectorMA( position, *boneWeight, tmp, position );
+			vec3_t tangent, binormal, normal;
 
-				TransformNormalVector( &bones[ *boneIndex ], *surfaceNormal, tmp );
-				VectorMA( normal, *boneWeight, tmp, normal );
-
-				TransformNormalVector( &bones[ *boneIndex ], *surfaceTangent, tmp );
-				VectorMA( tangent, *boneWeight, tmp, tangent );
-
-				TransformNormalVector( &bones[ *boneIndex ], *surfaceBinormal, tmp );
-				VectorMA( binormal, *boneWeight, tmp, binormal );
-			}
+			R_SkinVertex( skinningBones, surfaceVertex->boneIndexes, surfaceVertex->boneWeights, surfaceVertex->numWeights,
+				surfaceVertex->position, surfaceVertex->normal, surfaceVertex->tangent, surfaceVertex->binormal,
+				tessVertex->xyz, normal, tangent, binormal );
 
 			VectorNormalizeFast( normal );
 			VectorNormalizeFast( tangent );
 			VectorNormalizeFast( binormal );
-			VectorCopy( position, tessVertex->xyz );
 
 			R_TBNtoQtangentsFast( tangent, binormal, normal, tessVertex->qtangents );
 
@@ -1129,6 +1095,24 @@ static void Tess_SurfaceMD5( md5Surface_t *srf )
 	tess.numVertexes += srf->numVerts;
 }
 
+// Keeps the bones of an IQM vertex that have a weight
+static int IQMVertexWeights( const byte *blendIndexes, const byte *blendWeights, float weightFactor, byte *indexes, float *weights )
+{
+	int numWeights = 0;
+
+	for ( int i = 0; i < 4; i++ )
+	{
+		if ( blendWeights[ i ] != 0 )
+		{
+			indexes[ numWeights ] = blendIndexes[ i ];
+			weights[ numWeights ] = blendWeights[ i ] * weightFactor;
+			numWeights++;
+		}
+	}
+
+	return numWeights;
+}
+
 /*
 =================
 Tess_SurfaceIQM
@@ -1246,83 +1230,46 @@ void Tess_SurfaceIQM( srfIQModel_t *surf ) {
 	if ( model->num_joints > 0 && model->blendWeights && model->blendIndexes )
 	{
 		const float weightFactor = 1.0f / 255.0f;
+		byte *modelBlendIndex = model->blendIndexes + 4 * firstVertex;
+		byte *modelBlendWeight = model->blendWeights + 4 * firstVertex;
+
+		R_SetSkinningBones( bones, model->num_joints, skinningBones );
 
 		if ( tess.skipTangents )
 		{
-			byte *modelBlendIndex = model->blendIndexes + 4 * firstVertex;
-			byte *modelBlendWeight = model->blendWeights + 4 * firstVertex;
-
 			for ( ; tessVertex < lastVertex; tessVertex++,
 				modelPosition += 3, modelNormal += 3,
 				modelTangent += 3, modelBitangent += 3,
-				modelTexcoord += 2 )
+				modelTexcoord += 2, modelBlendIndex += 4, modelBlendWeight += 4 )
 			{
-				vec3_t position = {};
-
-				byte *lastBlendIndex = modelBlendIndex + 4;
-
-				for ( ; modelBlendIndex < lastBlendIndex; modelBlendIndex++,
-					modelBlendWeight++ )
-				{
-					if ( *modelBlendWeight == 0 )
-					{
-						continue;
-					}
-
-					float weight = *modelBlendWeight * weightFactor;
-					vec3_t tmp;
+				float weights[ 4 ];
+				byte indexes[ 4 ];
+				int numWeights = IQMVertexWeights( modelBlendIndex, modelBlendWeight, weightFactor, indexes, weights );
 
-					TransformPoint( &bones[ *modelBlendIndex ], modelPosition, tmp );
-					VectorMA( position, weight, tmp, position );
-				}
-
-				VectorCopy( position, tessVertex->xyz );
+				R_SkinPosition( skinningBones, indexes, weights, numWeights, modelPosition, tessVertex->xyz );
 
 				Vector2Copy( modelTexcoord, tessVertex->texCoords );
 			}
 		}
 		else
 		{
-			byte *modelBlendIndex = model->blendIndexes + 4 * firstVertex;
-			byte *modelBlendWeight = model->blendWeights + 4 * firstVertex;
-
 			for ( ; tessVertex < lastVertex; tessVertex++,
 				modelPosition += 3, modelNormal += 3,
 				modelTangent += 3, modelBitangent += 3,
-				modelTexcoord += 2 )
+				modelTexcoord += 2, modelBlendIndex += 4, modelBlendWeight += 4 )
 			{
-				vec3_t position = {}, tangent = {}, binormal = {}, normal = {};
-
-				byte *lastBlendIndex = modelBlendIndex + 4;
-
-				for ( ; modelBlendIndex < lastBlendIndex; modelBlendIndex++,
-					modelBlendWeight++ )
-				{
-					if ( *modelBlendWeight == 0 )
-					{
-						continue;
-					}
-
-					float weight = *modelBlendWeight * weightFactor;
-					vec3_t tmp;
-
-					TransformPoint( &bones[ *modelBlendIndex ], modelPosition, tmp );
-					VectorMA( position, weight, tmp, position );
-
-					TransformNormalVector( &bones[ *modelBlendIndex ], modelNormal, tmp );
-					VectorMA( normal, weight, tmp, normal );
-
-					TransformNormalVector( &bones[ *modelBlendIndex ], modelTangent, tmp );
-					VectorMA( tangent, weight, tmp, tangent );
+				vec3_t tangent, binormal, normal;
+				float weights[ 4 ];
+				byte indexes[ 4 ];
+				int numWeights = IQMVertexWeights( modelBlendIndex, modelBlendWeight, weightFactor, indexes, weights );
 
-					TransformNormalVector( &bones[ *modelBlendIndex ], modelBitangent, tmp );
-					VectorMA( binormal, weight, tmp, binormal );
-				}
+				R_SkinVertex( skinningBones, indexes, weights, numWeights,
+					modelPosition, modelNormal, modelTangent, modelBitangent,
+					tessVertex->xyz, normal, tangent, binormal );
 
 				VectorNormalizeFast( normal );
 				VectorNormalizeFast( tangent );
 				VectorNormalizeFast( binormal );
-				VectorCopy( position, tessVertex->xyz );
 
 				R_TBNtoQtangentsFast( tangent, binormal, normal, tessVertex->qtangents );
 
@@ -40,6 +40,7 @@ Maryland 20850 USA.
 #include "sg_api.h"
 #include "framework/VirtualMachine.h"
 #include "framework/CommonVMServices.h"
+#include "framework/CommandBufferHost.h"
 
 //=============================================================================
 
@@ -48,10 +49,16 @@ Maryland 20850 USA.
 
 #define MAX_BPS_WINDOW 20 // NERVE - SMF - net debugging
 
+// number of uint64_t needed for a bit per entity
+#define ENTITY_MASK_WORDS ( MAX_GENTITIES / 64 )
+
 struct svEntity_t
 {
 	entityState_t        baseline; // for delta compression of initial sighting
-	int                  snapshotCounter; // used to prevent double adding from portal views
+
+	// where the entity is filed in the cluster index, see SV_UpdateEntityIndex
+	int                  numIndexClusters; // -1 if in alwaysCheckedEntities
+	int                  indexClusters[ MAX_ENT_CLUSTERS ];
 };
 
 enum class serverState_t
@@ -67,7 +74,6 @@ struct server_t
 	bool      restarting; // if true, send configstring changes during SS_LOADING
 	int           serverId; // changes each server start
 	int           restartedServerId; // serverId before a map_restart
-	int             snapshotCounter; // incremented for each snapshot built
 	int             timeResidual; // <= 1000 / sv_frame->value
 	int             nextFrameTime; // when time > nextFrameTime, process world
 
@@ -86,6 +92,12 @@ struct server_t
 	int            gentitySize;
 	int            num_entities; // current number, <= MAX_GENTITIES
 
+	// linked entities by the PVS clusters they touch, so that snapshots only
+	// have to look at the entities of the clusters the client can see
+	std::vector<std::vector<int>> clusterEntities;
+	uint64_t       alwaysCheckedEntities[ ENTITY_MASK_WORDS ]; // not filed by cluster
+	int            numIndexedEntities;
+
 	OpaquePlayerState *gameClients;
 	int            gameClientSize; // will be > sizeof(playerState_t) due to game private data
 
@@ -244,7 +256,7 @@ struct serverStatic_t
 
 	client_t      *clients; // [sv_maxClients.Get()];
 	int           numSnapshotEntities; // sv_maxClients.Get()*PACKET_BACKUP*MAX_PACKET_ENTITIES
-	int           nextSnapshotEntities; // next snapshotEntities to use
+	std::atomic<int> nextSnapshotEntities; // next snapshotEntities to use, reserved by snapshot builders
 	std::unique_ptr<entityState_t[]> snapshotEntities; // [numSnapshotEntities]
 	receipt_t     infoReceipts[ MAX_INFO_RECEIPTS ];
 
@@ -277,11 +289,22 @@ public:
 
 private:
 	virtual void Syscall(uint32_t id, Util::Reader reader, IPC::Channel& channel) override final;
+	virtual int ConsumeCommandBuffer() override final;
 	void QVMSyscall(int syscallNum, Util::Reader& reader, IPC::Channel& channel);
 
 	IPC::SharedMemory shmRegion;
 
 	std::unique_ptr<VM::CommonVMServices> services;
+
+	// One-way messages sent by the sgame during a frame, they are handled
+	// before anything the sgame sends on the socket
+	class CmdBuffer: public IPC::CommandBufferHost {
+	public:
+		CmdBuffer(std::string name);
+		virtual void HandleCommandBufferSyscall(int major, int minor, Util::Reader& reader) override final;
+	};
+
+	CmdBuffer cmdBuffer;
 };
 
 //=============================================================================
@@ -379,6 +402,7 @@ void SV_WriteDownloadToClient( client_t *cl, msg_t *msg );
 void SV_AddServerCommand( client_t *client, const char *cmd );
 void SV_UpdateServerCommandsToClient( client_t *client, msg_t *msg );
 void SV_SendMessageToClient( msg_t *msg, client_t *client );
+void SV_UpdateEntityIndex();
 void SV_SendClientMessages();
 void SV_SendClientSnapshot( client_t *client );
 
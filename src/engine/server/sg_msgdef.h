@@ -63,6 +63,8 @@ using DropClientMsg = IPC::SyncMessage<
 using SendServerCommandMsg = IPC::SyncMessage<
     IPC::Message<IPC::Id<VM::QVM, G_SEND_SERVER_COMMAND>, int, std::string>
 >;
+// The same without waiting for the engine, sent through the command buffer
+using BufferedServerCommandMsg = IPC::Message<IPC::Id<VM::QVM, G_SEND_SERVER_COMMAND>, int, std::string>;
 using SetConfigStringMsg = IPC::Message<IPC::Id<VM::QVM, G_SET_CONFIGSTRING>, int, std::string>;
 using GetConfigStringMsg = IPC::SyncMessage<
     IPC::Message<IPC::Id<VM::QVM, G_GET_CONFIGSTRING>, int, int>,
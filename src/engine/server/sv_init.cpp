@@ -590,6 +590,8 @@ void SV_FinalCommand( char *cmd, bool disconnect )
 	int      i, j;
 	client_t *cl;
 
+	SV_UpdateEntityIndex();
+
 	// send it twice, ignoring rate
 	for ( j = 0; j < 2; j++ )
 	{
@@ -42,6 +42,7 @@ Maryland 20850 USA.
 #include "framework/CommandSystem.h"
 #include "framework/CvarSystem.h"
 #include "framework/Network.h"
+#include "framework/Profiler.h"
 #include "qcommon/sys.h"
 
 // These two structs have the same lifetime... both are cleared when the sgame exits
@@ -1072,6 +1073,7 @@ SV_PacketEvent
 */
 void SV_PacketEvent( const netadr_t& from, msg_t *msg )
 {
+	Profiler::Zone zone( "SV_PacketEvent" );
 	int      i;
 	client_t *cl;
 	int      qport;
@@ -1299,6 +1301,107 @@ int SV_FrameMsec()
 }
 
 
+/*
+==================
+Frame timing
+
+How late dedicated server frames start compared to when they were due,
+in buckets of FRAME_LATENESS_BUCKET_USEC
+==================
+*/
+static const int FRAME_LATENESS_BUCKET_USEC = 10;
+static const int FRAME_LATENESS_BUCKETS = 2000; // the last one also counts anything later
+
+static struct
+{
+	uint64_t frames;
+	uint64_t buckets[ FRAME_LATENESS_BUCKETS ];
+	Sys::SteadyClock::duration max;
+} frameLateness;
+
+/*
+==================
+SV_RecordFrameLateness
+==================
+*/
+void SV_RecordFrameLateness( Sys::SteadyClock::duration lateness )
+{
+	if ( !com_sv_running.Get() )
+	{
+		return;
+	}
+
+	auto usec = std::chrono::duration_cast<std::chrono::microseconds>( lateness ).count();
+	int bucket = Math::Clamp<int64_t>( usec / FRAME_LATENESS_BUCKET_USEC, 0, FRAME_LATENESS_BUCKETS - 1 );
+
+	frameLateness.frames++;
+	frameLateness.buckets[ bucket ]++;
+	frameLateness.max = std::max( frameLateness.max, lateness );
+}
+
+class FrameTimingCmd : public Cmd::StaticCmd
+{
+public:
+	FrameTimingCmd():
+		StaticCmd("frametiming", Cmd::SERVER, "Shows how late the dedicated server frames started, 'frametiming reset' starts over")
+	{}
+
+	void Run(const Cmd::Args& args) const override
+	{
+		if ( args.Argc() == 2 && args.Argv( 1 ) == "reset" )
+		{
+			ResetStruct( frameLateness );
+			return;
+		}
+
+		if ( args.Argc() != 1 )
+		{
+			PrintUsage( args, "[reset]" );
+			return;
+		}
+
+		if ( !frameLateness.frames )
+		{
+			Print( "No server frame was timed." );
+			return;
+		}
+
+		Print( "%llu frames started late by:", static_cast<unsigned long long>( frameLateness.frames ) );
+
+		for ( int percentile : { 50, 90, 99 } )
+		{
+			Print( "  p%d: %s", percentile, Percentile( percentile ) );
+		}
+
+		Print( "  max: %.3f ms", std::chrono::duration<double, std::milli>( frameLateness.max ).count() );
+	}
+
+private:
+	static std::string Percentile( int percentile )
+	{
+		uint64_t rank = ( frameLateness.frames * percentile + 99 ) / 100;
+		uint64_t seen = 0;
+
+		for ( int i = 0; i < FRAME_LATENESS_BUCKETS; i++ )
+		{
+			seen += frameLateness.buckets[ i ];
+
+			if ( seen >= rank )
+			{
+				if ( i == FRAME_LATENESS_BUCKETS - 1 )
+				{
+					return Str::Format( "more than %.3f ms", i * FRAME_LATENESS_BUCKET_USEC / 1000.0 );
+				}
+
+				return Str::Format( "%.3f ms", ( i + 1 ) * FRAME_LATENESS_BUCKET_USEC / 1000.0 );
+			}
+		}
+
+		return "?";
+	}
+};
+static FrameTimingCmd frameTimingCmdRegistration;
+
 /*
 ==================
 SV_Frame
@@ -1309,6 +1412,7 @@ happen before SV_Frame is called
 */
 void SV_Frame( int msec )
 {
+	Profiler::Zone zone( "SV_Frame" );
 	int        frameMsec;
 	int        startTime;
 	int        frameStartTime = 0, frameEndTime;
@@ -4,6 +4,7 @@
 #include "qcommon/sys.h"
 #include "framework/CommonVMServices.h"
 #include "framework/CommandSystem.h"
+#include "framework/Profiler.h"
 
 #ifndef BUILD_SERVER
 #include "client/client.h" // For bot debug draw
@@ -292,7 +293,8 @@ void SV_InitGameProgs()
 	SV_InitGameVM();
 }
 
-GameVM::GameVM(): VM::VMBase("sgame", Cvar::NONE), services(nullptr) {
+GameVM::GameVM(): VM::VMBase("sgame", Cvar::NONE), services(nullptr), cmdBuffer("server") {
+	cmdBuffer.SetSyscallStats(&syscallStats);
 }
 
 void GameVM::Start()
@@ -330,6 +332,7 @@ void GameVM::GameShutdown(bool restart)
 		Log::Notice("Error while freeing sgame: %s", err.what());
 	}
 	services = nullptr;
+	cmdBuffer.Close();
 
 	// Release the shared memory region
 	this->shmRegion.Close();
@@ -375,7 +378,9 @@ void GameVM::GameClientThink(int clientNum)
 
 void GameVM::GameRunFrame(int levelTime)
 {
+	Profiler::Zone zone("GameRunFrame");
 	this->SendMsg<GameRunFrameMsg>(levelTime);
+	this->CountIPCFrame();
 }
 
 void GameVM::BotAIStartFrame(int)
@@ -390,6 +395,9 @@ void GameVM::Syscall(uint32_t id, Util::Reader reader, IPC::Channel& channel)
 	if (major == VM::QVM) {
 		this->QVMSyscall(minor, reader, channel);
 
+	} else if (major == VM::COMMAND_BUFFER) {
+		this->cmdBuffer.Syscall(minor, reader, channel);
+
     } else if (major < VM::LAST_COMMON_SYSCALL) {
         services->Syscall(major, minor, std::move(reader), channel);
 
@@ -398,6 +406,11 @@ void GameVM::Syscall(uint32_t id, Util::Reader reader, IPC::Channel& channel)
 	}
 }
 
+int GameVM::ConsumeCommandBuffer()
+{
+	return this->cmdBuffer.Consume();
+}
+
 void GameVM::QVMSyscall(int syscallNum, Util::Reader& reader, IPC::Channel& channel)
 {
 	switch (syscallNum) {
@@ -564,3 +577,42 @@ void GameVM::QVMSyscall(int syscallNum, Util::Reader& reader, IPC::Channel& chan
 		Sys::Drop("Bad game system trap: %d", syscallNum);
 	}
 }
+
+GameVM::CmdBuffer::CmdBuffer(std::string name): IPC::CommandBufferHost(name) {
+}
+
+void GameVM::CmdBuffer::HandleCommandBufferSyscall(int major, int minor, Util::Reader& reader) {
+	if (major != VM::QVM) {
+		Sys::Drop("Bad major sgame command buffer syscall number: %d", major);
+	}
+
+	switch (minor) {
+	case G_SEND_SERVER_COMMAND:
+		HandleMsg<BufferedServerCommandMsg>(std::move(reader), [](int clientNum, std::string text) {
+			SV_GameSendServerCommand(clientNum, text.c_str());
+		});
+		break;
+
+	case G_SET_CONFIGSTRING:
+		HandleMsg<SetConfigStringMsg>(std::move(reader), [](int index, std::string val) {
+			SV_SetConfigstring(index, val.c_str());
+		});
+		break;
+
+	case G_SET_USERINFO:
+		HandleMsg<SetUserinfoMsg>(std::move(reader), [](int index, std::string val) {
+			SV_SetUserinfo(index, val.c_str());
+		});
+		break;
+
+	case G_ADJUST_AREA_PORTAL_STATE:
+		HandleMsg<AdjustAreaPortalStateMsg>(std::move(reader), [](int entityNum, bool open) {
+			sharedEntity_t* ent = SV_GentityNum(entityNum);
+			CM_AdjustAreaPortalState(ent->r.areanum, ent->r.areanum2, open);
+		});
+		break;
+
+	default:
+		Sys::Drop("Bad sgame command buffer syscall minor number: %d", minor);
+	}
+}
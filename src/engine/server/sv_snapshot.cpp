@@ -1,5 +1,9 @@
 #include "server.h"
 #include "qcommon/sys.h"
+#include "framework/Profiler.h"
+#include "framework/WorkerPool.h"
+
+#include <bitset>
 
 /*
 =============================================================================
@@ -24,8 +28,126 @@ A server packet will look something like:
 */
 
 static Cvar::Cvar<bool> sv_novis("sv_novis", "skip PVS check when transmitting entities", 0, false);
+static Cvar::Range<Cvar::Cvar<int>> sv_snapshotThreads("sv_snapshotThreads",
+	"number of worker threads building and encoding client snapshots, 0 to do it on the main thread",
+	Cvar::NONE, 0, 0, 64);
+static Cvar::Cvar<bool> sv_snapshotDeltaCache("sv_snapshotDeltaCache",
+	"reuse the entity deltas encoded for other clients during the same frame",
+	Cvar::NONE, true);
+static Cvar::Cvar<bool> sv_snapshotIndex("sv_snapshotIndex",
+	"only test the entities linked in the PVS of a client for its snapshot, instead of all of them",
+	Cvar::NONE, true);
+
+// culling and delta encoding of the snapshots of different clients is independent,
+// only sending the resulting messages has to happen in order on the main thread
+static Sys::WorkerPool snapshotWorkers("snapshot");
 
 static Log::Logger bandwidthLog("server.bandwidth");
+static Log::Logger snapshotLog("server.snapshot");
+
+/*
+=============================================================================
+
+Encoded entity delta cache
+
+Clients that see the same entity and last acknowledged the same state of it,
+or start from its baseline, get exactly the same delta for it. The huffman
+tree of the messages being fixed, the bits the first of them encodes can be
+copied as they are into the messages of the others.
+
+=============================================================================
+*/
+
+#define MAX_CACHED_DELTAS_PER_ENTITY 4
+#define MAX_CACHED_DELTA_BYTES       1024
+
+struct entityDeltaCacheEntry_t
+{
+	entityState_t     from;
+	entityState_t     to;
+	bool              force;
+	int               bits;
+	int               uncompsize;
+	std::vector<byte> data;
+};
+
+struct entityDeltaCache_t
+{
+	std::mutex                           mutex;
+	int                                  frame = -1; // entries are only reused within a frame
+	std::vector<entityDeltaCacheEntry_t> entries;
+};
+
+static entityDeltaCache_t entityDeltaCaches[ MAX_GENTITIES ];
+static int                entityDeltaFrame;
+static std::atomic<int>   entityDeltaHits, entityDeltaMisses;
+
+/*
+=============
+SV_WriteDeltaEntity
+
+MSG_WriteDeltaEntity through the encoded delta cache, can be called by the
+snapshot workers.
+=============
+*/
+static void SV_WriteDeltaEntity( msg_t *msg, entityState_t *from, entityState_t *to, bool force )
+{
+	if ( !to || to->number < 0 || to->number >= MAX_GENTITIES || !sv_snapshotDeltaCache.Get() )
+	{
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	entityDeltaCache_t &cache = entityDeltaCaches[ to->number ];
+
+	{
+		std::lock_guard<std::mutex> lock( cache.mutex );
+
+		if ( cache.frame == entityDeltaFrame )
+		{
+			for ( const entityDeltaCacheEntry_t &entry : cache.entries )
+			{
+				if ( entry.force == force && !memcmp( &entry.from, from, sizeof( *from ) ) &&
+				     !memcmp( &entry.to, to, sizeof( *to ) ) )
+				{
+					MSG_WriteBitstream( msg, entry.data.data(), entry.bits, entry.uncompsize );
+					entityDeltaHits++;
+					return;
+				}
+			}
+		}
+	}
+
+	entityDeltaMisses++;
+
+	byte  buffer[ MAX_CACHED_DELTA_BYTES ];
+	msg_t delta;
+
+	MSG_Init( &delta, buffer, sizeof( buffer ) );
+	MSG_WriteDeltaEntity( &delta, from, to, force );
+
+	if ( delta.overflowed )
+	{
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	MSG_WriteBitstream( msg, buffer, delta.bit, delta.uncompsize );
+
+	std::lock_guard<std::mutex> lock( cache.mutex );
+
+	if ( cache.frame != entityDeltaFrame )
+	{
+		cache.frame = entityDeltaFrame;
+		cache.entries.clear();
+	}
+
+	if ( cache.entries.size() < MAX_CACHED_DELTAS_PER_ENTITY )
+	{
+		cache.entries.push_back( { *from, *to, force, delta.bit, delta.uncompsize,
+		                           std::vector<byte>( buffer, buffer + ( ( delta.bit + 7 ) >> 3 ) ) } );
+	}
+}
 
 /*
 =============
@@ -88,7 +210,7 @@ static void SV_EmitPacketEntities( const clientSnapshot_t *from, clientSnapshot_
 			// delta update from old position
 			// because the force parm is false, this will not result
 			// in any bytes being emitted if the entity has not changed at all
-			MSG_WriteDeltaEntity( msg, oldent, newent, false );
+			SV_WriteDeltaEntity( msg, oldent, newent, false );
 			oldindex++;
 			newindex++;
 			continue;
@@ -97,7 +219,7 @@ static void SV_EmitPacketEntities( const clientSnapshot_t *from, clientSnapshot_
 		if ( newnum < oldnum )
 		{
 			// this is a new entity, send it from the baseline
-			MSG_WriteDeltaEntity( msg, &sv.svEntities[ newnum ].baseline, newent, true );
+			SV_WriteDeltaEntity( msg, &sv.svEntities[ newnum ].baseline, newent, true );
 			newindex++;
 			continue;
 		}
@@ -105,7 +227,7 @@ static void SV_EmitPacketEntities( const clientSnapshot_t *from, clientSnapshot_
 		if ( newnum > oldnum )
 		{
 			// the old entity isn't present in the new message
-			MSG_WriteDeltaEntity( msg, oldent, nullptr, true );
+			SV_WriteDeltaEntity( msg, oldent, nullptr, true );
 			oldindex++;
 			continue;
 		}
@@ -247,10 +369,12 @@ Build a client snapshot structure
 //#define   MAX_SNAPSHOT_ENTITIES   1024
 static const int MAX_SNAPSHOT_ENTITIES = 2048;
 
+// per client snapshot state, so that the snapshots of several clients can be built at once
 struct snapshotEntityNumbers_t
 {
 	int numSnapshotEntities;
 	int snapshotEntities[ MAX_SNAPSHOT_ENTITIES ];
+	std::bitset<MAX_GENTITIES> added; // used to prevent double adding from portal views
 };
 
 /*
@@ -278,21 +402,35 @@ static int SV_QsortEntityNumbers( const void *a, const void *b )
 	return 1;
 }
 
+/*
+===============
+SV_EntityInSnapshot
+===============
+*/
+static bool SV_EntityInSnapshot( const sharedEntity_t *gEnt, const snapshotEntityNumbers_t *eNums )
+{
+	if ( gEnt->s.number < 0 || gEnt->s.number >= MAX_GENTITIES )
+	{
+		Sys::Drop( "SV_EntityInSnapshot: bad gEnt" );
+	}
+
+	return eNums->added[ gEnt->s.number ];
+}
+
 /*
 ===============
 SV_AddEntToSnapshot
 ===============
 */
-static void SV_AddEntToSnapshot( svEntity_t *svEnt, sharedEntity_t *gEnt,
-                                 snapshotEntityNumbers_t *eNums )
+static void SV_AddEntToSnapshot( sharedEntity_t *gEnt, snapshotEntityNumbers_t *eNums )
 {
 	// if we have already added this entity to this snapshot, don't add again
-	if ( svEnt->snapshotCounter == sv.snapshotCounter )
+	if ( SV_EntityInSnapshot( gEnt, eNums ) )
 	{
 		return;
 	}
 
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	eNums->added[ gEnt->s.number ] = true;
 
 	// if we are full, silently discard entities
 	if ( eNums->numSnapshotEntities == MAX_SNAPSHOT_ENTITIES )
@@ -306,309 +444,506 @@ static void SV_AddEntToSnapshot( svEntity_t *svEnt, sharedEntity_t *gEnt,
 
 /*
 ===============
-SV_AddEntitiesVisibleFromPoint
+SV_EntityIndexClusters
+
+Returns how an entity is to be filed in the cluster index: 0 if it is never
+sent, -1 if it must be tested whatever the client sees, or else the number
+of clusters written to clusters.
 ===============
 */
-static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *frame,
-//                                  snapshotEntityNumbers_t *eNums, bool portal, clientSnapshot_t *oldframe, bool localClient ) {
-//                                  snapshotEntityNumbers_t *eNums, bool portal ) {
-    snapshotEntityNumbers_t *eNums /*, bool portal, bool localClient */ )
+static int SV_EntityIndexClusters( const sharedEntity_t *ent, int numClusters, int *clusters )
 {
-	int            e, i;
-	sharedEntity_t *ent, *playerEnt;
-	svEntity_t     *svEnt;
-	int            l;
-	int            clientarea, clientcluster;
-	int            leafnum;
-//	int             c_fullsend;
-	byte           *clientpvs;
-	byte           *bitvector;
+	if ( !ent->r.linked || ( ent->r.svFlags & SVF_NOCLIENT ) )
+	{
+		return 0;
+	}
 
-	// during an error shutdown message we may need to transmit
-	// the shutdown message after the server has shutdown, so
-	// specifically check for it
-	if (sv.state == serverState_t::SS_DEAD)
+	if ( ent->r.svFlags & ( SVF_BROADCAST | SVF_CLIENTS_IN_RANGE ) )
 	{
-		return;
+		return -1;
 	}
 
-	leafnum = CM_PointLeafnum( origin );
-	clientarea = CM_LeafArea( leafnum );
-	clientcluster = CM_LeafCluster( leafnum );
+	if ( ent->r.svFlags & SVF_IGNOREBMODELEXTENTS )
+	{
+		if ( ent->r.originCluster < 0 || ent->r.originCluster >= numClusters )
+		{
+			return -1;
+		}
 
-	// calculate the visible areas
-	frame->areabytes = CM_WriteAreaBits( frame->areabits, clientarea );
+		clusters[ 0 ] = ent->r.originCluster;
+		return 1;
+	}
 
-	clientpvs = CM_ClusterPVS( clientcluster );
+	if ( !ent->r.numClusters )
+	{
+		return 0;
+	}
 
-//	c_fullsend = 0;
+	// overflowed cluster lists are rare enough to just always be tested
+	if ( ent->r.numClusters < 0 || ent->r.numClusters > MAX_ENT_CLUSTERS || ent->r.lastCluster )
+	{
+		return -1;
+	}
 
-	playerEnt = SV_GentityNum( frame->ps.clientNum );
+	for ( int i = 0; i < ent->r.numClusters; i++ )
+	{
+		if ( ent->r.clusternums[ i ] < 0 || ent->r.clusternums[ i ] >= numClusters )
+		{
+			return -1;
+		}
 
-	if ( playerEnt->r.svFlags & SVF_SELF_PORTAL )
+		clusters[ i ] = ent->r.clusternums[ i ];
+	}
+
+	return ent->r.numClusters;
+}
+
+/*
+===============
+SV_UpdateEntityIndex
+
+Entities are linked by the game in shared memory, so the cluster index is
+brought up to date by comparing every entity with where it was filed before
+building the snapshots of a frame.
+===============
+*/
+void SV_UpdateEntityIndex()
+{
+	if ( sv.state == serverState_t::SS_DEAD || !sv.gentities )
 	{
-		SV_AddEntitiesVisibleFromPoint( playerEnt->s.origin2, frame, eNums );
+		return;
 	}
 
-	for ( e = 0; e < sv.num_entities; e++ )
+	int numClusters = CM_NumClusters();
+
+	if ( int( sv.clusterEntities.size() ) != numClusters )
 	{
-		ent = SV_GentityNum( e );
+		// new map, start over
+		sv.clusterEntities.assign( numClusters, {} );
+		memset( sv.alwaysCheckedEntities, 0, sizeof( sv.alwaysCheckedEntities ) );
 
-		// never send entities that aren't linked in
-		if ( !ent->r.linked )
+		for ( svEntity_t &svEnt : sv.svEntities )
 		{
-			continue;
+			svEnt.numIndexClusters = 0;
 		}
 
-		if ( ent->s.number != e )
+		sv.numIndexedEntities = 0;
+	}
+
+	int numEntities = std::max( sv.numIndexedEntities, sv.num_entities );
+
+	for ( int e = 0; e < numEntities; e++ )
+	{
+		svEntity_t *svEnt = &sv.svEntities[ e ];
+		int        clusters[ MAX_ENT_CLUSTERS ];
+		int        numFiled = 0;
+
+		if ( e < sv.num_entities )
 		{
-			Log::Debug( "FIXING ENT->S.NUMBER!!!" );
-			ent->s.number = e;
+			numFiled = SV_EntityIndexClusters( SV_GentityNum( e ), numClusters, clusters );
 		}
 
-		// entities can be flagged to explicitly not be sent to the client
-		if ( ent->r.svFlags & SVF_NOCLIENT )
+		if ( numFiled == svEnt->numIndexClusters &&
+		     ( numFiled <= 0 || !memcmp( clusters, svEnt->indexClusters, numFiled * sizeof( int ) ) ) )
 		{
 			continue;
 		}
 
-		// entities can be flagged to be sent to only one client
-		if ( ent->r.svFlags & SVF_SINGLECLIENT )
+		// unfile it from where it was
+		if ( svEnt->numIndexClusters < 0 )
 		{
-			if ( ent->r.singleClient != frame->ps.clientNum )
-			{
-				continue;
-			}
+			sv.alwaysCheckedEntities[ e >> 6 ] &= ~( uint64_t( 1 ) << ( e & 63 ) );
 		}
 
-		// entities can be flagged to be sent to everyone but one client
-		if ( ent->r.svFlags & SVF_NOTSINGLECLIENT )
+		for ( int i = 0; i < svEnt->numIndexClusters; i++ )
 		{
-			if ( ent->r.singleClient == frame->ps.clientNum )
+			std::vector<int> &list = sv.clusterEntities[ svEnt->indexClusters[ i ] ];
+			auto it = std::find( list.begin(), list.end(), e );
+
+			if ( it != list.end() )
 			{
-				continue;
+				*it = list.back();
+				list.pop_back();
 			}
 		}
 
-		// entities can be flagged to be sent to only a given mask of clients
-		if ( ent->r.svFlags & SVF_CLIENTMASK )
+		// and file it where it is now
+		if ( numFiled < 0 )
 		{
-			if ( frame->ps.clientNum >= 32 )
-			{
-				if ( ~ent->r.hiMask & ( 1 << ( frame->ps.clientNum - 32 ) ) )
-				{
-					continue;
-				}
-			}
-			else
+			sv.alwaysCheckedEntities[ e >> 6 ] |= uint64_t( 1 ) << ( e & 63 );
+		}
+
+		for ( int i = 0; i < numFiled; i++ )
+		{
+			std::vector<int> &list = sv.clusterEntities[ clusters[ i ] ];
+
+			if ( std::find( list.begin(), list.end(), e ) == list.end() )
 			{
-				if ( ~ent->r.loMask & ( 1 << frame->ps.clientNum ) )
-				{
-					continue;
-				}
+				list.push_back( e );
 			}
 		}
 
-		svEnt = SV_SvEntityForGentity( ent );
+		svEnt->numIndexClusters = numFiled;
+		std::copy_n( clusters, std::max( numFiled, 0 ), svEnt->indexClusters );
+	}
+
+	sv.numIndexedEntities = sv.num_entities;
+}
+
+static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *frame, snapshotEntityNumbers_t *eNums );
+
+/*
+===============
+SV_AddEntityIfVisible
+===============
+*/
+static void SV_AddEntityIfVisible( int e, vec3_t origin, clientSnapshot_t *frame, snapshotEntityNumbers_t *eNums,
+                                   int clientarea, const byte *clientpvs, const sharedEntity_t *playerEnt )
+{
+	int            i;
+	sharedEntity_t *ent;
+	int            l;
+	const byte     *bitvector;
+
+	ent = SV_GentityNum( e );
 
-		// don't double add an entity through portals
-		if ( svEnt->snapshotCounter == sv.snapshotCounter )
+	// never send entities that aren't linked in
+	if ( !ent->r.linked )
+	{
+		return;
+	}
+
+	if ( ent->s.number != e )
+	{
+		Log::Debug( "FIXING ENT->S.NUMBER!!!" );
+		ent->s.number = e;
+	}
+
+	// entities can be flagged to explicitly not be sent to the client
+	if ( ent->r.svFlags & SVF_NOCLIENT )
+	{
+		return;
+	}
+
+	// entities can be flagged to be sent to only one client
+	if ( ent->r.svFlags & SVF_SINGLECLIENT )
+	{
+		if ( ent->r.singleClient != frame->ps.clientNum )
 		{
-			continue;
+			return;
 		}
+	}
 
-		if ( sv_novis.Get() )
+	// entities can be flagged to be sent to everyone but one client
+	if ( ent->r.svFlags & SVF_NOTSINGLECLIENT )
+	{
+		if ( ent->r.singleClient == frame->ps.clientNum )
 		{
-			SV_AddEntToSnapshot( svEnt, ent, eNums );
-			continue;
+			return;
 		}
+	}
 
-		// broadcast entities are always sent
-		if ( ent->r.svFlags & SVF_BROADCAST )
+	// entities can be flagged to be sent to only a given mask of clients
+	if ( ent->r.svFlags & SVF_CLIENTMASK )
+	{
+		if ( frame->ps.clientNum >= 32 )
 		{
-			SV_AddEntToSnapshot( svEnt, ent, eNums );
-			continue;
+			if ( ~ent->r.hiMask & ( 1 << ( frame->ps.clientNum - 32 ) ) )
+			{
+				return;
+			}
 		}
+		else
+		{
+			if ( ~ent->r.loMask & ( 1 << frame->ps.clientNum ) )
+			{
+				return;
+			}
+		}
+	}
+
+	// don't double add an entity through portals
+	if ( eNums->added[ e ] )
+	{
+		return;
+	}
+
+	if ( sv_novis.Get() )
+	{
+		SV_AddEntToSnapshot( ent, eNums );
+		return;
+	}
+
+	// broadcast entities are always sent
+	if ( ent->r.svFlags & SVF_BROADCAST )
+	{
+		SV_AddEntToSnapshot( ent, eNums );
+		return;
+	}
 
-		// send entity if the client is in range
-		if ( (ent->r.svFlags & SVF_CLIENTS_IN_RANGE) &&
-		     Distance( ent->s.origin, playerEnt->s.origin ) <= ent->r.clientRadius )
+	// send entity if the client is in range
+	if ( (ent->r.svFlags & SVF_CLIENTS_IN_RANGE) &&
+	     Distance( ent->s.origin, playerEnt->s.origin ) <= ent->r.clientRadius )
+	{
+		SV_AddEntToSnapshot( ent, eNums );
+		return;
+	}
+
+	bitvector = clientpvs;
+
+	// Gordon: just check origin for being in pvs, ignore bmodel extents
+	if ( ent->r.svFlags & SVF_IGNOREBMODELEXTENTS )
+	{
+		if ( bitvector[ ent->r.originCluster >> 3 ] & ( 1 << ( ent->r.originCluster & 7 ) ) )
 		{
-			SV_AddEntToSnapshot( svEnt, ent, eNums );
-			continue;
+			SV_AddEntToSnapshot( ent, eNums );
 		}
 
-		bitvector = clientpvs;
+		return;
+	}
 
-		// Gordon: just check origin for being in pvs, ignore bmodel extents
-		if ( ent->r.svFlags & SVF_IGNOREBMODELEXTENTS )
+	// ignore if not touching a PV leaf
+	// check area
+	if ( !CM_AreasConnected( clientarea, ent->r.areanum ) )
+	{
+		// doors can legally straddle two areas, so
+		// we may need to check another one
+		if ( !CM_AreasConnected( clientarea, ent->r.areanum2 ) )
 		{
-			if ( bitvector[ ent->r.originCluster >> 3 ] & ( 1 << ( ent->r.originCluster & 7 ) ) )
-			{
-				SV_AddEntToSnapshot( svEnt, ent, eNums );
-			}
+			return;
+		}
+	}
 
-			continue;
+	// check individual leafs
+	if ( !ent->r.numClusters )
+	{
+		return;
+	}
+
+	l = 0;
+
+	for ( i = 0; i < std::min(std::max(0, ent->r.numClusters), MAX_ENT_CLUSTERS); i++ )
+	{
+		l = ent->r.clusternums[ i ];
+
+		if ( bitvector[ l >> 3 ] & ( 1 << ( l & 7 ) ) )
+		{
+			break;
 		}
+	}
 
-		// ignore if not touching a PV leaf
-		// check area
-		if ( !CM_AreasConnected( clientarea, ent->r.areanum ) )
+	// if we haven't found it to be visible,
+	// check the overflow clusters that couldn't be stored
+	if ( i == ent->r.numClusters )
+	{
+		if ( ent->r.lastCluster )
 		{
-			// doors can legally straddle two areas, so
-			// we may need to check another one
-			if ( !CM_AreasConnected( clientarea, ent->r.areanum2 ) )
+			for ( ; l <= ent->r.lastCluster; l++ )
 			{
-				continue;
+				if ( bitvector[ l >> 3 ] & ( 1 << ( l & 7 ) ) )
+				{
+					break;
+				}
 			}
-		}
 
-		// check individual leafs
-		if ( !ent->r.numClusters )
+			if ( l == ent->r.lastCluster )
+			{
+				return;
+			}
+		}
+		else
 		{
-			continue;
+			return;
 		}
+	}
 
-		l = 0;
+	//----(SA) added "visibility dummies"
+	if ( ent->r.svFlags & SVF_VISDUMMY )
+	{
+		sharedEntity_t *ment = nullptr;
 
-		for ( i = 0; i < std::min(std::max(0, ent->r.numClusters), MAX_ENT_CLUSTERS); i++ )
-		{
-			l = ent->r.clusternums[ i ];
+		//find master;
+		ment = SV_GentityNum( ent->s.otherEntityNum );
 
-			if ( bitvector[ l >> 3 ] & ( 1 << ( l & 7 ) ) )
+		if ( ment )
+		{
+			if ( SV_EntityInSnapshot( ment, eNums ) || !ment->r.linked )
 			{
-				break;
+				return;
 			}
+
+			SV_AddEntToSnapshot( ment, eNums );
 		}
 
-		// if we haven't found it to be visible,
-		// check the overflow clusters that couldn't be stored
-		if ( i == ent->r.numClusters )
+		return; // master needs to be added, but not this dummy ent
+	}
+	//----(SA) end
+	else if ( ent->r.svFlags & SVF_VISDUMMY_MULTIPLE )
+	{
 		{
-			if ( ent->r.lastCluster )
+			int            h;
+			sharedEntity_t *ment = nullptr;
+
+			for ( h = 0; h < sv.num_entities; h++ )
 			{
-				for ( ; l <= ent->r.lastCluster; l++ )
+				ment = SV_GentityNum( h );
+
+				if ( ment == ent || !ment )
+				{
+					continue;
+				}
+
+				if ( !( ment->r.linked ) )
+				{
+					continue;
+				}
+
+				if ( ment->s.number != h )
 				{
-					if ( bitvector[ l >> 3 ] & ( 1 << ( l & 7 ) ) )
-					{
-						break;
-					}
+					Log::Debug( "FIXING vis dummy multiple ment->S.NUMBER!!!" );
+					ment->s.number = h;
 				}
 
-				if ( l == ent->r.lastCluster )
+				if ( ment->r.svFlags & SVF_NOCLIENT )
 				{
 					continue;
 				}
+
+				if ( eNums->added[ h ] )
+				{
+					continue;
+				}
+
+				if ( ment->s.otherEntityNum == ent->s.number )
+				{
+					SV_AddEntToSnapshot( ment, eNums );
+				}
 			}
-			else
+
+			return;
+		}
+	}
+
+	// add it
+	SV_AddEntToSnapshot( ent, eNums );
+
+	// if it's a portal entity, add everything visible from its camera position
+	if ( ent->r.svFlags & SVF_PORTAL )
+	{
+		if ( ent->s.generic1 )
+		{
+			vec3_t dir;
+			VectorSubtract( ent->s.origin, origin, dir );
+
+			if ( VectorLengthSquared( dir ) > ( float ) ent->s.generic1 * ent->s.generic1 )
 			{
-				continue;
+				return;
 			}
 		}
 
-		//----(SA) added "visibility dummies"
-		if ( ent->r.svFlags & SVF_VISDUMMY )
-		{
-			sharedEntity_t *ment = nullptr;
+//          SV_AddEntitiesVisibleFromPoint( ent->s.origin2, frame, eNums, true, oldframe, localClient );
+		SV_AddEntitiesVisibleFromPoint( ent->s.origin2, frame, eNums /*, true, localClient */ );
+	}
+}
 
-			//find master;
-			ment = SV_GentityNum( ent->s.otherEntityNum );
+/*
+===============
+SV_AddEntitiesVisibleFromPoint
+===============
+*/
+static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *frame,
+//                                  snapshotEntityNumbers_t *eNums, bool portal, clientSnapshot_t *oldframe, bool localClient ) {
+//                                  snapshotEntityNumbers_t *eNums, bool portal ) {
+    snapshotEntityNumbers_t *eNums /*, bool portal, bool localClient */ )
+{
+	int            e;
+	sharedEntity_t *playerEnt;
+	int            clientarea, clientcluster;
+	int            leafnum;
+//	int             c_fullsend;
+	byte           *clientpvs;
 
-			if ( ment )
-			{
-				svEntity_t *master = nullptr;
+	// during an error shutdown message we may need to transmit
+	// the shutdown message after the server has shutdown, so
+	// specifically check for it
+	if (sv.state == serverState_t::SS_DEAD)
+	{
+		return;
+	}
 
-				master = SV_SvEntityForGentity( ment );
+	leafnum = CM_PointLeafnum( origin );
+	clientarea = CM_LeafArea( leafnum );
+	clientcluster = CM_LeafCluster( leafnum );
 
-				if ( master->snapshotCounter == sv.snapshotCounter || !ment->r.linked )
-				{
-					continue;
-				}
+	// calculate the visible areas
+	frame->areabytes = CM_WriteAreaBits( frame->areabits, clientarea );
 
-				SV_AddEntToSnapshot( master, ment, eNums );
-			}
+	clientpvs = CM_ClusterPVS( clientcluster );
+
+//	c_fullsend = 0;
+
+	playerEnt = SV_GentityNum( frame->ps.clientNum );
+
+	if ( playerEnt->r.svFlags & SVF_SELF_PORTAL )
+	{
+		SV_AddEntitiesVisibleFromPoint( playerEnt->s.origin2, frame, eNums );
+	}
 
-			continue; // master needs to be added, but not this dummy ent
+	if ( sv_novis.Get() || !sv_snapshotIndex.Get() )
+	{
+		for ( e = 0; e < sv.num_entities; e++ )
+		{
+			SV_AddEntityIfVisible( e, origin, frame, eNums, clientarea, clientpvs, playerEnt );
 		}
-		//----(SA) end
-		else if ( ent->r.svFlags & SVF_VISDUMMY_MULTIPLE )
+
+		return;
+	}
+
+	// only look at the entities filed in the clusters of our PVS, plus the
+	// ones that need to be checked anyway, still in increasing number order
+	// so that portals are merged exactly like with the full scan
+	uint64_t candidates[ ENTITY_MASK_WORDS ];
+	memcpy( candidates, sv.alwaysCheckedEntities, sizeof( candidates ) );
+
+	int numClusters = sv.clusterEntities.size();
+
+	for ( int c = 0; c < numClusters; c += 8 )
+	{
+		int visible = clientpvs[ c >> 3 ];
+
+		while ( visible )
 		{
-			{
-				int            h;
-				sharedEntity_t *ment = nullptr;
-				svEntity_t     *master = nullptr;
+			int cluster = c + CountTrailingZeroes( static_cast<unsigned>( visible ) );
+			visible &= visible - 1;
 
-				for ( h = 0; h < sv.num_entities; h++ )
-				{
-					ment = SV_GentityNum( h );
-
-					if ( ment == ent )
-					{
-						continue;
-					}
-
-					if ( ment )
-					{
-						master = SV_SvEntityForGentity( ment );
-					}
-					else
-					{
-						continue;
-					}
-
-					if ( !( ment->r.linked ) )
-					{
-						continue;
-					}
-
-					if ( ment->s.number != h )
-					{
-						Log::Debug( "FIXING vis dummy multiple ment->S.NUMBER!!!" );
-						ment->s.number = h;
-					}
-
-					if ( ment->r.svFlags & SVF_NOCLIENT )
-					{
-						continue;
-					}
-
-					if ( master->snapshotCounter == sv.snapshotCounter )
-					{
-						continue;
-					}
-
-					if ( ment->s.otherEntityNum == ent->s.number )
-					{
-						SV_AddEntToSnapshot( master, ment, eNums );
-					}
-				}
+			if ( cluster >= numClusters )
+			{
+				break;
+			}
 
-				continue;
+			for ( int num : sv.clusterEntities[ cluster ] )
+			{
+				candidates[ num >> 6 ] |= uint64_t( 1 ) << ( num & 63 );
 			}
 		}
+	}
 
-		// add it
-		SV_AddEntToSnapshot( svEnt, ent, eNums );
+	for ( int word = 0; word < ENTITY_MASK_WORDS; word++ )
+	{
+		uint64_t bits = candidates[ word ];
 
-		// if it's a portal entity, add everything visible from its camera position
-		if ( ent->r.svFlags & SVF_PORTAL )
+		while ( bits )
 		{
-			if ( ent->s.generic1 )
-			{
-				vec3_t dir;
-				VectorSubtract( ent->s.origin, origin, dir );
+			e = word * 64 + CountTrailingZeroes( static_cast<unsigned long long>( bits ) );
+			bits &= bits - 1;
 
-				if ( VectorLengthSquared( dir ) > ( float ) ent->s.generic1 * ent->s.generic1 )
-				{
-					continue;
-				}
+			if ( e >= sv.num_entities )
+			{
+				return;
 			}
 
-//          SV_AddEntitiesVisibleFromPoint( ent->s.origin2, frame, eNums, true, oldframe, localClient );
-			SV_AddEntitiesVisibleFromPoint( ent->s.origin2, frame, eNums /*, true, localClient */ );
+			SV_AddEntityIfVisible( e, origin, frame, eNums, clientarea, clientpvs, playerEnt );
 		}
-
-		continue;
 	}
 }
 
@@ -627,24 +962,22 @@ For viewing through other player's eyes, clent can be something other than clien
 */
 static void SV_BuildClientSnapshot( client_t *client )
 {
+	Profiler::Zone zone( "SV_BuildClientSnapshot" );
 	vec3_t                  org;
 	clientSnapshot_t        *frame;
 	snapshotEntityNumbers_t entityNumbers;
 	int                     i;
 	sharedEntity_t          *ent;
-	entityState_t           *state;
-	svEntity_t              *svEnt;
 	sharedEntity_t          *clent;
 	int                     clientNum;
-
-	// bump the counter used to prevent double adding
-	sv.snapshotCounter++;
+	int                     firstEntity;
 
 	// this is the frame we are creating
 	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
 
 	// clear everything in this snapshot
 	entityNumbers.numSnapshotEntities = 0;
+	entityNumbers.added.reset();
 	memset( frame->areabits, 0, sizeof( frame->areabits ) );
 
 	// show_bug.cgi?id=62
@@ -670,9 +1003,7 @@ static void SV_BuildClientSnapshot( client_t *client )
 		Sys::Drop( "SV_SvEntityForGentity: bad gEnt" );
 	}
 
-	svEnt = &sv.svEntities[ clientNum ];
-
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	entityNumbers.added[ clientNum ] = true;
 
 	if ( clent->r.svFlags & SVF_SELF_PORTAL_EXCLUSIVE )
 	{
@@ -704,24 +1035,24 @@ static void SV_BuildClientSnapshot( client_t *client )
 		( ( int * ) frame->areabits ) [ i ] = ( ( int * ) frame->areabits ) [ i ] ^ -1;
 	}
 
+	// reserve our range of the circular entity buffer, other clients
+	// may be building their snapshots at the same time
+	firstEntity = svs.nextSnapshotEntities.fetch_add( entityNumbers.numSnapshotEntities );
+
+	// this should never hit, map should always be restarted first in SV_Frame
+	if ( firstEntity + entityNumbers.numSnapshotEntities >= 0x7FFFFFFE )
+	{
+		Sys::Error( "svs.nextSnapshotEntities wrapped" );
+	}
+
 	// copy the entity states out
-	frame->num_entities = 0;
-	frame->first_entity = svs.nextSnapshotEntities;
+	frame->first_entity = firstEntity;
+	frame->num_entities = entityNumbers.numSnapshotEntities;
 
 	for ( i = 0; i < entityNumbers.numSnapshotEntities; i++ )
 	{
 		ent = SV_GentityNum( entityNumbers.snapshotEntities[ i ] );
-		state = &svs.snapshotEntities[ svs.nextSnapshotEntities % svs.numSnapshotEntities ];
-		*state = ent->s;
-		svs.nextSnapshotEntities++;
-
-		// this should never hit, map should always be restarted first in SV_Frame
-		if ( svs.nextSnapshotEntities >= 0x7FFFFFFE )
-		{
-			Sys::Error( "svs.nextSnapshotEntities wrapped" );
-		}
-
-		frame->num_entities++;
+		svs.snapshotEntities[ ( firstEntity + i ) % svs.numSnapshotEntities ] = ent->s;
 	}
 }
 
@@ -886,6 +1217,61 @@ void SV_SendClientIdle( client_t *client )
 	sv.ubpsTotalBytes += msg.uncompsize / 8; // NERVE - SMF - net debugging
 }
 
+/*
+=======================
+SV_WriteClientSnapshot
+
+Writes everything but the download data of a snapshot message.
+Only touches the state of this client, so it may run on a snapshot worker.
+=======================
+*/
+static void SV_WriteClientSnapshot( client_t *client, msg_t *msg )
+{
+	Profiler::Zone zone( "SV_WriteClientSnapshot" );
+
+	// NOTE, MRE: all server->client messages now acknowledge
+	// let the client know which reliable clientCommands we have received
+	MSG_WriteLong( msg, client->lastClientCommand );
+
+	// (re)send any reliable server commands
+	SV_UpdateServerCommandsToClient( client, msg );
+
+	// send over all the relevant entityState_t
+	// and the playerState_t
+	SV_WriteSnapshotToClient( client, msg );
+}
+
+/*
+=======================
+SV_FinishClientSnapshot
+
+Completes a message started by SV_WriteClientSnapshot and sends it,
+must be called on the main thread.
+=======================
+*/
+static void SV_FinishClientSnapshot( client_t *client, msg_t *msg )
+{
+	Profiler::Zone zone( "SV_FinishClientSnapshot" );
+
+	// Add any download data if the client is downloading
+	SV_WriteDownloadToClient( client, msg );
+
+	// check for overflow
+	if ( msg->overflowed )
+	{
+		Log::Warn("msg overflowed for %s", client->name );
+		MSG_Clear( msg );
+
+		SV_DropClient( client, "Msg overflowed" );
+		return;
+	}
+
+	SV_SendMessageToClient( msg, client );
+
+	sv.bpsTotalBytes += msg->cursize; // NERVE - SMF - net debugging
+	sv.ubpsTotalBytes += msg->uncompsize / 8; // NERVE - SMF - net debugging
+}
+
 /*
 =======================
 SV_SendClientSnapshot
@@ -923,34 +1309,50 @@ void SV_SendClientSnapshot( client_t *client )
 
 	MSG_Init( &msg, msg_buf, sizeof( msg_buf ) );
 
-	// NOTE, MRE: all server->client messages now acknowledge
-	// let the client know which reliable clientCommands we have received
-	MSG_WriteLong( &msg, client->lastClientCommand );
+	SV_WriteClientSnapshot( client, &msg );
 
-	// (re)send any reliable server commands
-	SV_UpdateServerCommandsToClient( client, &msg );
+	SV_FinishClientSnapshot( client, &msg );
+}
 
-	// send over all the relevant entityState_t
-	// and the playerState_t
-	SV_WriteSnapshotToClient( client, &msg );
+/*
+=======================
+SV_SendClientSnapshots
 
-	// Add any download data if the client is downloading
-	SV_WriteDownloadToClient( client, &msg );
+Builds and encodes the snapshots of several clients on the snapshot
+workers, then sends them in order.
+=======================
+*/
+static void SV_SendClientSnapshots( const std::vector<client_t *> &clients )
+{
+	static std::vector<byte> msgBuffers;
 
-	// check for overflow
-	if ( msg.overflowed )
+	if ( msgBuffers.size() < clients.size() * MAX_MSGLEN )
 	{
-		Log::Warn("msg overflowed for %s", client->name );
-		MSG_Clear( &msg );
+		msgBuffers.resize( clients.size() * MAX_MSGLEN );
+	}
 
-		SV_DropClient( client, "Msg overflowed" );
-		return;
+	std::vector<msg_t> msgs( clients.size() );
+
+	for ( size_t i = 0; i < clients.size(); i++ )
+	{
+		MSG_Init( &msgs[ i ], &msgBuffers[ i * MAX_MSGLEN ], MAX_MSGLEN );
 	}
 
-	SV_SendMessageToClient( &msg, client );
+	// a client's old frame can only be delta'd from once every client has
+	// reserved its entities, as the new ones may overwrite it
+	snapshotWorkers.ParallelFor( clients.size(), [&clients]( int i ) {
+		SV_BuildClientSnapshot( clients[ i ] );
+	} );
 
-	sv.bpsTotalBytes += msg.cursize; // NERVE - SMF - net debugging
-	sv.ubpsTotalBytes += msg.uncompsize / 8; // NERVE - SMF - net debugging
+	snapshotWorkers.ParallelFor( clients.size(), [&clients, &msgs]( int i ) {
+		SV_WriteClientSnapshot( clients[ i ], &msgs[ i ] );
+		MSG_FlushFieldUses();
+	} );
+
+	for ( size_t i = 0; i < clients.size(); i++ )
+	{
+		SV_FinishClientSnapshot( clients[ i ], &msgs[ i ] );
+	}
 }
 
 /*
@@ -961,8 +1363,10 @@ SV_SendClientMessages
 
 void SV_SendClientMessages()
 {
+	Profiler::Zone zone( "SV_SendClientMessages" );
 	client_t *c;
 	int      numclients = 0; // NERVE - SMF - net debugging
+	static std::vector<client_t *> snapshotClients;
 
 	sv.bpsTotalBytes = 0; // NERVE - SMF - net debugging
 	sv.ubpsTotalBytes = 0; // NERVE - SMF - net debugging
@@ -970,6 +1374,19 @@ void SV_SendClientMessages()
 	// Gordon: update any changed configstrings from this frame
 	SV_UpdateConfigStrings();
 
+	auto snapshotStart = Sys::SteadyClock::now();
+
+	// forget the entity deltas of the last frame
+	entityDeltaFrame++;
+
+	SV_UpdateEntityIndex();
+
+	snapshotWorkers.SetNumThreads( sv_snapshotThreads.Get() );
+	snapshotClients.clear();
+
+	// the snapshots of all the clients leave in as few system calls as possible
+	NET_BeginSendBatch();
+
 	// send a message to each connected client
 	for ( int i = 0; i < sv_maxClients.Get(); i++ )
 	{
@@ -1006,9 +1423,46 @@ void SV_SendClientMessages()
 		}
 
 		// generate and send a new message
-		SV_SendClientSnapshot( c );
+		if ( !snapshotWorkers.GetNumThreads() || ( c->state < clientState_t::CS_ACTIVE && c->state != clientState_t::CS_ZOMBIE ) )
+		{
+			SV_SendClientSnapshot( c );
+			continue;
+		}
+
+		snapshotClients.push_back( c );
 	}
 
+	SV_SendClientSnapshots( snapshotClients );
+
+	NET_FlushSendBatch();
+
+	snapshotLog.DoDebugCode( [numclients, snapshotStart] {
+		static int frames = 0;
+		static Sys::SteadyClock::duration total{};
+
+		if ( numclients <= 0 )
+		{
+			return;
+		}
+
+		total += Sys::SteadyClock::now() - snapshotStart;
+
+		if ( ++frames >= MAX_BPS_WINDOW )
+		{
+			auto usec = std::chrono::duration_cast<std::chrono::microseconds>( total ).count();
+
+			int hits = entityDeltaHits.exchange( 0 );
+			int misses = entityDeltaMisses.exchange( 0 );
+
+			snapshotLog.Debug( "snapshots: %.3f ms/frame for %d clients (%s), %d%% of entity deltas reused",
+			                   usec / 1000.0 / frames, numclients,
+			                   sv_novis.Get() || !sv_snapshotIndex.Get() ? "all entities" : "cluster index",
+			                   hits + misses ? 100 * hits / ( hits + misses ) : 0 );
+			frames = 0;
+			total = {};
+		}
+	});
+
 	// NERVE - SMF - net debugging
 	bandwidthLog.DoDebugCode( [numclients] {
 		if ( numclients <= 0 )
@@ -80,6 +80,10 @@ namespace IPC {
             Sys::Drop("Command buffer %s: handles sent to the command buffer", name);
         }
 
+        if (!initialized) {
+            Init();
+        }
+
         buffer.LoadReaderData();
         if (!buffer.CanWrite(totalSize)) {
             logs.Debug("Message of size %i(+4) for %s doesn't fit the remaining %i, flushing.", dataSize, name, buffer.GetMaxWriteLength());
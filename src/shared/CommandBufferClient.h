@@ -58,6 +58,9 @@ namespace IPC {
                 Write(writer);
             }
 
+            // The engine handles the buffer before anything else the VM
+            // sends on the socket and when a call into the VM returns, so
+            // this is only needed to have the messages handled right away.
             void TryFlush();
 
         private:
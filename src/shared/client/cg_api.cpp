@@ -84,11 +84,44 @@ void trap_GetCurrentSnapshotNumber( int *snapshotNumber, int *serverTime )
 	VM::SendMsg<GetCurrentSnapshotNumberMsg>(*snapshotNumber, *serverTime);
 }
 
-bool trap_GetSnapshot( int snapshotNumber, ipcSnapshot_t *snapshot )
+// The snapshot ring is handled here, the engine only sees it through CG_GETSHAREDSNAPSHOT
+static IPC::SharedMemory snapshotRing;
+
+const sharedSnapshot_t *trap_GetSharedSnapshot( int snapshotNumber, std::vector<std::string> &serverCommands )
 {
+	if (!snapshotRing) {
+		snapshotRing = IPC::SharedMemory::Create(sizeof(sharedSnapshot_t) * SNAPSHOT_RING_SLOTS);
+		VM::SendMsg<LocateSnapshotRingMsg>(snapshotRing);
+	}
+
 	bool res;
-	VM::SendMsg<GetSnapshotMsg>(snapshotNumber, res, *snapshot);
-	return res;
+	VM::SendMsg<GetSharedSnapshotMsg>(snapshotNumber, res, serverCommands);
+	if (!res) {
+		return nullptr;
+	}
+
+	auto *ring = static_cast<const sharedSnapshot_t*>(snapshotRing.GetBase());
+	const sharedSnapshot_t *snapshot = &ring[snapshotNumber & (SNAPSHOT_RING_SLOTS - 1)];
+	if (snapshot->messageNum != snapshotNumber || snapshot->numEntities < 0 || snapshot->numEntities > MAX_GENTITIES) {
+		Sys::Drop("trap_GetSharedSnapshot: invalid snapshot %d", snapshotNumber);
+	}
+	return snapshot;
+}
+
+bool trap_GetSnapshot( int snapshotNumber, ipcSnapshot_t *snapshot )
+{
+	const sharedSnapshot_t *shared = trap_GetSharedSnapshot(snapshotNumber, snapshot->b.serverCommands);
+	if (!shared) {
+		return false;
+	}
+
+	snapshot->b.snapFlags = shared->snapFlags;
+	snapshot->b.ping = shared->ping;
+	snapshot->b.serverTime = shared->serverTime;
+	memcpy(snapshot->b.areamask, shared->areamask, sizeof(snapshot->b.areamask));
+	snapshot->ps = shared->ps;
+	snapshot->b.entities.assign(shared->entities, shared->entities + shared->numEntities);
+	return true;
 }
 
 int trap_GetCurrentCmdNumber()
@@ -344,8 +377,7 @@ void trap_R_AddPolyToScene( qhandle_t hShader, int numVerts, const polyVert_t *v
 		return;
 	}
 
-	std::vector<polyVert_t> myverts(verts, verts + numVerts);
-	cmdBuffer.SendMsg<Render::AddPolyToSceneMsg>(hShader, myverts);
+	cmdBuffer.SendMsg<Render::AddPolyToSceneMsg>(hShader, Util::ArrayView<polyVert_t>(verts, numVerts));
 }
 
 void trap_R_AddPolysToScene( qhandle_t hShader, int numVerts, const polyVert_t *verts, int numPolys )
@@ -357,9 +389,7 @@ void trap_R_AddPolysToScene( qhandle_t hShader, int numVerts, const polyVert_t *
 		return;
 	}
 
-	std::vector<polyVert_t> myverts(verts, verts + size);
-
-	cmdBuffer.SendMsg<Render::AddPolysToSceneMsg>(hShader, myverts, numVerts, numPolys);
+	cmdBuffer.SendMsg<Render::AddPolysToSceneMsg>(hShader, Util::ArrayView<polyVert_t>(verts, size), numVerts, numPolys);
 }
 
 void trap_R_Add2dPolysIndexedToScene( const polyVert_t* polys, int numPolys, const int* indexes, int numIndexes, int trans_x, int trans_y, qhandle_t shader )
@@ -369,9 +399,7 @@ void trap_R_Add2dPolysIndexedToScene( const polyVert_t* polys, int numPolys, con
 		return;
 	}
 
-	std::vector<polyVert_t> mypolys(polys, polys + numPolys);
-	std::vector<int> myindices(indexes, indexes + numIndexes);
-	cmdBuffer.SendMsg<Render::Add2dPolysIndexedMsg>(mypolys, numPolys, myindices, numIndexes, trans_x, trans_y, shader);
+	cmdBuffer.SendMsg<Render::Add2dPolysIndexedMsg>(Util::ArrayView<polyVert_t>(polys, numPolys), numPolys, Util::ArrayView<int>(indexes, numIndexes), numIndexes, trans_x, trans_y, shader);
 }
 
 // Used exclusively for RmlUI's transformations. Other usecases might
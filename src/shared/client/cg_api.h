@@ -86,7 +86,10 @@ int             trap_R_LerpTag( orientation_t *tag, const refEntity_t *refent, c
 void            trap_R_GetTextureSize( qhandle_t handle, int *x, int *y );
 qhandle_t       trap_R_GenerateTexture( const byte *data, int x, int y );
 void            trap_GetCurrentSnapshotNumber( int *snapshotNumber, int *serverTime );
+// Copies the entities out of the shared ring, kept for the cgames that have not moved to trap_GetSharedSnapshot
 bool        trap_GetSnapshot( int snapshotNumber, ipcSnapshot_t *snapshot );
+// The snapshot stays valid until SNAPSHOT_RING_SLOTS more have been requested, null if it is not available
+const sharedSnapshot_t *trap_GetSharedSnapshot( int snapshotNumber, std::vector<std::string> &serverCommands );
 int             trap_GetCurrentCmdNumber();
 bool        trap_GetUserCmd( int cmdNumber, usercmd_t *ucmd );
 void            trap_SetUserCmdValue( int stateValue, int flags, float sensitivityScale );
@@ -30,9 +30,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <engine/server/sg_msgdef.h>
 #include <shared/VMMain.h>
+#include <shared/CommandBufferClient.h>
 
 IPC::SharedMemory shmRegion;
 
+// Buffers the one-way calls made during a frame, the engine handles them
+// before the next message it gets on the socket
+static IPC::CommandBufferClient cmdBuffer("sgame");
+
 // Definition of the VM->Engine calls
 
 // The actual shared memory region is handled in this file, and is pretty much invisible to the rest of the code
@@ -59,12 +64,12 @@ void trap_SendServerCommand(int clientNum, const char *text)
         return;
     }
 
-    VM::SendMsg<SendServerCommandMsg>(clientNum, text);
+    cmdBuffer.SendMsg<BufferedServerCommandMsg>(clientNum, text);
 }
 
 void trap_SetConfigstring(int num, const char *string)
 {
-    VM::SendMsg<SetConfigStringMsg>(num, string);
+    cmdBuffer.SendMsg<SetConfigStringMsg>(num, string);
 }
 
 void trap_GetConfigstring(int num, char *buffer, int bufferSize)
@@ -81,7 +86,7 @@ void trap_SetConfigstringRestrictions(int, const clientList_t*)
 
 void trap_SetUserinfo(int num, const char *buffer)
 {
-    VM::SendMsg<SetUserinfoMsg>(num, buffer);
+    cmdBuffer.SendMsg<SetUserinfoMsg>(num, buffer);
 }
 
 void trap_GetUserinfo(int num, char *buffer, int bufferSize)